@@ -54,6 +54,15 @@ public:
                                                   boost::asio::placeholders::error ) );
   }
   
+  /**
+   * Destructor - the file descriptor isn't closed, it still belongs to its
+   * owner, e.g. the ZMQ socket.
+   */
+  ~AsyncSocket()
+  {
+    subscriber_socket.release();
+  }
+  
 private:
   /**
    * The function that gets called by BOOST::ASIO each time new data is 
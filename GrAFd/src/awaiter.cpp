@@ -0,0 +1,102 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "awaiter.hpp"
+
+#include <memory>
+
+#include "logger.hpp"
+#include "message.hpp"
+
+Awaiter::Awaiter( boost::asio::io_service& io_service, zmq::context_t& context, 
+                  const std::string& endpoint, const resume_t& resume )
+: io_service( io_service ), resume( resume ), requests( context, ZMQ_REQ ), outstanding( false )
+{
+  requests.connect( endpoint.c_str() );
+}
+
+void Awaiter::await( LogicEngine* le, const await_t& wait )
+{
+  switch( wait.kind )
+  {
+    case await_t::TIMER:
+      {
+        typedef boost::asio::basic_waitable_timer< std::chrono::steady_clock > timer_t;
+        std::shared_ptr<timer_t> timer( new timer_t( io_service, wait.delay ) );
+        timer->async_wait( [this, timer, le]( const boost::system::error_code& error ){
+          if( boost::asio::error::operation_aborted != error )
+            resume( le );
+        });
+      }
+      break;
+      
+    case await_t::MESSAGE:
+      {
+        request_t request = { le, wait.target, wait.value };
+        io_service.post( [this, request](){
+          queue.push_back( request );
+          sendNext();
+        });
+      }
+      break;
+  }
+}
+
+void Awaiter::sendNext( void )
+{
+  if( outstanding || queue.empty() )
+    return;
+  
+  if( !replies )
+  {
+    int fd;
+    size_t fdSize = sizeof( fd );
+    requests.getsockopt( ZMQ_FD, &fd, &fdSize );
+    replies.reset( new AsyncSocket( io_service, fd, [this](){ handleReplies(); } ) );
+  }
+  
+  const request_t& request = queue.front();
+  logger( Logger::ALL ) << "sending to '" << request.target << "' the value '" << request.value.getAsString() << "';\n";
+  logger.show();
+  LogicMessage msg( request.target, "NoSrc", request.value );
+  msg.send( requests );
+  outstanding = true;
+  
+  // the socket signals only changes, so a reply that is already there has
+  // to be read now
+  handleReplies();
+}
+
+void Awaiter::handleReplies( void )
+{
+  while( outstanding )
+  {
+    uint32_t events;
+    size_t eventsSize = sizeof( events );
+    requests.getsockopt( ZMQ_EVENTS, &events, &eventsSize );
+    if( !( events & ZMQ_POLLIN ) )
+      return;
+    
+    LogicMessage reply = recieveMessage( requests );
+    LogicEngine* le = queue.front().le;
+    queue.pop_front();
+    outstanding = false;
+    resume( le );
+    sendNext();
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AWAITER_HPP
+#define AWAITER_HPP
+
+#include <deque>
+#include <string>
+#include <functional>
+#include <boost/asio.hpp>
+
+#include "globals.h"
+#include "asyncsocket.hpp"
+#include "logicengine.hpp"
+
+/**
+ * The Awaiter does the waiting of the elements for the LogicEngines that
+ * are suspended meanwhile, see LogicEngine::setAwaitHandler(). A timer or
+ * the reply to a message is awaited on the io_service and the LogicEngine
+ * is queued to the worker again afterwards. So no thread of the worker is
+ * blocked by a waiting logic.
+ */
+class Awaiter
+{
+public:
+  typedef LogicElement_Generic::await_t await_t;
+  
+  /**
+   * The function that continues the run of a LogicEngine, e.g. by queuing
+   * it to the worker.
+   */
+  typedef std::function<void( LogicEngine* )> resume_t;
+  
+  /**
+   * Constructor - the messages are sent by a REQ socket of its own that is
+   * connected to the logicd at @p endpoint, its replies are handled by the
+   * @p io_service. The LogicEngines are passed to @p resume when their wait
+   * is over.
+   */
+  Awaiter( boost::asio::io_service& io_service, zmq::context_t& context, 
+           const std::string& endpoint, const resume_t& resume );
+  Awaiter( const Awaiter& ) = delete; // no copy
+  
+  /**
+   * Wait for @p wait and continue the LogicEngine @p le afterwards.
+   * This is the awaitHandler of the LogicEngines, it may be called by any
+   * thread.
+   */
+  void await( LogicEngine* le, const await_t& wait );
+  
+private:
+  /**
+   * A message that is waiting to be sent.
+   */
+  struct request_t
+  {
+    LogicEngine* le;
+    std::string target;
+    variable_t value;
+  };
+  
+  boost::asio::io_service& io_service;
+  const resume_t resume;
+  
+  /**
+   * The socket of the requests - not shared with the elements that send
+   * by waiting for the reply in calc(), as a ZMQ socket may only be used by
+   * one thread at a time.
+   * NOTE: only used in the thread of the io_service.
+   */
+  zmq::socket_t requests;
+  
+  /**
+   * The messages to send, the first one is waiting for its reply when
+   * outstanding. A REQ socket allows only one request at a time.
+   * NOTE: only used in the thread of the io_service.
+   */
+  std::deque<request_t> queue;
+  bool outstanding;
+  
+  /**
+   * The reply handling, created at the first request.
+   */
+  std::unique_ptr<AsyncSocket> replies;
+  
+  /**
+   * Send the first message of the queue when there is no outstanding one.
+   */
+  void sendNext( void );
+  
+  /**
+   * Read the available replies and continue their LogicEngines.
+   */
+  void handleReplies( void );
+};
+
+#endif // AWAITER_HPP
@@ -0,0 +1,503 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchengine.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "json.hpp"
+#include "logicengine.hpp"
+#include "logic_elements/logicelement_generic.hpp"
+
+/**
+ * The number of instances that are processed by one SIMD vector.
+ * NOTE: the vectors are 32 bytes - AVX2 when available, otherwise the
+ * compiler uses two SSE registers.
+ */
+static const size_t vectorLanes = 8;
+
+typedef int   vint   __attribute__(( vector_size( 4 * vectorLanes ) ));
+typedef float vfloat __attribute__(( vector_size( 4 * vectorLanes ) ));
+
+/**
+ * The SIMD vector of the type T.
+ */
+template<typename T> struct simd;
+template<> struct simd<int  > { typedef vint   type; };
+template<> struct simd<float> { typedef vfloat type; };
+
+/**
+ * The operations of the kernels, they work on the SIMD vectors as well as on
+ * single values.
+ */
+struct Sum    { template<typename V> static V apply( const V& a, const V& b ) { return a + b; } };
+struct Mul    { template<typename V> static V apply( const V& a, const V& b ) { return a * b; } };
+struct MulAdd { template<typename V> static V apply( const V& o, const V& a, const V& b ) { return o + a * b; } };
+struct MulSub { template<typename V> static V apply( const V& o, const V& a, const V& b ) { return o - a * b; } };
+
+// a vector comparison is -1 for true, so "& 1" makes it the same as for
+// single values
+#define RELATION( name, op ) \
+  struct name { template<typename V> static auto apply( const V& a, const V& b ) -> decltype( ( a op b ) & 1 ) { return ( a op b ) & 1; } };
+RELATION( Equal       , == )
+RELATION( NotEqual    , != )
+RELATION( Less        , <  )
+RELATION( LessEqual   , <= )
+RELATION( Greater     , >  )
+RELATION( GreaterEqual, >= )
+#undef RELATION
+
+/**
+ * The kernels that run one instruction for all instances or, when there's a
+ * mask, only for the instances in it. The 4 byte types use SIMD vectors,
+ * a masked vector keeps the old values of the waiting instances.
+ */
+class Kernels
+{
+  raw_t *const store;
+  const size_t width;
+  const int *const mask;
+  
+  template<typename V, typename T>
+  static V load( const T* source )
+  {
+    V value;
+    std::memcpy( &value, source, sizeof( value ) );
+    return value;
+  }
+  
+  template<typename V, typename T>
+  static void save( T* target, const V& value )
+  {
+    std::memcpy( target, &value, sizeof( value ) );
+  }
+  
+  /**
+   * Save the vector @p value to the entries @p i and on of the column
+   * @p target, only for the instances in the mask.
+   */
+  template<typename V, typename T>
+  void put( T* target, const V& value, size_t i ) const
+  {
+    if( nullptr == mask )
+      save( target + i, value );
+    else
+    {
+      const vint keep = load<vint>( mask + i );
+      save( target + i, ( load<vint>( &value ) & keep ) | ( load<vint>( target + i ) & ~keep ) );
+    }
+  }
+  
+  /**
+   * Return if the @p instance runs.
+   */
+  bool active( size_t instance ) const
+  {
+    return nullptr == mask || 0 != mask[ instance ];
+  }
+  
+  /**
+   * Return the column of the 4 byte variable at @p operand.
+   */
+  template<typename T>
+  T* column( const ByteCode::operand_t& operand ) const
+  {
+    return reinterpret_cast<T*>( store + BatchEngine::position( operand.offset, 0, width ) );
+  }
+  
+public:
+  Kernels( raw_t *const _store, size_t _width, const int *const _mask ) 
+  : store( _store ), width( _width ), mask( _mask )
+  {}
+  
+  /**
+   * Return the variable at @p operand of the @p instance.
+   */
+  template<typename T>
+  T& at( const ByteCode::operand_t& operand, size_t instance ) const
+  {
+    return *reinterpret_cast<T*>( store + BatchEngine::position( operand.offset, instance, width ) );
+  }
+  
+  /**
+   * out = value
+   */
+  template<typename T>
+  void fill( const ByteCode::operand_t& out, const T value ) const
+  {
+    for( size_t i = 0; i < width; ++i )
+      if( active( i ) )
+        at<T>( out, i ) = value;
+  }
+  
+  /**
+   * out = in
+   */
+  template<typename T>
+  void move( const ByteCode::operand_t& out, const ByteCode::operand_t& in ) const
+  {
+    typedef typename simd<int>::type V;
+    if( 4 == sizeof( T ) )
+    {
+      T* const o = column<T>( out );
+      const T* const a = column<T>( in );
+      if( nullptr == mask )
+        std::memcpy( o, a, width * sizeof( T ) );
+      else
+        for( size_t i = 0; i < width; i += vectorLanes )
+          put( o, load<V>( a + i ), i );
+    }
+    else
+      for( size_t i = 0; i < width; ++i )
+        if( active( i ) )
+          at<T>( out, i ) = at<T>( in, i );
+  }
+  
+  /**
+   * out = Op( in1, in2 )
+   */
+  template<typename Tout, typename Tin, typename Op>
+  void binary( const ByteCode::operand_t& out, const ByteCode::operand_t& in1, const ByteCode::operand_t& in2 ) const
+  {
+    typedef typename simd<Tin>::type V;
+    if( 4 == sizeof( Tout ) )
+    {
+      Tout* const o = column<Tout>( out );
+      const Tin* const a = column<Tin>( in1 );
+      const Tin* const b = column<Tin>( in2 );
+      for( size_t i = 0; i < width; i += vectorLanes )
+        put( o, Op::apply( load<V>( a + i ), load<V>( b + i ) ), i );
+    }
+    else
+      for( size_t i = 0; i < width; ++i )
+        if( active( i ) )
+          at<Tout>( out, i ) = Op::apply( at<Tin>( in1, i ), at<Tin>( in2, i ) );
+  }
+  
+  /**
+   * out = Op( in, value )
+   */
+  template<typename T, typename Op>
+  void immediate( const ByteCode::operand_t& out, const ByteCode::operand_t& in, const T value ) const
+  {
+    typedef typename simd<T>::type V;
+    V constant;
+    for( size_t lane = 0; lane < vectorLanes; ++lane )
+      constant[ lane ] = value;
+    T* const o = column<T>( out );
+    const T* const a = column<T>( in );
+    for( size_t i = 0; i < width; i += vectorLanes )
+      put( o, Op::apply( load<V>( a + i ), constant ), i );
+  }
+  
+  /**
+   * out = Op( out, in1, in2 )
+   */
+  template<typename T, typename Op>
+  void update( const ByteCode::operand_t& out, const ByteCode::operand_t& in1, const ByteCode::operand_t& in2 ) const
+  {
+    typedef typename simd<T>::type V;
+    T* const o = column<T>( out );
+    const T* const a = column<T>( in1 );
+    const T* const b = column<T>( in2 );
+    for( size_t i = 0; i < width; i += vectorLanes )
+      put( o, Op::apply( load<V>( o + i ), load<V>( a + i ), load<V>( b + i ) ), i );
+  }
+  
+  /**
+   * out = in1 <relation> in2 for the REL opcode @p rel, counted from
+   * REL_EQUAL_BOOL_INT.
+   */
+  template<typename Op>
+  void relation( const int rel, const ByteCode::operand_t& out, const ByteCode::operand_t& in1, const ByteCode::operand_t& in2 ) const
+  {
+    // the layout of the opcodes is described at ByteCode::opcode_t
+    switch( rel % 4 )
+    {
+      case 0: binary<bool, int  , Op>( out, in1, in2 ); break;
+      case 1: binary<bool, float, Op>( out, in1, in2 ); break;
+      case 2: binary<int , int  , Op>( out, in1, in2 ); break;
+      case 3: binary<int , float, Op>( out, in1, in2 ); break;
+    }
+  }
+  
+  /**
+   * out = in1 <relation> in2 for the REL opcode @p rel, counted from
+   * REL_EQUAL_BOOL_INT.
+   */
+  void relation( const int rel, const ByteCode::operand_t& out, const ByteCode::operand_t& in1, const ByteCode::operand_t& in2 ) const
+  {
+    switch( rel / 4 )
+    {
+      case 0: relation<Equal       >( rel, out, in1, in2 ); break;
+      case 1: relation<NotEqual    >( rel, out, in1, in2 ); break;
+      case 2: relation<Less        >( rel, out, in1, in2 ); break;
+      case 3: relation<LessEqual   >( rel, out, in1, in2 ); break;
+      case 4: relation<Greater     >( rel, out, in1, in2 ); break;
+      case 5: relation<GreaterEqual>( rel, out, in1, in2 ); break;
+    }
+  }
+};
+
+BatchEngine::BatchEngine( const LogicEngine& prototype, size_t _instances )
+: code(),
+  elements( prototype.elementList ),
+  mainTask( prototype.mainTask - prototype.elementList ),
+  instances( _instances ),
+  width( ( _instances + vectorLanes - 1 ) / vectorLanes * vectorLanes ),
+  variableSize( ( prototype.variableCount + 3 ) & ~3 )
+{
+  for( auto it = prototype.variableRegistry.cbegin(); it != prototype.variableRegistry.cend(); ++it )
+  {
+    if( ( variableType::INT == it->second.type || variableType::FLOAT == it->second.type ) && 0 != it->second.offset % 4 )
+      throw( JSON::parseError( "BatchEngine: variable '" + it->first + "' isn't aligned!", __LINE__ ,__FILE__ ) );
+  }
+  
+  code.compile( prototype.elementList, prototype.elementCount );
+  
+  store   = new raw_t[ variableSize * width ];
+  scratch = new raw_t[ variableSize ];
+  mask    = new int[ width ]();
+  next.resize( instances );
+  
+  // every instance starts with the variables of the prototype
+  for( size_t word = 0; word < variableSize; word += 4 )
+    for( size_t i = 0; i < width; ++i )
+      std::memcpy( store + position( word, i ), prototype.globVar + word, 
+                   std::min<size_t>( 4, prototype.variableCount - word ) );
+}
+
+BatchEngine::~BatchEngine()
+{
+  delete[] store;
+  delete[] scratch;
+  delete[] mask;
+}
+
+void BatchEngine::execute( size_t index, size_t end )
+{
+  bool together  = true;     // no mask needed while all run
+  size_t waiting = SIZE_MAX; // the smallest index of the waiting instances
+  std::fill( next.begin(), next.end(), index );
+  
+  while( index < end )
+  {
+    const Kernels kernels( store, width, together ? nullptr : mask );
+    const ByteCode::instruction_t& ins = code[ index ];
+    const size_t target = index + ins.a.jump;
+    size_t following    = index + 1;
+    
+    switch( ins.op )
+    {
+      case ByteCode::END:
+      case ByteCode::RETURN:
+      case ByteCode::STOP:
+        following = SIZE_MAX;
+        break;
+        
+      case ByteCode::CALL:
+      case ByteCode::AWAIT:
+        following = call( index, together );
+        break;
+        
+      case ByteCode::JUMP:
+        following = target;
+        break;
+        
+      case ByteCode::JUMPTRUE_BOOL:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<bool>( ins.b, i ) > 0; } );
+        break;
+        
+      case ByteCode::JUMPTRUE_INT:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<int >( ins.b, i ) > 0; } );
+        break;
+        
+      case ByteCode::JUMPZERO_BOOL:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<bool>( ins.b, i ) == 0; } );
+        break;
+        
+      case ByteCode::JUMPZERO_INT:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<int >( ins.b, i ) == 0; } );
+        break;
+        
+      case ByteCode::JUMPEQUAL_INT:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<int  >( ins.b, i ) == kernels.at<int  >( ins.c, i ); } );
+        break;
+        
+      case ByteCode::JUMPEQUAL_FLOAT:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<float>( ins.b, i ) == kernels.at<float>( ins.c, i ); } );
+        break;
+        
+      case ByteCode::JUMPNOTEQUAL_INT:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<int  >( ins.b, i ) != kernels.at<int  >( ins.c, i ); } );
+        break;
+        
+      case ByteCode::JUMPNOTEQUAL_FLOAT:
+        following = branch( following, target, together, [&]( size_t i ){ return kernels.at<float>( ins.b, i ) != kernels.at<float>( ins.c, i ); } );
+        break;
+        
+      case ByteCode::CONST_BOOL:   kernels.fill<bool >( ins.a, ins.b.i ); break;
+      case ByteCode::CONST_INT:    kernels.fill<int  >( ins.a, ins.b.i ); break;
+      case ByteCode::CONST_FLOAT:  kernels.fill<float>( ins.a, ins.b.f ); break;
+      
+      case ByteCode::MOVE_BOOL:    kernels.move<bool >( ins.a, ins.b ); break;
+      case ByteCode::MOVE_INT:     kernels.move<int  >( ins.a, ins.b ); break;
+      case ByteCode::MOVE_FLOAT:   kernels.move<float>( ins.a, ins.b ); break;
+      
+      case ByteCode::SUM_INT:      kernels.binary<int  , int  , Sum>( ins.a, ins.b, ins.c ); break;
+      case ByteCode::SUM_FLOAT:    kernels.binary<float, float, Sum>( ins.a, ins.b, ins.c ); break;
+      case ByteCode::MUL_INT:      kernels.binary<int  , int  , Mul>( ins.a, ins.b, ins.c ); break;
+      case ByteCode::MUL_FLOAT:    kernels.binary<float, float, Mul>( ins.a, ins.b, ins.c ); break;
+      
+      case ByteCode::MULADD_INT:   kernels.update<int  , MulAdd>( ins.a, ins.b, ins.c ); break;
+      case ByteCode::MULADD_FLOAT: kernels.update<float, MulAdd>( ins.a, ins.b, ins.c ); break;
+      case ByteCode::MULSUB_INT:   kernels.update<int  , MulSub>( ins.a, ins.b, ins.c ); break;
+      case ByteCode::MULSUB_FLOAT: kernels.update<float, MulSub>( ins.a, ins.b, ins.c ); break;
+      
+      case ByteCode::SUMCONST_INT:   kernels.immediate<int  , Sum>( ins.a, ins.b, ins.c.i ); break;
+      case ByteCode::SUMCONST_FLOAT: kernels.immediate<float, Sum>( ins.a, ins.b, ins.c.f ); break;
+      case ByteCode::MULCONST_INT:   kernels.immediate<int  , Mul>( ins.a, ins.b, ins.c.i ); break;
+      case ByteCode::MULCONST_FLOAT: kernels.immediate<float, Mul>( ins.a, ins.b, ins.c.f ); break;
+      
+      case ByteCode::MOVE2_BOOL:   kernels.move<bool >( ins.a, ins.b ); kernels.move<bool >( ins.c, ins.d ); break;
+      case ByteCode::MOVE2_INT:    kernels.move<int  >( ins.a, ins.b ); kernels.move<int  >( ins.c, ins.d ); break;
+      case ByteCode::MOVE2_FLOAT:  kernels.move<float>( ins.a, ins.b ); kernels.move<float>( ins.c, ins.d ); break;
+      
+      case ByteCode::MULSUM_INT:
+        kernels.binary<int  , int  , Mul>( ins.e, ins.b, ins.c );
+        kernels.binary<int  , int  , Sum>( ins.a, ins.e, ins.d );
+        break;
+        
+      case ByteCode::MULSUM_FLOAT:
+        kernels.binary<float, float, Mul>( ins.e, ins.b, ins.c );
+        kernels.binary<float, float, Sum>( ins.a, ins.e, ins.d );
+        break;
+        
+      default:
+        if( ByteCode::REL_EQUAL_BOOL_INT <= ins.op && ins.op <= ByteCode::REL_GREATEREQUAL_INT_FLOAT )
+        {
+          kernels.relation( ins.op - ByteCode::REL_EQUAL_BOOL_INT, ins.a, ins.b, ins.c );
+        }
+        else if( ByteCode::RELJUMP_EQUAL_BOOL_INT <= ins.op && ins.op <= ByteCode::RELJUMP_GREATEREQUAL_INT_FLOAT )
+        {
+          const int relation = ins.op - ByteCode::RELJUMP_EQUAL_BOOL_INT;
+          kernels.relation( relation, ins.d, ins.b, ins.c );
+          if( relation & 2 )
+            following = branch( following, target, together, [&]( size_t i ){ return kernels.at<int >( ins.d, i ) > 0; } );
+          else
+            following = branch( following, target, together, [&]( size_t i ){ return kernels.at<bool>( ins.d, i ) > 0; } );
+        }
+        else
+          throw( JSON::parseError( std::string( "BatchEngine: opcode " ) + ByteCode::opcodeName[ ins.op ] + " not supported!", __LINE__ ,__FILE__ ) );
+    }
+    
+    if( split != following && following < waiting )
+    {
+      // the next of the running instances is only written when needed
+      index = following;
+      continue;
+    }
+    
+    // the running instances move on, the ones at the smallest index run next
+    if( split != following )
+      for( size_t i = 0; i < instances; ++i )
+        if( running( i, together ) )
+          next[ i ] = following;
+    index = join( together, waiting );
+  }
+}
+
+size_t BatchEngine::join( bool& together, size_t& waiting )
+{
+  const size_t index = *std::min_element( next.cbegin(), next.cend() );
+  size_t count = 0;
+  waiting = SIZE_MAX;
+  for( size_t i = 0; i < instances; ++i )
+  {
+    mask[ i ] = index == next[ i ] ? -1 : 0;
+    if( index == next[ i ] )
+      ++count;
+    else
+      waiting = std::min( waiting, next[ i ] );
+  }
+  together = instances == count;
+  return index;
+}
+
+template<typename Condition>
+size_t BatchEngine::branch( size_t following, size_t target, bool together, Condition condition )
+{
+  // the padding of the columns isn't checked, it follows the others
+  size_t count = instances, taken = 0;
+  if( together )
+    for( size_t i = 0; i < instances; ++i )
+      taken += condition( i );
+  else
+  {
+    count = 0;
+    for( size_t i = 0; i < instances; ++i )
+      if( 0 != mask[ i ] )
+      {
+        ++count;
+        taken += condition( i );
+      }
+  }
+  
+  if( 0 == taken )
+    return following;
+  if( count == taken )
+    return target;
+  
+  // the instances disagree
+  for( size_t i = 0; i < instances; ++i )
+    if( running( i, together ) )
+      next[ i ] = condition( i ) ? target : following;
+  return split;
+}
+
+size_t BatchEngine::call( size_t index, bool together )
+{
+  typedef LogicElement_Generic::iterator iterator;
+  size_t following = split;
+  bool agree = true;
+  
+  for( size_t i = 0; i < instances; ++i )
+  {
+    if( !running( i, together ) )
+      continue;
+    
+    for( size_t word = 0; word < variableSize; word += 4 )
+      std::memcpy( scratch + word, store + position( word, i ), 4 );
+    
+    iterator& ip = reinterpret_cast<iterator*>( scratch )[0];
+    ip = elements + index;
+    elements[ index ]->calc( scratch );
+    next[ i ] = ( reinterpret_cast<iterator>( SIZE_MAX ) == ip ) ? SIZE_MAX : ip - elements;
+    
+    for( size_t word = 0; word < variableSize; word += 4 )
+      std::memcpy( store + position( word, i ), scratch + word, 4 );
+    
+    agree = agree && ( split == following || following == next[ i ] );
+    following = next[ i ];
+  }
+  
+  return agree ? following : split;
+}
@@ -0,0 +1,245 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCHENGINE_HPP
+#define BATCHENGINE_HPP
+
+#include <string>
+#include <vector>
+
+#include "globals.h"
+#include "bytecode.hpp"
+
+class LogicEngine;
+class LogicElement_Generic;
+
+/**
+ * The BatchEngine runs many instances of the same logic at once.
+ * 
+ * The logic of a prototype LogicEngine is used for all instances, each
+ * instance has its own variables. The variables are stored as structure of
+ * arrays: each 4 byte word of the variable store of the prototype becomes a
+ * column with one entry for each instance. So each instruction runs as a
+ * SIMD kernel over all instances.
+ * Each instance has its own instruction index. At a jump where the
+ * instances disagree they are split: always the instances with the
+ * smallest index run - masked, so the others keep their values - while the
+ * others wait, till they reach the same index and run together again, e.g.
+ * after an if/else or a loop. Elements without an opcode are called for
+ * each running instance with its variables copied to a scratch store.
+ * 
+ * NOTE: the int and float variables of the logic must be aligned to 4 bytes.
+ */
+class BatchEngine
+{
+public:
+  /**
+   * Constructor.
+   * 
+   * Create @p instances of the logic in @p prototype, each with the current
+   * values of the variables in @p prototype (so it should be initialized
+   * already). The @p prototype must live as long as the BatchEngine as its
+   * elements are used.
+   */
+  BatchEngine( const LogicEngine& prototype, size_t instances );
+  BatchEngine( const BatchEngine& ) = delete; // no copy
+  
+  /**
+   * Destructor.
+   */
+  ~BatchEngine();
+  
+  /**
+   * Return the number of instances.
+   */
+  size_t size( void ) const
+  {
+    return instances;
+  }
+  
+  /**
+   * Return the variable at @p offset of the @p instance.
+   */
+  template<typename T>
+  T read( size_t instance, const raw_offset_t offset ) const
+  {
+    return *reinterpret_cast<const T*>( store + position( offset, instance ) );
+  }
+  
+  /**
+   * Write the variable at @p offset of the @p instance with @p value.
+   */
+  template<typename T>
+  void write( size_t instance, const raw_offset_t offset, const T& value )
+  {
+    *reinterpret_cast<T*>( store + position( offset, instance ) ) = value;
+  }
+  
+  /**
+   * Copy the @p size bytes of the variable at @p offset of the @p instance
+   * to @p target.
+   */
+  void read( size_t instance, const raw_offset_t offset, raw_t* target, size_t size ) const
+  {
+    for( size_t i = 0; i < size; ++i )
+      target[ i ] = store[ position( offset + i, instance ) ];
+  }
+  
+  /**
+   * Copy the @p size bytes at @p source to the variable at @p offset of the
+   * @p instance.
+   */
+  void write( size_t instance, const raw_offset_t offset, const raw_t* source, size_t size )
+  {
+    for( size_t i = 0; i < size; ++i )
+      store[ position( offset + i, instance ) ] = source[ i ];
+  }
+  
+  /**
+   * Return the position in a store with @p width entries in each column of
+   * the variable at @p offset of the @p instance.
+   */
+  static size_t position( const raw_offset_t offset, size_t instance, size_t width )
+  {
+    return (offset & ~3) * width + 4 * instance + (offset & 3);
+  }
+  
+  /**
+   * Run the main task of all instances.
+   */
+  void run( void )
+  {
+    execute( mainTask, code.size() );
+  }
+  
+  /**
+   * Run the initialisation instructions of all instances.
+   */
+  void run_init( void )
+  {
+    execute( 0, mainTask );
+  }
+  
+private:
+  /**
+   * The instructions of the logic.
+   */
+  ByteCode code;
+  
+  /**
+   * The elements of the prototype, needed for CALL.
+   */
+  LogicElement_Generic** elements;
+  
+  /**
+   * Index of the first instruction of the main task.
+   */
+  size_t mainTask;
+  
+  /**
+   * The number of instances.
+   */
+  size_t instances;
+  
+  /**
+   * The number of entries in each column, i.e. the instances rounded up to
+   * a full SIMD vector.
+   */
+  size_t width;
+  
+  /**
+   * The size of the variable store of one instance, rounded up to words.
+   */
+  size_t variableSize;
+  
+  /**
+   * The variables of all instances, @p width times @p variableSize bytes.
+   */
+  raw_t *store;
+  
+  /**
+   * The variables of one instance for calling an element.
+   */
+  raw_t *scratch;
+  
+  /**
+   * The index of the next instruction of each instance, SIZE_MAX when it
+   * has finished.
+   */
+  std::vector<size_t> next;
+  
+  /**
+   * The column that is -1 for each instance that runs and 0 for each that
+   * waits, only valid while the instances are split.
+   */
+  int *mask;
+  
+  /**
+   * Return the position in the store of the variable at @p offset of the
+   * @p instance.
+   */
+  size_t position( const raw_offset_t offset, size_t instance ) const
+  {
+    return position( offset, instance, width );
+  }
+  
+  /**
+   * Marker of the running instances continuing at different indices, each
+   * at its entry in next.
+   */
+  static const size_t split = SIZE_MAX - 1;
+  
+  /**
+   * Return if the @p instance runs - all do when the instances are
+   * @p together, otherwise the ones in the mask.
+   */
+  bool running( size_t instance, bool together ) const
+  {
+    return together || 0 != mask[ instance ];
+  }
+  
+  /**
+   * Run the instructions from index @p start till one before index @p end
+   * for all instances.
+   */
+  void execute( size_t start, size_t end );
+  
+  /**
+   * Return the smallest index of the instances and put the ones at it into
+   * the mask, @p together is set when that are all, otherwise @p waiting to
+   * the smallest index of the others.
+   */
+  size_t join( bool& together, size_t& waiting );
+  
+  /**
+   * Continue at index @p following or at the jump @p target depending on
+   * the @p condition of each running instance.
+   * @return the index to continue or split when the instances disagree
+   */
+  template<typename Condition>
+  size_t branch( size_t following, size_t target, bool together, Condition condition );
+  
+  /**
+   * Call the element at @p index for each running instance.
+   * @return the index to continue, SIZE_MAX when the logic stopped or
+   *         split when the instances disagree
+   */
+  size_t call( size_t index, bool together );
+};
+
+#endif // BATCHENGINE_HPP
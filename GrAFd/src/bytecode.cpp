@@ -0,0 +1,375 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bytecode.hpp"
+
+#include <cstdint>
+#include <climits>
+#include <iostream>
+#include <iomanip>
+
+#include "logic_elements/logicelement_generic.hpp"
+
+const char *const ByteCode::opcodeName[ OPCODE_COUNT ] = {
+  "END", "RETURN", "CALL", "AWAIT", "STOP", "JUMP",
+  "JUMPTRUE_BOOL", "JUMPTRUE_INT", "JUMPZERO_BOOL", "JUMPZERO_INT",
+  "JUMPEQUAL_INT", "JUMPEQUAL_FLOAT", "JUMPNOTEQUAL_INT", "JUMPNOTEQUAL_FLOAT",
+  "CONST_BOOL", "CONST_INT", "CONST_FLOAT",
+  "MOVE_BOOL", "MOVE_INT", "MOVE_FLOAT",
+  "SUM_INT", "SUM_FLOAT", "MUL_INT", "MUL_FLOAT",
+  "MULADD_INT", "MULADD_FLOAT", "MULSUB_INT", "MULSUB_FLOAT",
+  "SUMCONST_INT", "SUMCONST_FLOAT", "MULCONST_INT", "MULCONST_FLOAT",
+  "REL_EQUAL_BOOL_INT",        "REL_EQUAL_BOOL_FLOAT",
+  "REL_EQUAL_INT_INT",         "REL_EQUAL_INT_FLOAT",
+  "REL_NOTEQUAL_BOOL_INT",     "REL_NOTEQUAL_BOOL_FLOAT",
+  "REL_NOTEQUAL_INT_INT",      "REL_NOTEQUAL_INT_FLOAT",
+  "REL_LESS_BOOL_INT",         "REL_LESS_BOOL_FLOAT",
+  "REL_LESS_INT_INT",          "REL_LESS_INT_FLOAT",
+  "REL_LESSEQUAL_BOOL_INT",    "REL_LESSEQUAL_BOOL_FLOAT",
+  "REL_LESSEQUAL_INT_INT",     "REL_LESSEQUAL_INT_FLOAT",
+  "REL_GREATER_BOOL_INT",      "REL_GREATER_BOOL_FLOAT",
+  "REL_GREATER_INT_INT",       "REL_GREATER_INT_FLOAT",
+  "REL_GREATEREQUAL_BOOL_INT", "REL_GREATEREQUAL_BOOL_FLOAT",
+  "REL_GREATEREQUAL_INT_INT",  "REL_GREATEREQUAL_INT_FLOAT",
+  "MOVE2_BOOL", "MOVE2_INT", "MOVE2_FLOAT", "MULSUM_INT", "MULSUM_FLOAT",
+  "RELJUMP_EQUAL_BOOL_INT",         "RELJUMP_EQUAL_BOOL_FLOAT",
+  "RELJUMP_EQUAL_INT_INT",          "RELJUMP_EQUAL_INT_FLOAT",
+  "RELJUMP_NOTEQUAL_BOOL_INT",      "RELJUMP_NOTEQUAL_BOOL_FLOAT",
+  "RELJUMP_NOTEQUAL_INT_INT",       "RELJUMP_NOTEQUAL_INT_FLOAT",
+  "RELJUMP_LESS_BOOL_INT",          "RELJUMP_LESS_BOOL_FLOAT",
+  "RELJUMP_LESS_INT_INT",           "RELJUMP_LESS_INT_FLOAT",
+  "RELJUMP_LESSEQUAL_BOOL_INT",     "RELJUMP_LESSEQUAL_BOOL_FLOAT",
+  "RELJUMP_LESSEQUAL_INT_INT",      "RELJUMP_LESSEQUAL_INT_FLOAT",
+  "RELJUMP_GREATER_BOOL_INT",       "RELJUMP_GREATER_BOOL_FLOAT",
+  "RELJUMP_GREATER_INT_INT",        "RELJUMP_GREATER_INT_FLOAT",
+  "RELJUMP_GREATEREQUAL_BOOL_INT",  "RELJUMP_GREATEREQUAL_BOOL_FLOAT",
+  "RELJUMP_GREATEREQUAL_INT_INT",   "RELJUMP_GREATEREQUAL_INT_FLOAT"
+};
+
+/**
+ * Access the variable of type @p T at the offset stored in @p operand.
+ */
+template<typename T>
+static inline T& var( raw_t *const base, const ByteCode::operand_t& operand )
+{
+  return *reinterpret_cast<T*>( base + operand.offset );
+}
+
+/**
+ * The immediate of type @p T stored in @p operand.
+ */
+template<typename T> static inline T immediate( const ByteCode::operand_t& operand );
+template<> inline int   immediate<int  >( const ByteCode::operand_t& operand ) { return operand.i; }
+template<> inline float immediate<float>( const ByteCode::operand_t& operand ) { return operand.f; }
+
+void ByteCode::compile( LogicElement_Generic** elementList, size_t count, opcode_t terminator, bool awaits )
+{
+  const void *const * labels;
+  execute( nullptr, nullptr, nullptr, nullptr, &labels );
+
+  code.assign( count + 1, endInstruction( terminator ) );
+  elements = elementList;
+
+  for( size_t i = 0; i < count; ++i )
+  {
+    instruction_t& instruction = code[i];
+    instruction.op = CALL;
+    elementList[i]->lower( instruction );
+
+    if( CALL == instruction.op )
+    {
+      instruction.a.index = static_cast<int32_t>( i );
+      if( awaits && elementList[i]->canAwait() )
+        instruction.op = AWAIT;
+    }
+
+    instruction.handler = labels[ instruction.op ];
+  }
+}
+
+void ByteCode::run( raw_t *const base, size_t start, size_t end )
+{
+  // terminate the code at the requested end - the original instruction will
+  // be restored afterwards.
+  // This is save as a LogicEngine is never running twice at the same time.
+  instruction_t& last = code[ end ];
+  const instruction_t saved = last;
+  last = endInstruction();
+
+  execute( &code[ start ], base, code.data(), elements );
+
+  last = saved;
+}
+
+bool ByteCode::run( raw_t *const base, size_t start, size_t end, long int& budget )
+{
+  instruction_t& last = code[ end ];
+  const instruction_t saved = last;
+  last = endInstruction();
+
+  execute( &code[ start ], base, code.data(), elements, nullptr, &budget );
+
+  last = saved;
+  
+  // a suspended run stopped at the target of a backward jump, i.e. before
+  // the end
+  typedef LogicElement_Generic::iterator iterator;
+  const iterator ip = reinterpret_cast<iterator*>( base )[0];
+  return elements + end == ip || reinterpret_cast<iterator>( SIZE_MAX ) == ip;
+}
+
+void ByteCode::dump( std::ostream& out ) const
+{
+  for( size_t i = 0; i < code.size(); ++i )
+  {
+    const instruction_t& instruction = code[i];
+    out << std::setw(4) << i << ": " << opcodeName[ instruction.op ] << "( "
+        << instruction.a.i << ", " << instruction.b.i << ", "
+        << instruction.c.i << ", " << instruction.d.i << ", "
+        << instruction.e.i << " )\n";
+  }
+}
+
+ByteCode::instruction_t ByteCode::endInstruction( opcode_t op )
+{
+  const void *const * labels;
+  execute( nullptr, nullptr, nullptr, nullptr, &labels );
+
+  instruction_t end;
+  end.handler = labels[ op ];
+  end.op = op;
+  end.a.i = end.b.i = end.c.i = end.d.i = end.e.i = 0;
+  return end;
+}
+
+// The dispatch table uses the GCC extension "labels as values":
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+void ByteCode::execute( const instruction_t* ip, raw_t *const base,
+                        const instruction_t *const code,
+                        LogicElement_Generic** const elements,
+                        const void *const ** labels,
+                        long int *const budget )
+{
+  typedef LogicElement_Generic::iterator iterator;
+  long int left = nullptr != budget ? *budget : LONG_MAX;
+
+#if GRAFD_DIRECT_THREADED
+#  define OP( name ) L_##name
+#  define DISPATCH() goto *ip->handler
+  static const void *const dispatchTable[ OPCODE_COUNT ] = {
+    &&L_END, &&L_RETURN, &&L_CALL, &&L_AWAIT, &&L_STOP, &&L_JUMP,
+    &&L_JUMPTRUE_BOOL, &&L_JUMPTRUE_INT, &&L_JUMPZERO_BOOL, &&L_JUMPZERO_INT,
+    &&L_JUMPEQUAL_INT, &&L_JUMPEQUAL_FLOAT, &&L_JUMPNOTEQUAL_INT, &&L_JUMPNOTEQUAL_FLOAT,
+    &&L_CONST_BOOL, &&L_CONST_INT, &&L_CONST_FLOAT,
+    &&L_MOVE_BOOL, &&L_MOVE_INT, &&L_MOVE_FLOAT,
+    &&L_SUM_INT, &&L_SUM_FLOAT, &&L_MUL_INT, &&L_MUL_FLOAT,
+    &&L_MULADD_INT, &&L_MULADD_FLOAT, &&L_MULSUB_INT, &&L_MULSUB_FLOAT,
+    &&L_SUMCONST_INT, &&L_SUMCONST_FLOAT, &&L_MULCONST_INT, &&L_MULCONST_FLOAT,
+    &&L_REL_EQUAL_BOOL_INT,        &&L_REL_EQUAL_BOOL_FLOAT,
+    &&L_REL_EQUAL_INT_INT,         &&L_REL_EQUAL_INT_FLOAT,
+    &&L_REL_NOTEQUAL_BOOL_INT,     &&L_REL_NOTEQUAL_BOOL_FLOAT,
+    &&L_REL_NOTEQUAL_INT_INT,      &&L_REL_NOTEQUAL_INT_FLOAT,
+    &&L_REL_LESS_BOOL_INT,         &&L_REL_LESS_BOOL_FLOAT,
+    &&L_REL_LESS_INT_INT,          &&L_REL_LESS_INT_FLOAT,
+    &&L_REL_LESSEQUAL_BOOL_INT,    &&L_REL_LESSEQUAL_BOOL_FLOAT,
+    &&L_REL_LESSEQUAL_INT_INT,     &&L_REL_LESSEQUAL_INT_FLOAT,
+    &&L_REL_GREATER_BOOL_INT,      &&L_REL_GREATER_BOOL_FLOAT,
+    &&L_REL_GREATER_INT_INT,       &&L_REL_GREATER_INT_FLOAT,
+    &&L_REL_GREATEREQUAL_BOOL_INT, &&L_REL_GREATEREQUAL_BOOL_FLOAT,
+    &&L_REL_GREATEREQUAL_INT_INT,  &&L_REL_GREATEREQUAL_INT_FLOAT,
+    &&L_MOVE2_BOOL, &&L_MOVE2_INT, &&L_MOVE2_FLOAT, &&L_MULSUM_INT, &&L_MULSUM_FLOAT,
+    &&L_RELJUMP_EQUAL_BOOL_INT,         &&L_RELJUMP_EQUAL_BOOL_FLOAT,
+    &&L_RELJUMP_EQUAL_INT_INT,          &&L_RELJUMP_EQUAL_INT_FLOAT,
+    &&L_RELJUMP_NOTEQUAL_BOOL_INT,      &&L_RELJUMP_NOTEQUAL_BOOL_FLOAT,
+    &&L_RELJUMP_NOTEQUAL_INT_INT,       &&L_RELJUMP_NOTEQUAL_INT_FLOAT,
+    &&L_RELJUMP_LESS_BOOL_INT,          &&L_RELJUMP_LESS_BOOL_FLOAT,
+    &&L_RELJUMP_LESS_INT_INT,           &&L_RELJUMP_LESS_INT_FLOAT,
+    &&L_RELJUMP_LESSEQUAL_BOOL_INT,     &&L_RELJUMP_LESSEQUAL_BOOL_FLOAT,
+    &&L_RELJUMP_LESSEQUAL_INT_INT,      &&L_RELJUMP_LESSEQUAL_INT_FLOAT,
+    &&L_RELJUMP_GREATER_BOOL_INT,       &&L_RELJUMP_GREATER_BOOL_FLOAT,
+    &&L_RELJUMP_GREATER_INT_INT,        &&L_RELJUMP_GREATER_INT_FLOAT,
+    &&L_RELJUMP_GREATEREQUAL_BOOL_INT,  &&L_RELJUMP_GREATEREQUAL_BOOL_FLOAT,
+    &&L_RELJUMP_GREATEREQUAL_INT_INT,   &&L_RELJUMP_GREATEREQUAL_INT_FLOAT
+  };
+
+  if( nullptr != labels )
+  {
+    *labels = dispatchTable;
+    return;
+  }
+
+  DISPATCH();
+  {
+#else
+#  define OP( name ) case name
+#  define DISPATCH() continue
+  static const void *const dispatchTable[ OPCODE_COUNT ] = { nullptr };
+
+  if( nullptr != labels )
+  {
+    *labels = dispatchTable;
+    return;
+  }
+
+  for(;;) switch( ip->op )
+  {
+#endif
+
+#define LEAVE() \
+    if( nullptr != budget ) *budget = left; \
+    return
+#define TAKE_JUMP() \
+    if( 0 > ip->a.jump && 0 > ( left += ip->a.jump ) ) \
+    { \
+      ip += ip->a.jump; \
+      reinterpret_cast<iterator*>( base )[0] = elements + (ip - code); \
+      LEAVE(); \
+    } \
+    ip += ip->a.jump
+#define NEXT() ++ip; DISPATCH()
+#define JUMP_IF( condition ) \
+    if( condition ) { TAKE_JUMP(); } else ++ip; DISPATCH()
+#define BINARY( name, T, expression ) \
+  OP( name ): \
+    { \
+      const T in1 = var<T>( base, ip->b ); \
+      const T in2 = var<T>( base, ip->c ); \
+      var<T>( base, ip->a ) = expression; \
+    } \
+    NEXT()
+#define IMMEDIATE( name, T, expression ) \
+  OP( name ): \
+    { \
+      const T in1 = var<T>( base, ip->b ); \
+      const T in2 = immediate<T>( ip->c ); \
+      var<T>( base, ip->a ) = expression; \
+    } \
+    NEXT()
+#define UPDATE( name, T, assignment ) \
+  OP( name ): \
+    var<T>( base, ip->a ) assignment var<T>( base, ip->b ) * var<T>( base, ip->c ); \
+    NEXT()
+#define REL( name, op ) \
+  OP( REL_##name##_BOOL_INT   ): var<bool>( base, ip->a ) = var<int  >( base, ip->b ) op var<int  >( base, ip->c ); NEXT(); \
+  OP( REL_##name##_BOOL_FLOAT ): var<bool>( base, ip->a ) = var<float>( base, ip->b ) op var<float>( base, ip->c ); NEXT(); \
+  OP( REL_##name##_INT_INT    ): var<int >( base, ip->a ) = var<int  >( base, ip->b ) op var<int  >( base, ip->c ); NEXT(); \
+  OP( REL_##name##_INT_FLOAT  ): var<int >( base, ip->a ) = var<float>( base, ip->b ) op var<float>( base, ip->c ); NEXT(); \
+  OP( RELJUMP_##name##_BOOL_INT   ): JUMP_IF( ( var<bool>( base, ip->d ) = var<int  >( base, ip->b ) op var<int  >( base, ip->c ) ) > 0 ); \
+  OP( RELJUMP_##name##_BOOL_FLOAT ): JUMP_IF( ( var<bool>( base, ip->d ) = var<float>( base, ip->b ) op var<float>( base, ip->c ) ) > 0 ); \
+  OP( RELJUMP_##name##_INT_INT    ): JUMP_IF( ( var<int >( base, ip->d ) = var<int  >( base, ip->b ) op var<int  >( base, ip->c ) ) > 0 ); \
+  OP( RELJUMP_##name##_INT_FLOAT  ): JUMP_IF( ( var<int >( base, ip->d ) = var<float>( base, ip->b ) op var<float>( base, ip->c ) ) > 0 )
+
+  OP( END ):
+    reinterpret_cast<iterator*>( base )[0] = elements + (ip - code);
+    LEAVE();
+
+  OP( RETURN ):
+    LEAVE();
+
+  OP( CALL ):
+    {
+      // the virtual calc() expects (and updates) the instruction pointer in
+      // the variable store:
+      iterator& elementIp = reinterpret_cast<iterator*>( base )[0];
+      elementIp = elements + ip->a.index;
+      elements[ ip->a.index ]->calc( base );
+      if( reinterpret_cast<iterator>( SIZE_MAX ) == elementIp )
+      {
+        LEAVE();
+      }
+      ip = code + (elementIp - elements);
+    }
+    DISPATCH();
+
+  OP( AWAIT ):
+    reinterpret_cast<iterator*>( base )[0] = elements + ip->a.index;
+    LEAVE();
+
+  OP( STOP ):
+    reinterpret_cast<iterator*>( base )[0] = reinterpret_cast<iterator>( SIZE_MAX );
+    LEAVE();
+
+  OP( JUMP ):
+    TAKE_JUMP();
+    DISPATCH();
+
+  OP( JUMPTRUE_BOOL      ): JUMP_IF( var<bool >( base, ip->b ) >  0 );
+  OP( JUMPTRUE_INT       ): JUMP_IF( var<int  >( base, ip->b ) >  0 );
+  OP( JUMPZERO_BOOL      ): JUMP_IF( var<bool >( base, ip->b ) == 0 );
+  OP( JUMPZERO_INT       ): JUMP_IF( var<int  >( base, ip->b ) == 0 );
+  OP( JUMPEQUAL_INT      ): JUMP_IF( var<int  >( base, ip->b ) == var<int  >( base, ip->c ) );
+  OP( JUMPEQUAL_FLOAT    ): JUMP_IF( var<float>( base, ip->b ) == var<float>( base, ip->c ) );
+  OP( JUMPNOTEQUAL_INT   ): JUMP_IF( var<int  >( base, ip->b ) != var<int  >( base, ip->c ) );
+  OP( JUMPNOTEQUAL_FLOAT ): JUMP_IF( var<float>( base, ip->b ) != var<float>( base, ip->c ) );
+
+  OP( CONST_BOOL  ): var<bool >( base, ip->a ) = ip->b.i; NEXT();
+  OP( CONST_INT   ): var<int  >( base, ip->a ) = ip->b.i; NEXT();
+  OP( CONST_FLOAT ): var<float>( base, ip->a ) = ip->b.f; NEXT();
+
+  OP( MOVE_BOOL  ): var<bool >( base, ip->a ) = var<bool >( base, ip->b ); NEXT();
+  OP( MOVE_INT   ): var<int  >( base, ip->a ) = var<int  >( base, ip->b ); NEXT();
+  OP( MOVE_FLOAT ): var<float>( base, ip->a ) = var<float>( base, ip->b ); NEXT();
+
+  BINARY( SUM_INT  , int  , in1 + in2 );
+  BINARY( SUM_FLOAT, float, in1 + in2 );
+  BINARY( MUL_INT  , int  , in1 * in2 );
+  BINARY( MUL_FLOAT, float, in1 * in2 );
+  UPDATE( MULADD_INT  , int  , += );
+  UPDATE( MULADD_FLOAT, float, += );
+  UPDATE( MULSUB_INT  , int  , -= );
+  UPDATE( MULSUB_FLOAT, float, -= );
+  IMMEDIATE( SUMCONST_INT  , int  , in1 + in2 );
+  IMMEDIATE( SUMCONST_FLOAT, float, in1 + in2 );
+  IMMEDIATE( MULCONST_INT  , int  , in1 * in2 );
+  IMMEDIATE( MULCONST_FLOAT, float, in1 * in2 );
+
+  REL( EQUAL       , == );
+  REL( NOTEQUAL    , != );
+  REL( LESS        , <  );
+  REL( LESSEQUAL   , <= );
+  REL( GREATER     , >  );
+  REL( GREATEREQUAL, >= );
+
+  OP( MOVE2_BOOL  ): var<bool >( base, ip->a ) = var<bool >( base, ip->b ); var<bool >( base, ip->c ) = var<bool >( base, ip->d ); NEXT();
+  OP( MOVE2_INT   ): var<int  >( base, ip->a ) = var<int  >( base, ip->b ); var<int  >( base, ip->c ) = var<int  >( base, ip->d ); NEXT();
+  OP( MOVE2_FLOAT ): var<float>( base, ip->a ) = var<float>( base, ip->b ); var<float>( base, ip->c ) = var<float>( base, ip->d ); NEXT();
+
+  OP( MULSUM_INT   ): var<int  >( base, ip->e ) = var<int  >( base, ip->b ) * var<int  >( base, ip->c ); var<int  >( base, ip->a ) = var<int  >( base, ip->e ) + var<int  >( base, ip->d ); NEXT();
+  OP( MULSUM_FLOAT ): var<float>( base, ip->e ) = var<float>( base, ip->b ) * var<float>( base, ip->c ); var<float>( base, ip->a ) = var<float>( base, ip->e ) + var<float>( base, ip->d ); NEXT();
+
+#if !GRAFD_DIRECT_THREADED
+    case OPCODE_COUNT:
+      return; // not reachable, just keep the compiler happy
+#endif
+  }
+
+#undef REL
+#undef UPDATE
+#undef IMMEDIATE
+#undef BINARY
+#undef JUMP_IF
+#undef NEXT
+#undef TAKE_JUMP
+#undef LEAVE
+#undef DISPATCH
+#undef OP
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,327 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <iosfwd>
+
+#include "globals.h"
+
+class LogicElement_Generic;
+
+/**
+ * Direct threading needs the GCC extension "labels as values", otherwise
+ * the dispatch falls back to a plain switch.
+ */
+#ifndef GRAFD_DIRECT_THREADED
+#  ifdef __GNUC__
+#    define GRAFD_DIRECT_THREADED 1
+#  else
+#    define GRAFD_DIRECT_THREADED 0
+#  endif
+#endif
+
+/**
+ * The ByteCode is the second execution backend of the LogicEngine.
+ *
+ * The list of LogicElements is lowered to a flat and contiguous array of
+ * instructions that are executed by a single dispatch loop instead of a
+ * virtual call for each element. The instructions map 1:1 to the
+ * LogicElements, so all jump offsets and the position of the main task stay
+ * valid.
+ * Elements that have no own opcode are executed through a CALL of their
+ * virtual LogicElement_Generic::calc().
+ */
+class ByteCode
+{
+public:
+  /**
+   * All known opcodes.
+   * NOTE: the order has to be kept in sync with the dispatch table in
+   * ByteCode::execute() and opcodeName[]!
+   */
+  enum opcode_t : uint32_t
+  {
+    END,                ///< end of the instructions to run
+    RETURN,             ///< end of a task, the instruction pointer isn't stored
+    CALL,               ///< fall back: call LogicElement at index a
+    AWAIT,              ///< leave the run at the element a, it waits for something
+    STOP,               ///< stop execution of the logic
+    JUMP,               ///< jump by a
+    JUMPTRUE_BOOL,      ///< jump by a when b > 0
+    JUMPTRUE_INT,
+    JUMPZERO_BOOL,      ///< jump by a when b == 0
+    JUMPZERO_INT,
+    JUMPEQUAL_INT,      ///< jump by a when b == c
+    JUMPEQUAL_FLOAT,
+    JUMPNOTEQUAL_INT,   ///< jump by a when b != c
+    JUMPNOTEQUAL_FLOAT,
+    CONST_BOOL,         ///< a = immediate b
+    CONST_INT,
+    CONST_FLOAT,
+    MOVE_BOOL,          ///< a = b
+    MOVE_INT,
+    MOVE_FLOAT,
+    SUM_INT,            ///< a = b + c
+    SUM_FLOAT,
+    MUL_INT,            ///< a = b * c
+    MUL_FLOAT,
+    MULADD_INT,         ///< a += b * c
+    MULADD_FLOAT,
+    MULSUB_INT,         ///< a -= b * c
+    MULSUB_FLOAT,
+    SUMCONST_INT,       ///< a = b + immediate c
+    SUMCONST_FLOAT,
+    MULCONST_INT,       ///< a = b * immediate c
+    MULCONST_FLOAT,
+    // a = b <relation> c; ordered by relation, then by the output type
+    // bool/int, then by the input type int/float
+    REL_EQUAL_BOOL_INT,        REL_EQUAL_BOOL_FLOAT,
+    REL_EQUAL_INT_INT,         REL_EQUAL_INT_FLOAT,
+    REL_NOTEQUAL_BOOL_INT,     REL_NOTEQUAL_BOOL_FLOAT,
+    REL_NOTEQUAL_INT_INT,      REL_NOTEQUAL_INT_FLOAT,
+    REL_LESS_BOOL_INT,         REL_LESS_BOOL_FLOAT,
+    REL_LESS_INT_INT,          REL_LESS_INT_FLOAT,
+    REL_LESSEQUAL_BOOL_INT,    REL_LESSEQUAL_BOOL_FLOAT,
+    REL_LESSEQUAL_INT_INT,     REL_LESSEQUAL_INT_FLOAT,
+    REL_GREATER_BOOL_INT,      REL_GREATER_BOOL_FLOAT,
+    REL_GREATER_INT_INT,       REL_GREATER_INT_FLOAT,
+    REL_GREATEREQUAL_BOOL_INT, REL_GREATEREQUAL_BOOL_FLOAT,
+    REL_GREATEREQUAL_INT_INT,  REL_GREATEREQUAL_INT_FLOAT,
+    // superinstructions, created by the Optimizer from two instructions:
+    MOVE2_BOOL,         ///< a = b, then c = d
+    MOVE2_INT,
+    MOVE2_FLOAT,
+    MULSUM_INT,         ///< e = b * c, then a = e + d
+    MULSUM_FLOAT,
+    // d = b <relation> c, then jump by a when d > 0; ordered like REL_*
+    RELJUMP_EQUAL_BOOL_INT,         RELJUMP_EQUAL_BOOL_FLOAT,
+    RELJUMP_EQUAL_INT_INT,          RELJUMP_EQUAL_INT_FLOAT,
+    RELJUMP_NOTEQUAL_BOOL_INT,      RELJUMP_NOTEQUAL_BOOL_FLOAT,
+    RELJUMP_NOTEQUAL_INT_INT,       RELJUMP_NOTEQUAL_INT_FLOAT,
+    RELJUMP_LESS_BOOL_INT,          RELJUMP_LESS_BOOL_FLOAT,
+    RELJUMP_LESS_INT_INT,           RELJUMP_LESS_INT_FLOAT,
+    RELJUMP_LESSEQUAL_BOOL_INT,     RELJUMP_LESSEQUAL_BOOL_FLOAT,
+    RELJUMP_LESSEQUAL_INT_INT,      RELJUMP_LESSEQUAL_INT_FLOAT,
+    RELJUMP_GREATER_BOOL_INT,       RELJUMP_GREATER_BOOL_FLOAT,
+    RELJUMP_GREATER_INT_INT,        RELJUMP_GREATER_INT_FLOAT,
+    RELJUMP_GREATEREQUAL_BOOL_INT,  RELJUMP_GREATEREQUAL_BOOL_FLOAT,
+    RELJUMP_GREATEREQUAL_INT_INT,   RELJUMP_GREATEREQUAL_INT_FLOAT,
+    OPCODE_COUNT        ///< number of opcodes, not an instruction itself
+  };
+
+  /**
+   * The names of the opcodes, e.g. for dumping.
+   */
+  static const char *const opcodeName[ OPCODE_COUNT ];
+
+  /**
+   * One operand of an instruction.
+   */
+  union operand_t
+  {
+    int32_t offset;     ///< offset of a variable in the variable store
+    int32_t jump;       ///< relative jump distance in instructions
+    int32_t index;      ///< index of the LogicElement for a CALL
+    int32_t i;          ///< immediate int (and bool)
+    float   f;          ///< immediate float
+  };
+
+  /**
+   * One instruction, it's 32 bytes so that two fit in one cache line.
+   */
+  struct instruction_t
+  {
+    const void* handler;  ///< address of the handler, only used when direct threaded
+    opcode_t op;          ///< the opcode
+    operand_t a;          ///< first operand - usually the output
+    operand_t b;          ///< second operand
+    operand_t c;          ///< third operand
+    operand_t d;          ///< fourth operand
+    operand_t e;          ///< fifth operand - only used by superinstructions
+  };
+
+  /**
+   * Return @p forBool, @p forInt or @p forFloat depending on the type
+   * @p T - or CALL when the type has no opcode.
+   */
+  template<typename T>
+  static constexpr opcode_t select( opcode_t, opcode_t, opcode_t )
+  {
+    return CALL;
+  }
+
+  /**
+   * Return the opcode for a relation of type LogicElement_Rel::relType
+   * @p relation with the result in @p Tout and the input in @p Tin.
+   * The opcodes are counted from @p first, i.e. REL_EQUAL_BOOL_INT or
+   * RELJUMP_EQUAL_BOOL_INT.
+   */
+  template<typename Tout, typename Tin>
+  static constexpr opcode_t relation( int relation, opcode_t first = REL_EQUAL_BOOL_INT )
+  {
+    // Tout has to be bool or int, Tin has to be int or float
+    return ( CALL == select<Tout>( END, END, CALL ) || CALL == select<Tin>( CALL, END, END ) )
+      ? CALL
+      : static_cast<opcode_t>( first + 4 * relation
+                               + ( CALL == select<Tout>( END, CALL, END ) ? 2 : 0 )
+                               + ( CALL == select<Tin >( END, END, CALL ) ? 1 : 0 ) );
+  }
+
+  /**
+   * Store the immediate @p value in the @p operand.
+   */
+  static void setImmediate( operand_t& operand, bool  value ) { operand.i = value; }
+  static void setImmediate( operand_t& operand, int   value ) { operand.i = value; }
+  static void setImmediate( operand_t& operand, float value ) { operand.f = value; }
+  template<typename T>
+  static void setImmediate( operand_t&, const T& ) {} // no opcode, CALL is used
+
+  /**
+   * Constructor.
+   */
+  ByteCode() : code(), elements( nullptr )
+  {}
+
+  /**
+   * Lower the @p count LogicElements in @p elementList to the ByteCode,
+   * terminated by the opcode @p terminator, i.e. END or RETURN.
+   * With @p awaits the elements that can await something are compiled to
+   * AWAIT, i.e. the run is left there and the instruction pointer points
+   * to them, otherwise they are called and wait in calc().
+   * NOTE: the elements are not owned by the ByteCode, they must live as long
+   * as the ByteCode is used as they are needed for CALL.
+   */
+  void compile( LogicElement_Generic** elementList, size_t count, opcode_t terminator = END, bool awaits = false );
+
+  /**
+   * Forget the compiled instructions.
+   */
+  void clear( void )
+  {
+    code.clear();
+    elements = nullptr;
+  }
+
+  /**
+   * Return the number of instructions (not counting the terminating END).
+   */
+  size_t size( void ) const
+  {
+    return code.empty() ? 0 : code.size() - 1;
+  }
+
+  /**
+   * Return the instruction at @p index.
+   */
+  const instruction_t& operator[]( size_t index ) const
+  {
+    return code[ index ];
+  }
+  
+  /**
+   * Is the ByteCode compiled from the @p count elements at @p elementList?
+   */
+  bool isCompiledFrom( LogicElement_Generic** elementList, size_t count ) const
+  {
+    return elements == elementList && size() == count;
+  }
+
+  /**
+   * Run the instructions from index @p start till one before index @p end
+   * on the variables at @p base.
+   * The instruction pointer at @p base is updated on exit like the
+   * LogicEngine does for the virtual calls.
+   */
+  void run( raw_t *const base, size_t start, size_t end );
+  
+  /**
+   * Run the instructions from index @p start till one before index @p end
+   * on the variables at @p base, but only as long as the @p budget lasts:
+   * each taken backward jump uses up the jumped over instructions, i.e.
+   * those of one iteration of a loop.
+   * @return false when the budget was used up or an element awaits
+   *         something, the instruction pointer at @p base holds the element
+   *         to continue with then.
+   */
+  bool run( raw_t *const base, size_t start, size_t end, long int& budget );
+  
+  /**
+   * Run all instructions on the variables at @p base.
+   * When the code was compiled with the terminator RETURN and has no CALL
+   * the instruction pointer at @p base isn't touched, so several of these
+   * can run at the same time on the same variables.
+   */
+  void run( raw_t *const base ) const
+  {
+    execute( code.data(), base, code.data(), elements );
+  }
+
+  /**
+   * Show the instructions in human readable form.
+   */
+  void dump( std::ostream& out ) const;
+
+private:
+  /**
+   * The instructions, terminated by END.
+   */
+  std::vector<instruction_t> code;
+
+  /**
+   * The LogicElements the code was compiled from, needed for CALL.
+   */
+  LogicElement_Generic** elements;
+
+  /**
+   * The dispatch loop. Start at @p ip and run till END or STOP - or till
+   * the @p budget is used up, when it isn't nullptr.
+   * When @p labels isn't nullptr the table of the handler addresses is
+   * returned there instead and nothing will be executed.
+   */
+  static void execute( const instruction_t* ip, raw_t *const base,
+                       const instruction_t *const code,
+                       LogicElement_Generic** const elements,
+                       const void *const ** labels = nullptr,
+                       long int *const budget = nullptr );
+
+  /**
+   * Return an END - or @p op - instruction that is ready to be dispatched.
+   */
+  static instruction_t endInstruction( opcode_t op = END );
+};
+
+template<> constexpr ByteCode::opcode_t ByteCode::select<bool >( opcode_t forBool, opcode_t, opcode_t )
+{
+  return forBool;
+}
+
+template<> constexpr ByteCode::opcode_t ByteCode::select<int  >( opcode_t, opcode_t forInt, opcode_t )
+{
+  return forInt;
+}
+
+template<> constexpr ByteCode::opcode_t ByteCode::select<float>( opcode_t, opcode_t, opcode_t forFloat )
+{
+  return forFloat;
+}
+
+#endif // BYTECODE_HPP
@@ -0,0 +1,165 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "checkpoint.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "logger.hpp"
+
+/**
+ * The identification of the file, increase the version when the header_t
+ * changes.
+ */
+static const char     checkpointMagic[8] = { 'G', 'r', 'A', 'F', 'd', 'C', 'P', '\0' };
+static const uint32_t checkpointVersion  = 1;
+
+Checkpoint::Checkpoint( const std::string& _fileName, uint64_t _layout, size_t _size )
+: fileName( _fileName ), layout( _layout ), size( _size ), 
+  pending( -1 ), writing( -1 ), writes( 0 ), running( true )
+{
+  buffers[0].resize( size );
+  buffers[1].resize( size );
+  thread = std::thread( &Checkpoint::loop, this );
+}
+
+Checkpoint::~Checkpoint()
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    running = false;
+  }
+  wake.notify_one();
+  thread.join();
+}
+
+uint64_t Checkpoint::hash( const std::string& text )
+{
+  // 64 bit FNV-1a, like NativeCode::key()
+  uint64_t hash = 14695981039346656037ULL;
+  for( auto c = text.cbegin(); c != text.cend(); ++c )
+  {
+    hash ^= static_cast<unsigned char>( *c );
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void Checkpoint::capture( const raw_t* const variables )
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    
+    // the buffer that isn't written by the thread right now - an older
+    // capture that wasn't written yet is just replaced
+    const int target = 0 == writing ? 1 : 0;
+    std::memcpy( buffers[ target ].data(), variables, size );
+    pending = target;
+  }
+  wake.notify_one();
+}
+
+bool Checkpoint::restore( raw_t* const variables ) const
+{
+  const int file = ::open( fileName.c_str(), O_RDONLY );
+  if( -1 == file )
+    return false;
+  
+  struct stat status;
+  const size_t fileSize = sizeof( header_t ) + size;
+  if( -1 == fstat( file, &status ) || fileSize != static_cast<size_t>( status.st_size ) )
+  {
+    ::close( file );
+    logger( Logger::WARN ) << "Checkpoint: '" << fileName << "' has the wrong size, ignoring it\n"; logger.show();
+    return false;
+  }
+  
+  void* map = mmap( nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0 );
+  ::close( file ); // the mapping stays valid
+  if( MAP_FAILED == map )
+    return false;
+  
+  const header_t* header = static_cast<const header_t*>( map );
+  const bool matches = 0 == std::memcmp( header->magic, checkpointMagic, sizeof( checkpointMagic ) )
+                    && checkpointVersion == header->version
+                    && layout == header->layout
+                    && size == header->size;
+  if( matches )
+    std::memcpy( variables, static_cast<const raw_t*>( map ) + sizeof( header_t ), size );
+  else
+  {
+    logger( Logger::WARN ) << "Checkpoint: '" << fileName << "' doesn't match the logic, ignoring it\n"; logger.show();
+  }
+  
+  munmap( map, fileSize );
+  return matches;
+}
+
+void Checkpoint::loop( void )
+{
+  std::unique_lock<std::mutex> lock( mutex );
+  for(;;)
+  {
+    wake.wait( lock, [this]{ return !running || -1 != pending; } );
+    if( -1 == pending ) // i.e. not running anymore
+      break;
+    
+    writing = pending;
+    pending = -1;
+    lock.unlock();
+    
+    if( write( buffers[ writing ] ) )
+      ++writes;
+    
+    lock.lock();
+    writing = -1;
+  }
+}
+
+bool Checkpoint::write( const std::vector<raw_t>& buffer ) const
+{
+  header_t header;
+  std::memset( &header, 0, sizeof( header ) );
+  std::memcpy( header.magic, checkpointMagic, sizeof( checkpointMagic ) );
+  header.version = checkpointVersion;
+  header.layout  = layout;
+  header.size    = size;
+  
+  // write to a temporary file and replace the old one by it afterwards, so
+  // that a crash meanwhile can't leave a broken checkpoint
+  const std::string temporary = fileName + ".new";
+  const int file = ::open( temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  bool success = -1 != file
+              && sizeof( header ) == static_cast<size_t>( ::write( file, &header, sizeof( header ) ) )
+              && size == static_cast<size_t>( ::write( file, buffer.data(), size ) )
+              && 0 == fsync( file );
+  if( -1 != file )
+    ::close( file );
+  success = success && 0 == std::rename( temporary.c_str(), fileName.c_str() );
+  
+  if( !success )
+  {
+    logger( Logger::WARN ) << "Checkpoint: can't write '" << fileName << "'\n"; logger.show();
+  }
+  return success;
+}
@@ -0,0 +1,122 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+#include "globals.h"
+
+/**
+ * A Checkpoint saves the variables of a LogicEngine to a file, so that a
+ * restarted logic can continue with the state it had, e.g. the value of an
+ * integral.
+ * 
+ * capture() only copies the variables into one of two buffers, a thread of
+ * its own writes it to the file meanwhile the logic keeps running. The
+ * file is replaced atomically, so it always holds a complete snapshot.
+ * It's only restored when the layout of the variables is still the same.
+ */
+class Checkpoint
+{
+public:
+  /**
+   * Constructor - for @p size bytes of variables with the layout @p layout
+   * in the file @p fileName.
+   */
+  Checkpoint( const std::string& fileName, uint64_t layout, size_t size );
+  Checkpoint( const Checkpoint& ) = delete; // no copy
+  
+  /**
+   * Destructor - write the last capture and stop the thread.
+   */
+  ~Checkpoint();
+  
+  /**
+   * Copy the @p variables to be written to the file.
+   * NOTE: they mustn't be changed meanwhile, i.e. the logic isn't running.
+   */
+  void capture( const raw_t* const variables );
+  
+  /**
+   * Copy the content of the file to the @p variables.
+   * @return false when there's no file or its layout doesn't match, the
+   *         variables are untouched then.
+   */
+  bool restore( raw_t* const variables ) const;
+  
+  /**
+   * Return the number of snapshots that were written to the file.
+   */
+  size_t written( void ) const
+  {
+    return writes;
+  }
+  
+  /**
+   * Return a hash of @p text that's stable between the builds.
+   */
+  static uint64_t hash( const std::string& text );
+  
+private:
+  /**
+   * The start of the file.
+   */
+  struct header_t
+  {
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t layout;
+    uint64_t size;
+  };
+  
+  const std::string fileName;
+  const uint64_t    layout;
+  const size_t      size;
+  
+  std::vector<raw_t> buffers[2];
+  int pending;                   ///< the buffer to write next, -1 for none
+  int writing;                   ///< the buffer the thread writes, -1 for none
+  std::atomic<size_t> writes;
+  
+  bool running;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::thread thread;
+  
+  /**
+   * The loop of the thread.
+   */
+  void loop( void );
+  
+  /**
+   * Write the @p buffer to the file.
+   * @return false on error
+   */
+  bool write( const std::vector<raw_t>& buffer ) const;
+};
+
+#endif // CHECKPOINT_HPP
@@ -21,6 +21,7 @@
 #include <sstream>
 
 #include "logger.hpp"
+#include "json.hpp"
 #include "graph.hpp"
 
 void SCGI_session::handle_read_start( const boost::system::error_code& error,
@@ -121,6 +122,39 @@ void SCGI_session::handle_read( const boost::system::error_code& error,
         }
         break;
         
+      case 'v': // return the current values of the variables of a graph
+        {
+          std::map<std::string, variable_t> values;
+          auto graphIt = graphs.find(parameter);
+          if( graphs.end() != graphIt && graphIt->second.getValues( values ) )
+          {
+            goodRequest = true;
+            std::stringstream out;
+            out << "{";
+            for( auto it = values.cbegin(); it != values.cend(); ++it )
+              out << ( values.cbegin() == it ? "\n  " : ",\n  " ) << JSON::escape( it->first ) << ": " << it->second.getAsString( true );
+            out << "\n}";
+            SCGI_result = out.str();
+          } else {
+            SCGI_result = "{error: \"Graph '" + parameter + "' not known\"}";
+          }
+        }
+        break;
+        
+      case 'p': // return the profile of a graph
+        {
+          auto graphIt = graphs.find(parameter);
+          std::stringstream out;
+          if( graphs.end() != graphIt && graphIt->second.showProfile( out ) )
+          {
+            goodRequest = true;
+            SCGI_result = out.str();
+          } else {
+            SCGI_result = "{error: \"Graph '" + parameter + "' not known or not profiling\"}";
+          }
+        }
+        break;
+        
       case 'l': // return the library
         goodRequest = true;
         {
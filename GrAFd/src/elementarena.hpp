@@ -0,0 +1,113 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELEMENTARENA_HPP
+#define ELEMENTARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "globals.h"
+
+/**
+ * The ElementArena holds the LogicElements of one LogicEngine.
+ * 
+ * The elements are placed one after the other in large chunks, i.e. in the
+ * order they are created - which is usually the program order. The memory
+ * of all elements is freed at once with the arena.
+ */
+class ElementArena
+{
+public:
+  /**
+   * The size of a chunk.
+   */
+  static const size_t chunkSize = 16 * 1024;
+  
+  /**
+   * The alignment of each allocation.
+   */
+  static const size_t alignment = alignof( std::max_align_t );
+  
+  /**
+   * Constructor.
+   */
+  ElementArena() : chunks(), next( nullptr ), remaining( 0 ), reserved( 0 )
+  {}
+  ElementArena( const ElementArena& ) = delete; // no copy
+  
+  /**
+   * Move constructor.
+   */
+  ElementArena( ElementArena&& other ) 
+  : chunks( std::move( other.chunks ) ), next( other.next ), 
+    remaining( other.remaining ), reserved( other.reserved )
+  {
+    other.chunks.clear();
+    other.next = nullptr;
+    other.remaining = 0;
+    other.reserved = 0;
+  }
+  
+  /**
+   * Destructor - free the memory of all elements.
+   * NOTE: the destructors of the elements have to be called before.
+   */
+  ~ElementArena()
+  {
+    for( auto chunk = chunks.begin(); chunk != chunks.end(); ++chunk )
+      delete[] *chunk;
+  }
+  
+  /**
+   * Return @p size bytes.
+   */
+  raw_t* allocate( size_t size )
+  {
+    size = ( size + alignment - 1 ) & ~( alignment - 1 );
+    if( remaining < size )
+    {
+      const size_t newChunk = size > chunkSize ? size : chunkSize;
+      chunks.push_back( new raw_t[ newChunk ] );
+      next = chunks.back();
+      remaining = newChunk;
+      reserved += newChunk;
+    }
+    
+    raw_t* memory = next;
+    next += size;
+    remaining -= size;
+    return memory;
+  }
+  
+  /**
+   * Return the number of bytes that the arena holds.
+   */
+  size_t size( void ) const
+  {
+    return reserved;
+  }
+  
+private:
+  std::vector<raw_t*> chunks;
+  raw_t* next;
+  size_t remaining;
+  size_t reserved;
+};
+
+#endif // ELEMENTARENA_HPP
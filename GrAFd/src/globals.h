@@ -47,5 +47,8 @@ extern class MessageRegister registry;
 extern zmq::socket_t* sender;
 extern graphs_t graphs;
 extern class Worker* worker;
+extern class Awaiter* awaiter;
+extern class RunQueue* runQueue;
+extern class Outbox* outbox;
 
 #endif // CONFIGHANDLER
\ No newline at end of file
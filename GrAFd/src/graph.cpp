@@ -19,6 +19,8 @@
 #include "graph.hpp"
 
 #include <string>
+#include <algorithm>
+#include <iterator>
 #include <boost/algorithm/string/predicate.hpp>
 
 #include "globals.h"
@@ -27,24 +29,114 @@
 #include "json.hpp"
 #include "logger.hpp"
 #include "messageregister.hpp"
+#include "optimizer.hpp"
+#include "taskpool.hpp"
+#include "awaiter.hpp"
+#include "runqueue.hpp"
+#include "outbox.hpp"
+#include "checkpoint.hpp"
+#include "snapshot.hpp"
+#include "graphcache.hpp"
+#include "variablearena.hpp"
+#include "batchengine.hpp"
 #include "worker.hpp"
 
 using namespace std;
 
 GraphLib Graph::lib; // give the static variable a home
+std::string Graph::nativePath;
+std::string Graph::checkpointPath;
+std::string Graph::cachePath;
+bool Graph::exportSnapshots = false;
+
+namespace
+{
+  /**
+   * The pool that runs the blocks of all parallel graphs, started on first
+   * use with a thread for each core.
+   */
+  TaskPool& taskPool( void )
+  {
+    static TaskPool pool( std::max( 1u, std::thread::hardware_concurrency() ) - 1 );
+    return pool;
+  }
+}
 
 Graph::Graph( istream& stream )
 : meta({
-    { "step-size", variable_t(  0.0 ) },
-    { "stop-time", variable_t( -1.0 ) },
+    { "step-size"  , variable_t(  0.0 ) },
+    { "stop-time"  , variable_t( -1.0 ) },
+    { "backend"    , variable_t( string( "bytecode" ) ) },
+    { "trace"      , variable_t( false ) },
+    { "optimize"   , variable_t( true  ) },
+    { "incremental", variable_t( true  ) },
+    { "parallel"   , variable_t( false ) },
+    { "budget"     , variable_t( 0 ) },
+    { "priority"   , variable_t( 0 ) },
+    { "checkpoint" , variable_t( 10.0 ) },
+    { "profile"    , variable_t( false ) },
+    { "instances"  , variable_t( 0 ) },
   }),
-  scheduler( nullptr )
+  checkpoint( nullptr ),
+  snapshot( nullptr ),
+  batch( nullptr )
 {
-  parseString( stream );
+  // the whole source, the compiled result is cached for it
+  const string source( (istreambuf_iterator<char>( stream )), istreambuf_iterator<char>() );
+  lib.refresh(); // a library might have been changed since the last graph
+  const uint64_t libraries = lib.key();
+  const uint64_t key = GraphCache::key( source, libraries );
+  
+  if( !cachePath.empty() && loadCache( key ) )
+  {
+    // the structure is only needed when it's shown
+    unparsed = source;
+    logger << "Graph " << this << ": using the compiled logic '" << GraphCache::fileName( cachePath, key ) << "'\n"; logger.show();
+  }
+  else
+  {
+    JSON::buffer in( source );
+    parseString( in );
+    compile();
+    
+    // a library that was changed while compiling makes the key invalid
+    if( !cachePath.empty() && libraries == lib.key() )
+    {
+      GraphCache::Writer out;
+      if( storeCache( out ) && GraphCache::store( cachePath, key, out ) )
+        logger << "Graph " << this << ": compiled logic written to '" << GraphCache::fileName( cachePath, key ) << "'\n";
+      else
+        logger( Logger::WARN ) << "Graph " << this << ": compiled logic can't be cached\n";
+      logger.show();
+    }
+  }
   
+  prepare();
+}
+
+void Graph::compile( void )
+{
   std::vector<vertex_t> topo_order;
   boost::topological_sort(g, std::back_inserter(topo_order));
   
+  // the rate groups, the fastest first - a block without own sample time
+  // runs with the step-size of the graph
+  const float stepSize = meta.at( "step-size" ).getFloat();
+  auto rateOf = [stepSize]( const GraphBlock& block ) -> float
+  {
+    return 0.0 < block.sampleTime ? block.sampleTime : stepSize;
+  };
+  for( auto i = topo_order.cbegin(); i != topo_order.cend(); ++i )
+    rates.push_back( rateOf( g[*i] ) );
+  std::sort( rates.begin(), rates.end() );
+  rates.erase( std::unique( rates.begin(), rates.end() ), rates.end() );
+  if( rates.empty() )
+    rates.push_back( stepSize );
+  auto groupOf = [this, &rateOf]( const GraphBlock& block ) -> size_t
+  {
+    return std::lower_bound( rates.cbegin(), rates.cend(), rateOf( block ) ) - rates.cbegin();
+  };
+  
   // count the needed instructions for this logic
   size_t instructions = 0;
   for( auto i = topo_order.crbegin(); i != topo_order.crend(); ++i )
@@ -54,19 +146,19 @@ Graph::Graph( istream& stream )
     
     if( block.isStateCopy )
     {
-      instructions += LogicEngine::instructionsCount( libBlock.implementation );
+      instructions += LogicEngine::instructionsCount( block.implementation );
       continue;
     }
     
-    instructions += LogicEngine::instructionsCount( libBlock.init );
-    instructions += LogicEngine::instructionsCount( libBlock.implementation );
+    instructions += libBlock.initProgram.instructions;
+    instructions += libBlock.implementationProgram.instructions;
   }
   
   logicengines.emplace_back( instructions );
   
   le = &(logicengines.back()); //new LogicEngine( instructions, -1 );
-  le->registerVariable<float>( "__dt" );
-  map<string, string> parameterTranslation;
+  // the translation of the string parameters of each block
+  map<string, LogicEngine::translation_t> parameterTranslation;
   
   // Register the variables
   for( auto i = topo_order.crbegin(); i != topo_order.crend(); ++i )
@@ -77,7 +169,12 @@ Graph::Graph( istream& stream )
     // register parameters
     if( !block.isStateCopy )
     {    
+      // the parameters that aren't set at the block keep their default
+      std::map<string, variable_t> parameters( libBlock.parameters );
       for( auto it = block.parameters.cbegin(); it != block.parameters.cend(); it++ )
+        parameters[ it->first ] = it->second;
+      
+      for( auto it = parameters.cbegin(); it != parameters.cend(); it++ )
       {
         if( variableType::STRING == it->second.getType() )
         { 
@@ -89,14 +186,16 @@ Graph::Graph( istream& stream )
           {
             if( "__dt" == it->second.getString() )
             {
-              parameterTranslation[ block.name + "/" + it->first ] = "__dt";
-              logger << "map '" << (block.name + "/" + it->first) << "' to __dt\n"; logger.show();
+              // the time since the last run of the rate group of the block
+              const string clock = LogicEngine::clockName( groupOf( block ) );
+              parameterTranslation[ block.name ][ block.name + "/" + it->first ] = clock;
+              logger << "map '" << (block.name + "/" + it->first) << "' to " << clock << "\n"; logger.show();
             } else
               throw JSON::parseError( "String parameter for number value only for '__dt' implemented!", __LINE__ ,__FILE__ );
           } else {
             logger << "##### '" << (block.name + "/" + it->first) << "' - '" << it->second.getAsString() << "'\n"; logger.show();
             //le->registerVariable( block.name + "/" + it->first, it->second );
-            parameterTranslation[ block.name + "/" + it->first ] = it->second.getAsString();
+            parameterTranslation[ block.name ][ block.name + "/" + it->first ] = it->second.getAsString();
           }
         } else
           le->registerVariable( block.name + "/" + it->first, it->second );
@@ -108,23 +207,22 @@ Graph::Graph( istream& stream )
     {
       if( !(block.isStateCopy && GraphBlock::Port::STATE != it->type) )
         le->registerVariable<int>( block.name + "/" + it->name );
+      if( GraphBlock::Port::STATE == it->type )
+        le->markState( block.name + "/" + it->name );
     }
   }
   
   // setup the LogicEngine
-  auto setupLogicEngine = [this, &parameterTranslation]( std::vector<vertex_t>::const_reverse_iterator i, bool doInit )
+  auto setupLogicEngine = [this, &parameterTranslation, &groupOf]( std::vector<vertex_t>::const_reverse_iterator i, bool doInit )
   {
     const auto &block = g[*i];
     const auto &libBlock = libLookup( block );
-    string implementation = block.implementation;
-    if( "" == implementation )
-      implementation = libBlock.implementation;
-    string init = block.init;
-    if( "" == init )
-      init = libBlock.init;
     
     // find source of inPorts
-    map<string, string> inPortTranslation( parameterTranslation );
+    LogicEngine::translation_t inPortTranslation( parameterTranslation[ block.name ] );
+    
+    // "__dt" is the time since the last run of the rate group of the block
+    inPortTranslation[ block.name + "/__dt" ] = LogicEngine::clockName( groupOf( block ) );
     
     DirecetedGraph_t::in_edge_iterator begin, end;
     for( boost::tie(begin, end) = boost::in_edges( *i, g ); begin != end; begin++ )
@@ -133,8 +231,19 @@ Graph::Graph( istream& stream )
       const auto& libSource = libLookup( source );
       inPortTranslation[ block.name + "/" + libBlock.inPorts.at( g[*begin].toPort ).name ] = source.name + "/" + libSource.outPorts.at( g[*begin].fromPort ).name;
     }
-    stringstream impl( doInit ? init : implementation );
-    le->import_noGrAF( impl, true, block.name + "/", inPortTranslation );
+    // the library block was parsed already, only a block with instructions
+    // of its own - like a state copy - has to be parsed here
+    const string& own = doInit ? block.init : block.implementation;
+    const LogicEngine::program_t ownProgram = "" == own ? LogicEngine::program_t() : LogicEngine::parse_noGrAF( own );
+    const LogicEngine::program_t& program = "" != own ? ownProgram 
+      : ( doInit ? libBlock.initProgram : libBlock.implementationProgram );
+    le->import_noGrAF( program, true, block.name + "/", inPortTranslation );
+    
+    // the variables of an implementation keep their values between the runs
+    if( !doInit )
+      for( auto statement = program.statements.cbegin(); statement != program.statements.cend(); ++statement )
+        if( nullptr == statement->create )
+          le->markState( block.name + "/" + statement->operands.front().text );
   };
   
   // Setup the normal logic initialization
@@ -147,72 +256,335 @@ Graph::Graph( istream& stream )
   }
   le->markStartOfLogic();
   
-  // Setup the state copies first
-  for( auto i = topo_order.crbegin(); i != topo_order.crend(); ++i )
+  // Setup each rate group on its own: a block reading the result of another
+  // group sees the last result of that group
+  for( size_t group = 0; group < rates.size(); ++group )
   {
-    if( !g[*i].isStateCopy )
-      continue;
+    le->markStartOfGroup( rates[ group ] );
+    
+    // Setup the state copies first
+    for( auto i = topo_order.crbegin(); i != topo_order.crend(); ++i )
+    {
+      if( !g[*i].isStateCopy || groupOf( g[*i] ) != group )
+        continue;
+      
+      le->markStartOfBlock( g[*i].name );
+      setupLogicEngine( i, false );
+    }
+    
+    // Setup the normal logic afterwards
+    for( auto i = topo_order.crbegin(); i != topo_order.crend(); ++i )
+    {
+      if( g[*i].isStateCopy || groupOf( g[*i] ) != group )
+        continue;
+      
+      le->markStartOfBlock( g[*i].name );
+      setupLogicEngine( i, false );
+    }
+  }
+  if( 1 < rates.size() )
+  {
+    logger << "Graph " << this << ": " << rates.size() << " rate groups\n"; logger.show();
+  }
+  
+  Optimizer optimizer( *le );
+  if( meta.at( "optimize" ).getBool() )
+  {
+    // the results are only observed by the sends (part of the logic) and
+    // by the scopes and displays
+    vector<string> observed;
+    Graph::DirecetedGraph_t::vertex_iterator vi, vi_end;
+    for( boost::tie( vi, vi_end ) = boost::vertices( g ); vi != vi_end; ++vi )
+    {
+      const auto &block = g[*vi];
+      if( !boost::algorithm::ends_with( block.type, "/scope" ) && !boost::algorithm::ends_with( block.type, "/display" ) )
+        continue;
+      
+      DirecetedGraph_t::in_edge_iterator begin, end;
+      for( boost::tie(begin, end) = boost::in_edges( *vi, g ); begin != end; begin++ )
+      {
+        const auto& source = g[ boost::source( *begin, g ) ];
+        observed.push_back( source.name + "/" + libLookup( source ).outPorts.at( g[*begin].fromPort ).name );
+      }
+    }
     
-    setupLogicEngine( i, false );
+    size_t folded  = optimizer.fold();
+    size_t merged  = optimizer.merge();
+    size_t removed = optimizer.eliminate( observed );
+    // shared slots would make the blocks depend on each other
+    size_t saved   = meta.at( "parallel" ).getBool() ? 0 : optimizer.allocate( observed );
+    logger << "Graph " << this << ": optimizing folded " << folded << " constant instructions, merged " 
+           << merged << " common subexpressions, removed " << removed << " dead instructions and saved " 
+           << saved << " variable slots\n"; logger.show();
   }
+  size_t fused = optimizer.fuse();
+  logger << "Graph " << this << ": fusing to superinstructions removed " << fused << " of " << instructions << " instructions\n"; logger.show();
+}
+
+void Graph::prepare( void )
+{
+  le->setTracing( meta.at( "trace" ).getBool() );
+  le->setProfiling( meta.at( "profile" ).getBool() );
+  le->setBudget( meta.at( "budget" ).getInt() );
+  le->setPriority( meta.at( "priority" ).getInt() );
   
-  // Setup the normal logic afterwards
-  for( auto i = topo_order.crbegin(); i != topo_order.crend(); ++i )
+  Optimizer optimizer( *le );
+  if( meta.at( "incremental" ).getBool() )
   {
-    if( g[*i].isStateCopy )
-      continue;
+    size_t blocks = optimizer.dependencies();
+    if( 0 == blocks )
+      logger << "Graph " << this << ": no incremental execution possible, always running the whole logic\n";
+    else
+      logger << "Graph " << this << ": incremental execution of " << blocks << " blocks\n";
+    logger.show();
     
-    setupLogicEngine( i, false );
+    if( 0 < blocks && meta.at( "parallel" ).getBool() )
+    {
+      le->setTaskPool( &taskPool() );
+      logger << "Graph " << this << ": running the blocks in parallel on " << taskPool().size() << " threads\n"; logger.show();
+    }
+  }
+  
+  const string backend = meta.at( "backend" ).getString();
+  if( "bytecode" == backend )
+    le->setBackend( LogicEngine::BYTECODE );
+  else if( "virtual" == backend )
+    le->setBackend( LogicEngine::VIRTUAL );
+  else
+    throw JSON::parseError( "Unknown backend '" + backend + "'!", __LINE__ ,__FILE__ );
+  
+  // use the ahead of time compiled logic when it exists
+  if( !nativePath.empty() && LogicEngine::VIRTUAL != le->getBackend() )
+  {
+    const string key = le->nativeKey();
+    if( le->loadNative( nativePath ) )
+      logger << "Graph " << this << ": using native code '" << NativeCode::fileName( key ) << "'\n";
+    else
+      logger << "Graph " << this << ": no native code '" << NativeCode::fileName( key ) << "' found, interpreting\n";
+    logger.show();
   }
   
   bool prepareLE = le->enableVariables() && le->startLogic();
   ASSERT_MSG( prepareLE, "ERROR: couldn't set state to run LogicEngine init!" );
- logger << le->export_noGrAF() << "\n";logger.show(); // FIXME delete
- le->dump();// FIXME delete
+  if( le->isTracing() )
+  {
+    logger << le->export_noGrAF() << "\n"; logger.show();
+    le->dump();
+  }
   le->run_init();
   
   bool finishLE = le->stopLogic();
   ASSERT_MSG( finishLE, "ERROR: couldn't set state to Stop after LogicEngine init!" );
+  
+  // the same logic for many rooms, devices, ... - each instance reads the
+  // imports with "%i" replaced by its number
+  const int instances = meta.at( "instances" ).getInt();
+  if( 0 < instances )
+  {
+    batch = new BatchEngine( *le, instances );
+    le->setBatch( batch );
+    logger << "Graph " << this << ": running " << instances << " instances at once\n"; logger.show();
+  }
+  
+  logger << "Graph " << this << ": " << le->elementMemory() << " bytes of elements, " 
+         << le->variableMemory() << " bytes of variables, all graphs: " 
+         << VariableArena::used() << " bytes used of " << VariableArena::reserved() << " reserved\n"; logger.show();
+}
+
+bool Graph::storeCache( GraphCache::Writer& out ) const
+{
+  out.put<uint32_t>( meta.size() );
+  for( auto it = meta.cbegin(); it != meta.cend(); ++it )
+  {
+    out.put( it->first );
+    out.put<uint8_t>( it->second.getType() );
+    switch( it->second.getType() )
+    {
+      case variableType::BOOL  : out.put<uint8_t>( it->second.getBool() ); break;
+      case variableType::INT   : out.put<int32_t>( it->second.getInt() ); break;
+      case variableType::FLOAT : out.put<float>( it->second.getFloat() ); break;
+      case variableType::STRING: out.put( it->second.getString() ); break;
+      default:
+        return false;
+    }
+  }
+  
+  out.put<uint32_t>( rates.size() );
+  for( auto rate = rates.cbegin(); rate != rates.cend(); ++rate )
+    out.put<float>( *rate );
+  
+  return le->exportCompiled( out );
+}
+
+bool Graph::loadCache( uint64_t key )
+{
+  GraphCache cache( cachePath, key );
+  if( !cache.valid() )
+    return false;
+  
+  try
+  {
+    GraphCache::Reader in = cache.reader();
+    
+    // only taken when everything could be read
+    map<string, variable_t> values( meta );
+    for( uint32_t entries = in.get<uint32_t>(); 0 < entries; --entries )
+    {
+      const string name = in.getString();
+      auto entry = values.find( name );
+      if( values.end() == entry )
+        throw JSON::parseError( "Meta entry '" + name + "' not known!", __LINE__ ,__FILE__ );
+      
+      switch( in.get<uint8_t>() )
+      {
+        case variableType::BOOL  : entry->second = variable_t( 0 != in.get<uint8_t>() ); break;
+        case variableType::INT   : entry->second = variable_t( static_cast<int>( in.get<int32_t>() ) ); break;
+        case variableType::FLOAT : entry->second = variable_t( in.get<float>() ); break;
+        case variableType::STRING: entry->second = variable_t( in.getString() ); break;
+        default:
+          throw JSON::parseError( "Meta entry '" + name + "' has an unknown type!", __LINE__ ,__FILE__ );
+      }
+    }
+    
+    vector<float> groupRates;
+    for( uint32_t entries = in.get<uint32_t>(); 0 < entries; --entries )
+      groupRates.push_back( in.get<float>() );
+    
+    logicengines.emplace_back( in );
+    le = &(logicengines.back());
+    meta.swap( values );
+    rates.swap( groupRates );
+  }
+  catch( JSON::parseError e )
+  {
+    logger( Logger::WARN ) << "Graph " << this << ": compiled logic '" << GraphCache::fileName( cachePath, key ) 
+                           << "' not used, error \"" << e.text << "\"\n"; logger.show();
+    return false;
+  }
+  
+  return true;
 }
 
 Graph::~Graph()
 { 
+  delete checkpoint; // writes the last state
+  delete snapshot;
+  delete batch;
   //if( nullptr != le )
   //  delete le;
-  if( nullptr != scheduler )
+  for( auto scheduler = schedulers.begin(); scheduler != schedulers.end(); ++scheduler )
   {
-    delete scheduler;
+    delete *scheduler;
   }
 }
 
 Graph::Graph( Graph&& other )
 : g( std::move( other.g ) ),
-  blockLookup( std::move( blockLookup ) ),
+  blockLookup( std::move( other.blockLookup ) ),
+  unparsed( std::move( other.unparsed ) ),
   meta( std::move( other.meta ) ),
   logicengines( std::move( other.logicengines ) ),
-  scheduler( nullptr )
+  rates( std::move( other.rates ) ),
+  checkpoint( nullptr ),
+  snapshot( nullptr ),
+  batch( nullptr )
   //le( nullptr )
 {
+  std::swap( checkpoint, other.checkpoint );
+  std::swap( snapshot, other.snapshot );
+  std::swap( batch, other.batch );
   //std::swap( le, other.le );
   le = &(logicengines.back());
   //std::swap( scheduler, other.scheduler );
-  if( nullptr != other.scheduler )
+  boost::asio::io_service* io_service = nullptr;
+  other.alive.reset();
+  for( auto scheduler = other.schedulers.begin(); scheduler != other.schedulers.end(); ++scheduler )
+  {
+    if( nullptr == *scheduler )
+      continue;
+    (*scheduler)->cancel();
+    io_service = &(*scheduler)->get_io_service();
+  }
+  if( nullptr != io_service )
   {
-    other.scheduler->cancel();
     //logger << "Starting schedule in " << this << " Move from "<< &other <<"\n"; logger.show();
-    schedule( other.scheduler->get_io_service() );
-    //scheduler->get_io_service().poll();
-    //delete other.scheduler;
-    //other.scheduler = 0;
+    schedule( *io_service );
   }
 }
 
-void Graph::init( boost::asio::io_service& io_service )
+void Graph::init( boost::asio::io_service& io_service, const std::string& name, bool restore )
 {
   logger << "Init Graph " << this << "\n"; logger.show();
+  
+  // continue with the state of the last time - a negative period disables
+  // the checkpoint. The state of the instances of a batch isn't in the
+  // variables of the logic, so there's neither a checkpoint nor a snapshot
+  if( nullptr != batch && ( !checkpointPath.empty() || exportSnapshots ) )
+  {
+    logger( Logger::WARN ) << "Graph " << this << ": no checkpoint and no snapshot of the instances\n"; logger.show();
+  }
+  const float period = meta.at( "checkpoint" ).getFloat();
+  if( nullptr == batch && !checkpointPath.empty() && !name.empty() && 0.0f <= period )
+  {
+    const string file = checkpointPath + "/" + name + ".checkpoint";
+    checkpoint = new Checkpoint( file, le->stateKey(), le->stateSize() );
+    le->setCheckpoint( checkpoint, period );
+    if( restore )
+    {
+      if( le->restoreCheckpoint() )
+        logger << "Graph " << this << ": restored the state from '" << file << "'\n";
+      else
+        logger << "Graph " << this << ": no state in '" << file << "' to restore\n";
+      logger.show();
+    }
+  }
+  
+  // the values for the monitoring
+  if( nullptr == batch )
+  {
+    snapshot = new Snapshot( le->layoutKey(), le->variablesSize(), le->snapshotTable(),
+                             exportSnapshots && !name.empty() ? "/GrAFd." + name : "" );
+    le->setSnapshot( snapshot );
+  }
+  
+  // sleeps and sends don't block a thread of the worker
+  if( nullptr != outbox )
+    le->setOutbox( outbox );
+  if( nullptr != awaiter )
+    le->setAwaitHandler( []( LogicEngine* le, const LogicElement_Generic::await_t& wait ){
+      awaiter->await( le, wait );
+    });
+  
+  // a run that used up its budget lets the more important logics go first
+  if( nullptr != runQueue )
+    le->setYieldHandler( []( LogicEngine* le ){
+      runQueue->yield( le );
+    });
+  
   schedule( io_service );
 }
 
+bool Graph::showProfile( std::ostream& out ) const
+{
+  if( !le->isProfiling() )
+    return false;
+  
+  std::vector<LogicEngine::profile_t> elements;
+  std::map<std::string, LogicEngine::profile_t> perBlock;
+  le->getProfile( elements, perBlock );
+  
+  out << "{\n  \"blocks\": {";
+  for( auto it = perBlock.cbegin(); it != perBlock.cend(); ++it )
+    out << ( perBlock.cbegin() == it ? "\n    " : ",\n    " ) << JSON::escape( it->first ) 
+        << ": { \"count\": " << it->second.count << ", \"cycles\": " << it->second.cycles << " }";
+  out << "\n  },\n  \"instructions\": [";
+  for( size_t i = 0; i < elements.size(); ++i )
+    out << ( 0 == i ? "\n    " : ",\n    " ) 
+        << "{ \"count\": " << elements[i].count << ", \"cycles\": " << elements[i].cycles << " }";
+  out << "\n  ]\n}";
+  return true;
+}
+
 void Graph::dump( void ) const
 {
   le->dump();
@@ -221,12 +593,12 @@ void Graph::dump( void ) const
   logger.show();
 }
 
-void Graph::parseString( istream& in )
+void Graph::parseString( JSON::buffer& in )
 {
   try
   {
     in >> JSON::consumeEmpty;
-    JSON::readJsonObject( in, [this]( istream& in1, const string& section )
+    JSON::readJsonObject( in, [this]( JSON::buffer& in1, const JSON::stringRef& section )
     {
       in1 >> JSON::consumeEmpty;
       if( "meta" == section )
@@ -245,7 +617,7 @@ void Graph::parseString( istream& in )
         throw( JSON::parseError( "Bad file structure, only 'blocks' and 'signals' allowed!", in1, __LINE__ ,__FILE__ ) );
     } );
   }
-  catch( JSON::parseError e )
+  catch( JSON::parseError& e )
   {
     int lineNo, errorPos;
     string wrongLine = e.getErrorLine( lineNo, errorPos ) ;
@@ -256,13 +628,14 @@ void Graph::parseString( istream& in )
       logger << " ";
     logger << "-^-" << endl;
     logger.show();
+    throw; // a broken graph mustn't be used
   }
 }
 
-void Graph::grepMeta( istream& in )
+void Graph::grepMeta( JSON::buffer& in )
 {
-  JSON::readJsonObject( in, [this]( istream& in1, const string& name ){
-    auto entry = meta.find( name );
+  JSON::readJsonObject( in, [this]( JSON::buffer& in1, const JSON::stringRef& name ){
+    auto entry = meta.find( name.str() );
     if( meta.end() == entry )
       throw JSON::parseError( "Meta entry '" + name + "' not known!", in1, __LINE__ ,__FILE__ );
     
@@ -276,19 +649,11 @@ void Graph::grepMeta( istream& in )
         switch( entry->second.getType() )
         {
           case variableType::INT:
-            {
-              int value;
-              in1 >> value;
-              entry->second = variable_t( value );
-            }
+            entry->second = variable_t( JSON::readJsonNumber<int>( in1 ) );
             break;
             
           case variableType::FLOAT:
-            {
-              float value;
-              in1 >> value;
-              entry->second = variable_t( value );
-            }
+            entry->second = variable_t( JSON::readJsonNumber<float>( in1 ) );
             break;
             
           default:
@@ -306,41 +671,68 @@ void Graph::grepMeta( istream& in )
   });
 }
 
-void handle_schedule_call( const boost::system::error_code& error, const Graph* graph )
+void handle_schedule_call( const boost::system::error_code& error, const std::weak_ptr<const Graph*>& alive, size_t group )
 {
-  logger << "TIME - LE called, error: '" << error << "' = '"<< error.message() <<"'; scheduler: "<< graph->scheduler<< "\n"; logger.show();
-  
-  if( boost::asio::error::operation_aborted == error )
+  // the graph might be gone already, e.g. replaced by a newer version - the
+  // timer might have expired before, so the handler was queued uncancelled
+  const std::shared_ptr<const Graph*> self = alive.lock();
+  if( boost::asio::error::operation_aborted == error || !self )
     return;
-
-  bool prepareLE = graph->le->enableVariables(); //startLogic()
-  ASSERT_MSG( prepareLE, "Couldn't set LogicEngine state from STOPPED to COPIED (is: " << LogicEngine::logicStateName[graph->le->getState()] << ")" );
+  const Graph* graph = *self;
   
-  worker->enque_task( graph->le );
+  if( graph->le->isTracing() )
+  {
+    logger << "TIME - LE called for group " << group << ", error: '" << error << "' = '"<< error.message() <<"'; scheduler: "<< graph->schedulers[ group ] << "\n"; logger.show();
+  }
+
+  graph->le->scheduleGroup( group );
+  if( graph->le->enableVariables() ) //startLogic()
+    worker->enque_task( graph->le );
+  else
+  {
+    graph->le->scheduleRerun(); // busy with another group, this one will follow
+    // unless the run has just finished without seeing the rerun
+    if( graph->le->enableVariables() )
+      worker->enque_task( graph->le );
+  }
   
   // schedule next run
-  if( nullptr != graph->scheduler )
+  Graph::scheduler_t* scheduler = graph->schedulers[ group ];
+  if( nullptr != scheduler )
   {
-    graph->scheduler->expires_at( graph->scheduler->expires_at() + graph->duration );
-    graph->scheduler->async_wait( bind( handle_schedule_call, placeholders::_1, graph ) );
+    scheduler->expires_at( scheduler->expires_at() + graph->durations[ group ] );
+    scheduler->async_wait( bind( handle_schedule_call, placeholders::_1, alive, group ) );
   }
 }
 
 void Graph::schedule( boost::asio::io_service& io_service )
 {
-  auto step_size = meta.at( "step-size" ).getFloat();
-  if( 0.0 < step_size )
+  alive = std::make_shared<const Graph*>( this );
+  schedulers.assign( rates.size(), nullptr );
+  durations.assign( rates.size(), scheduler_t::duration::zero() );
+  for( size_t group = 0; group < rates.size(); ++group )
   {
-    logger << "Register LE "<<le<<" with cycle time of " << step_size << " (scheduler: "<<scheduler<<") in Graph "<<this<<"\n"; logger.show();
+    if( 0.0 >= rates[ group ] )
+      continue;
     
-    duration = std::chrono::duration_cast<scheduler_t::duration>( chrono::duration<float, ratio<1>>{ step_size } );
-    scheduler = new scheduler_t( io_service, duration );
-    scheduler->async_wait( bind( handle_schedule_call, placeholders::_1, this ) );
+    logger << "Register LE "<<le<<" group " << group << " with cycle time of " << rates[ group ] << " in Graph "<<this<<"\n"; logger.show();
+    
+    durations[ group ] = std::chrono::duration_cast<scheduler_t::duration>( chrono::duration<float, ratio<1>>{ rates[ group ] } );
+    schedulers[ group ] = new scheduler_t( io_service, durations[ group ] );
+    schedulers[ group ]->async_wait( bind( handle_schedule_call, placeholders::_1, std::weak_ptr<const Graph*>( alive ), group ) );
   }
 }
 
 std::ostream& operator<<( std::ostream &stream, Graph& graph )
 {
+  if( !graph.unparsed.empty() )
+  {
+    // the logic came from the cache, the structure wasn't needed before
+    JSON::buffer in( graph.unparsed );
+    graph.parseString( in );
+    graph.unparsed.clear();
+  }
+  
   stream << "{\n  \"blocks\": {\n";
 
   Graph::DirecetedGraph_t::vertex_iterator vi, vi_end;
@@ -24,6 +24,7 @@
 #include <map>
 #include <istream>
 #include <chrono>
+#include <memory>
 
 #include <boost/asio.hpp>
 #include "boost/graph/adjacency_list.hpp"
@@ -58,9 +59,26 @@ public:
   Graph( Graph&& other );         // but move
   
   /**
-   * Run the initialisation and set up the periodic calls.
+   * Run the initialisation and set up the periodic calls. The state saved
+   * for the graph @p name is restored, when checkpointPath is set and
+   * @p restore.
    */
-  void init( boost::asio::io_service& io_service );
+  void init( boost::asio::io_service& io_service, const std::string& name = "", bool restore = true );
+  
+  /**
+   * Return the values of the variables after the last run in @p values.
+   */
+  bool getValues( std::map<std::string, variable_t>& values ) const
+  {
+    return le->takeSnapshot( values );
+  }
+  
+  /**
+   * Write the profile of the logic as JSON to @p out, the counters of each
+   * block and of each instruction.
+   * @return false when the logic isn't profiling, see the meta "profile"
+   */
+  bool showProfile( std::ostream& out ) const;
   
   /**
    * Show the content of the graph.
@@ -69,9 +87,37 @@ public:
   
   /**
    * The library of all known GraphBlock elements.
+   * NOTE: it's only read while the graphs are compiled, so that they can be
+   * compiled by many threads - it mustn't be changed meanwhile. A Block
+   * that is read from its file at the first use is guarded by the GraphLib.
    */
   static GraphLib lib;
   
+  /**
+   * The directory of the shared objects for the NATIVE backend that were
+   * created by graf2cpp - empty when the NATIVE backend shouldn't be used.
+   */
+  static std::string nativePath;
+  
+  /**
+   * The directory where the state of the graphs is saved to and restored
+   * from - empty when it shouldn't be saved.
+   */
+  static std::string checkpointPath;
+  
+  /**
+   * The directory where the compiled logic of the graphs is cached, so that
+   * an unchanged graph isn't compiled again - empty when it shouldn't be
+   * cached, see GraphCache. The index of the libraries is kept there, too.
+   */
+  static std::string cachePath;
+  
+  /**
+   * Export the snapshot of the variables of each graph as shared memory
+   * segment "/GrAFd.<name>", see Snapshot.
+   */
+  static bool exportSnapshots;
+  
   /**
    * Type of the used graph.
    */
@@ -104,9 +150,14 @@ private:
    * NOTE: has to be kept in sync with Block.name!
    */
   blockLookup_t blockLookup;
+  /**
+   * The source of a graph whose logic came from the cache, the structure is
+   * parsed from it when it's shown the first time - empty otherwise.
+   */
+  std::string unparsed;
   
-  void parseString( std::istream& in );
-  void grepMeta( std::istream& in );
+  void parseString( JSON::buffer& in );
+  void grepMeta( JSON::buffer& in );
   
   std::map<std::string, variable_t> meta;
   
@@ -123,11 +174,57 @@ private:
   typedef std::vector<class LogicEngine> logicengines_t;
   logicengines_t logicengines;
 
+  /**
+   * The sample time of each rate group in seconds, the fastest first. 0 is
+   * for a group that is only run by events.
+   */
+  std::vector<float> rates;
+  
+  /**
+   * Where the state of the logic is saved, nullptr when it isn't.
+   */
+  class Checkpoint* checkpoint;
+  
+  /**
+   * Where the variables are published after each run for the monitoring.
+   */
+  class Snapshot* snapshot;
+  
+  /**
+   * Runs the instances of the logic when the meta entry "instances" is
+   * set, nullptr otherwise. Such a graph has no checkpoint and no snapshot.
+   */
+  class BatchEngine* batch;
+  
+  /**
+   * Compile the parsed structure to the logic.
+   */
+  void compile( void );
+  
+  /**
+   * Set up the compiled logic, from the structure or from the cache, and run
+   * its initialisation.
+   */
+  void prepare( void );
+  
+  /**
+   * Write the compiled logic to @p out for the GraphCache.
+   * @return false when it can't be cached
+   */
+  bool storeCache( GraphCache::Writer& out ) const;
+  
+  /**
+   * Take the compiled logic from the GraphCache for the @p key.
+   * @return false when there's none or it can't be used
+   */
+  bool loadCache( uint64_t key );
+  
   typedef boost::asio::basic_waitable_timer< std::chrono::steady_clock > scheduler_t;
-  scheduler_t::duration duration;
-  scheduler_t* scheduler;
+  std::vector<scheduler_t::duration> durations; ///< the period of each rate group
+  std::vector<scheduler_t*> schedulers;         ///< the timer of each rate group, nullptr when only run by events
+  std::shared_ptr<const Graph*> alive;          ///< expires with the Graph, a timer that already fired can't be cancelled
   void schedule( boost::asio::io_service& io_service );
-  friend void handle_schedule_call( const boost::system::error_code& error, const Graph* graph );
+  friend void handle_schedule_call( const boost::system::error_code& error, const std::weak_ptr<const Graph*>& alive, size_t group );
 public: // TODO only a temporary solution...
   class LogicEngine* le;
 };
@@ -49,44 +49,47 @@ string GraphBlock::Port::getType( void ) const
   return "<unknown type>";
 }
 
-void GraphBlock::grepBlock( istream& in, Graph& graph )
+void GraphBlock::grepBlock( JSON::buffer& in, Graph& graph )
 {
-  JSON::readJsonObject( in, [&graph]( istream& in1, const string& name ){
+  JSON::readJsonObject( in, [&graph]( JSON::buffer& in1, const JSON::stringRef& blockName ){
+    const string name = blockName.str();
     graph.blockLookup[ name ] = boost::add_vertex( graph.g );
     GraphBlock& thisBlock = graph.g[ graph.blockLookup[ name ] ];
     thisBlock.name = name;
-    JSON::readJsonObject( in1, [&thisBlock]( istream& in2, const string& key ){
+    JSON::readJsonObject( in1, [&thisBlock]( JSON::buffer& in2, const JSON::stringRef& key ){
       if       ( "type"       == key )
       {
         if( "" == (thisBlock.type = JSON::readJsonString(in2) ) ) throw( JSON::parseError(  "String for block parameter 'type' expected", in2, __LINE__ ,__FILE__ ) );
       } else if( "x"          == key )
       {
-        in2 >> thisBlock.x;
+        thisBlock.layout.x = JSON::readJsonNumber<int>( in2 );
       } else if( "y"          == key )
       {
-        in2 >> thisBlock.y;
+        thisBlock.layout.y = JSON::readJsonNumber<int>( in2 );
       } else if( "width"      == key )
       {
-        in2 >> thisBlock.width;
+        thisBlock.layout.width = JSON::readJsonNumber<int>( in2 );
       } else if( "height"     == key )
       {
-        in2 >> thisBlock.height;
+        thisBlock.layout.height = JSON::readJsonNumber<int>( in2 );
       } else if( "flip"       == key )
       {
-        thisBlock.flip        = JSON::readJsonBool( in2 );
+        thisBlock.layout.flip = JSON::readJsonBool( in2 );
+      } else if( "sample-time" == key )
+      {
+        thisBlock.sampleTime = JSON::readJsonNumber<double>( in2 );
+        if( 0.0 > thisBlock.sampleTime ) throw( JSON::parseError(  "Block parameter 'sample-time' mustn't be negative", in2, __LINE__ ,__FILE__ ) );
       } else if( "parameters" == key )
       {
-        JSON::readJsonObject( in2, [&thisBlock]( istream& in3, const string& key2 ){
+        JSON::readJsonObject( in2, [&thisBlock]( JSON::buffer& in3, const JSON::stringRef& key2 ){
           switch( JSON::identifyNext(in3) )
           {
             case JSON::NUMBER:
-              double number;
-              in3 >> number;
-              thisBlock.parameters[ key2 ] = variable_t( number );
+              thisBlock.parameters[ key2.str() ] = variable_t( JSON::readJsonNumber( in3 ) );
               break;
               
             case JSON::STRING:
-              thisBlock.parameters[ key2 ] = variable_t(  JSON::readJsonString(in3) );
+              thisBlock.parameters[ key2.str() ] = variable_t(  JSON::readJsonString(in3) );
               break;
               
             default:
@@ -108,8 +111,8 @@ void GraphBlock::grepBlock( istream& in, Graph& graph )
     
     // fill the missing parts from the library template
     // TODO: make it dynamic by depending on the real read informations
-    thisBlock.color      = libBlock.color;
-    thisBlock.background = libBlock.background;
+    thisBlock.layout.color      = libBlock.layout.color;
+    thisBlock.layout.background = libBlock.layout.background;
     thisBlock.inPorts    = libBlock.inPorts;
     thisBlock.outPorts   = libBlock.outPorts;
     
@@ -126,6 +129,7 @@ void GraphBlock::grepBlock( istream& in, Graph& graph )
           stateBlock.name = name + ".state";
           stateBlock.isStateCopy = true;
           stateBlock.type = graph.g[ graph.blockLookup[ name ] ].type; //NOTE: "thisBlock" is invalid due to boost::add_vertex( g )
+          stateBlock.sampleTime = graph.g[ graph.blockLookup[ name ] ].sampleTime;
           stateBlock.implementation = instruction;
           blockNotCopyied = false;
         } else {
@@ -138,42 +142,56 @@ void GraphBlock::grepBlock( istream& in, Graph& graph )
 }
 
 
-void GraphBlock::readJsonBlock( std::istream& in, const std::string& blockName )
+void GraphBlock::readJsonBlock( JSON::buffer& in, const std::string& blockName )
 {
   name = blockName;
   
-  JSON::readJsonObject( in, [this]( istream& in1, const string& name ){
+  // the instructions are parsed once for all instances of the block, an
+  // error is shown at the block
+  auto parse = []( JSON::buffer& in1, const string& src ) -> LogicEngine::program_t
+  {
+    try
+    {
+      return LogicEngine::parse_noGrAF( src );
+    }
+    catch( JSON::parseError e )
+    {
+      throw( JSON::parseError( e.text, in1, __LINE__ ,__FILE__ ) );
+    }
+  };
+  
+  JSON::readJsonObject( in, [this, &parse]( JSON::buffer& in1, const JSON::stringRef& name ){
     if( "width" == name )
     {
-      in1 >> width;
+      layout.width = JSON::readJsonNumber<int>( in1 );
     } else if( "height" == name )
     {
-      in1 >> height;
+      layout.height = JSON::readJsonNumber<int>( in1 );
     } else if( "rotation" == name )
     {
-      in1 >> rotation;
+      layout.rotation = JSON::readJsonNumber<int>( in1 );
     } else if( "flip" == name )
     {
-      flip = JSON::readJsonBool( in1 );
+      layout.flip = JSON::readJsonBool( in1 );
     } else if( "color" == name )
     {
       int pos = 0;
-      JSON::readJsonArray( in1, [this, &pos]( istream& in2 ){
-        in2 >> color[pos++];
+      JSON::readJsonArray( in1, [this, &pos]( JSON::buffer& in2 ){
+        layout.color[pos++] = JSON::readJsonNumber( in2 );
         if( pos > 3 ) throw JSON::parseError( "More than three colors found!", in2, __LINE__ ,__FILE__ );
       });
     } else if( "background" == name )
     {
       int pos = 0;
-      JSON::readJsonArray( in1, [this, &pos]( istream& in2 ){
-        in2 >> background[pos++];
+      JSON::readJsonArray( in1, [this, &pos]( JSON::buffer& in2 ){
+        layout.background[pos++] = JSON::readJsonNumber( in2 );
         if( pos > 3 ) throw JSON::parseError( "More than three colors found!", in2, __LINE__ ,__FILE__ );
       });
     } else if( "inPorts" == name )
     {
-      JSON::readJsonArray( in1, [this]( istream& in2 ){
+      JSON::readJsonArray( in1, [this]( JSON::buffer& in2 ){
         Port p;
-        JSON::readJsonObject( in2, [&p]( istream& in3, const string& name ){
+        JSON::readJsonObject( in2, [&p]( JSON::buffer& in3, const JSON::stringRef& name ){
           if( "name" == name )
             p.name = JSON::readJsonString(in3);
           else if( "type" == name )
@@ -185,9 +203,9 @@ void GraphBlock::readJsonBlock( std::istream& in, const std::string& blockName )
       });
     } else if( "outPorts" == name )
     {
-      JSON::readJsonArray( in1, [this]( istream& in2 ){
+      JSON::readJsonArray( in1, [this]( JSON::buffer& in2 ){
         Port p;
-        JSON::readJsonObject( in2, [&p]( istream& in3, const string& name ){
+        JSON::readJsonObject( in2, [&p]( JSON::buffer& in3, const JSON::stringRef& name ){
           if( "name" == name )
             p.name = JSON::readJsonString(in3);
           else if( "type" == name )
@@ -199,9 +217,10 @@ void GraphBlock::readJsonBlock( std::istream& in, const std::string& blockName )
       });
     } else if( "parameters" == name )
     {
-      JSON::readJsonObject( in1, [this]( istream& in2, const string& name ){
+      JSON::readJsonObject( in1, [this]( JSON::buffer& in2, const JSON::stringRef& parameterName ){
+        const string name = parameterName.str();
         string parameterType;
-        JSON::readJsonObject( in2, [this, &name, &parameterType]( istream& in3, const string& key ){
+        JSON::readJsonObject( in2, [this, &name, &parameterType]( JSON::buffer& in3, const JSON::stringRef& key ){
           if( "type" == key )
             parameterType = JSON::readJsonString(in3);
           else if( "default" == key )
@@ -209,9 +228,7 @@ void GraphBlock::readJsonBlock( std::istream& in, const std::string& blockName )
             auto t = JSON::identifyNext( in3 ); // FIXME nur temporaer hier
             if( "float" == parameterType )
             {
-              double number;
-              in3 >> number;
-              parameters[name] = variable_t( number );
+              parameters[name] = variable_t( JSON::readJsonNumber( in3 ) );
             } else if( "string" == parameterType )
             {
               parameters[name] = variable_t( JSON::readJsonString(in3) );
@@ -226,9 +243,11 @@ void GraphBlock::readJsonBlock( std::istream& in, const std::string& blockName )
     } else if( "init" == name )
     {
       init = JSON::readJsonString( in1 );
+      initProgram = parse( in1, init );
     } else if( "implementation" == name )
     {
       implementation = JSON::readJsonString( in1 );
+      implementationProgram = parse( in1, implementation );
     } else {
       throw( JSON::parseError( "Unknown key '"+name+"' for block", in1, __LINE__ ,__FILE__ ) );
     }
@@ -246,14 +265,19 @@ ostream& operator<<( ostream &out, const GraphBlock& block )
   
   out
   << "      \"type\"      : \"" << block.type   << "\",\n"
-  << "      \"x\"         : " << block.x        << ",\n"
-  << "      \"y\"         : " << block.y        << ",\n"
-  << "      \"width\"     : " << block.width    << ",\n"
-  << "      \"height\"    : " << block.height   << ",\n"
-  << "      \"rotation\"  : " << block.rotation << ",\n"
-  << "      \"flip\"      : " << (block.flip?"true":"false") << ",\n"
-  << "      \"color\"     : [ " << block.color[0]      << ", " << block.color[1]      << ", " << block.color[2]      << " ],\n"
-  << "      \"background\": [ " << block.background[0] << ", " << block.background[1] << ", " << block.background[2] << " ],\n"
+  << "      \"x\"         : " << block.layout.x        << ",\n"
+  << "      \"y\"         : " << block.layout.y        << ",\n"
+  << "      \"width\"     : " << block.layout.width    << ",\n"
+  << "      \"height\"    : " << block.layout.height   << ",\n"
+  << "      \"rotation\"  : " << block.layout.rotation << ",\n"
+  << "      \"flip\"      : " << (block.layout.flip?"true":"false") << ",\n";
+  
+  if( block.showAsLogic && 0.0 != block.sampleTime )
+    out << "      \"sample-time\": " << block.sampleTime << ",\n";
+  
+  out
+  << "      \"color\"     : [ " << block.layout.color[0]      << ", " << block.layout.color[1]      << ", " << block.layout.color[2]      << " ],\n"
+  << "      \"background\": [ " << block.layout.background[0] << ", " << block.layout.background[1] << ", " << block.layout.background[2] << " ],\n"
   << "      \"inPorts\"   : [";
   for( auto it = block.inPorts.cbegin(); it != block.inPorts.cend(); it++ )
   {
@@ -27,6 +27,8 @@
 #include <boost/concept_check.hpp>
 
 #include "variabletype.hpp"
+#include "json.hpp"
+#include "logicengine.hpp"
 
 class Graph;
 
@@ -36,13 +38,13 @@ class Graph;
 struct GraphBlock
 {
   /**
-   * Fill the GraphBlock from a JSON structure in the std::istream at @p in - used for library.
+   * Fill the GraphBlock from a JSON structure in the buffer at @p in - used for library.
    */
-  void readJsonBlock( std::istream& in, const std::string& blockName );
+  void readJsonBlock( JSON::buffer& in, const std::string& blockName );
   /**
    * Read a GraphBlock from @p in and insert it in the @p graph - used for logic.
    */
-  static void grepBlock( std::istream& in, Graph& graph );
+  static void grepBlock( JSON::buffer& in, Graph& graph );
   
   const GraphBlock& show( bool asLogic, bool cont )
   {
@@ -79,22 +81,33 @@ struct GraphBlock
     std::string getType( void ) const;
   };
   
+  /**
+   * How the block is shown in the editor - it isn't needed to run it.
+   */
+  struct Layout
+  {
+    int x;            ///< x position of the block, NOTE: only used for Graph
+    int y;            ///< y position of the block, NOTE: only used for Graph
+    int width;        ///< width of the block
+    int height;       ///< height of the block
+    int rotation;     ///< rotation of the block
+    bool flip;        ///< is the block flipped?
+    std::array<double, 3> color;      ///< color of the block
+    std::array<double, 3> background; ///< background color of the block
+  };
+  
   std::string name; ///< Name of the block, NOTE: only used for Graph - there it has to be kept in sync with blockLookup!
   std::string type; ///< Type of the block, NOTE: only used for Graph
   bool isStateCopy; ///< Is the block a copy due to a state, NOTE: only used for Graph
-  int x;            ///< x position of the block, NOTE: only used for Graph
-  int y;            ///< y position of the block, NOTE: only used for Graph
-  int width;        ///< width of the block
-  int height;       ///< height of the block
-  int rotation;     ///< rotation of the block
-  bool flip;        ///< is the block flipped?
-  std::array<double, 3> color;      ///< color of the block
-  std::array<double, 3> background; ///< background color of the block
+  double sampleTime;///< sample time of the block in seconds, 0 for the step-size of the graph, NOTE: only used for Graph
+  Layout layout;                    ///< editor metadata of the block
   std::vector<Port> inPorts;        ///< inPorts of the block
   std::vector<Port> outPorts;       ///< outPorts of the block
   std::map<std::string, variable_t> parameters; ///< parameters of the block
   std::string init;                 ///< Init task instructions of the block
   std::string implementation;       ///< Main taks instructions of the block
+  LogicEngine::program_t initProgram;           ///< init parsed once, NOTE: only used for library
+  LogicEngine::program_t implementationProgram; ///< implementation parsed once, NOTE: only used for library
   
   bool showAsLogic;
   bool showContinue;
@@ -0,0 +1,129 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "graphcache.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "logger.hpp"
+#include "checkpoint.hpp"
+
+/**
+ * The identification of the file, increase the version when the content
+ * written by the Graph or the LogicEngine changes or when the compiled
+ * result of a graph changes, e.g. by a new pass of the Optimizer or a
+ * changed LogicElement - it's part of the key().
+ */
+static const char     cacheMagic[8] = { 'G', 'r', 'A', 'F', 'd', 'G', 'C', '\0' };
+static const uint32_t cacheVersion  = 3;
+
+GraphCache::GraphCache( const std::string& path, uint64_t key, const std::string& prefix )
+: map( MAP_FAILED ), mapSize( 0 ), content( nullptr ), size( 0 )
+{
+  const std::string name = fileName( path, key, prefix );
+  const int file = ::open( name.c_str(), O_RDONLY );
+  if( -1 == file )
+    return;
+  
+  struct stat status;
+  if( -1 == fstat( file, &status ) || static_cast<size_t>( status.st_size ) < sizeof( header_t ) )
+  {
+    ::close( file );
+    return;
+  }
+  
+  mapSize = status.st_size;
+  map = mmap( nullptr, mapSize, PROT_READ, MAP_PRIVATE, file, 0 );
+  ::close( file ); // the mapping stays valid
+  if( MAP_FAILED == map )
+    return;
+  
+  header_t header;
+  std::memcpy( &header, map, sizeof( header ) );
+  if( 0 == std::memcmp( header.magic, cacheMagic, sizeof( cacheMagic ) )
+   && cacheVersion == header.version
+   && key == header.key
+   && mapSize - sizeof( header_t ) == header.size )
+  {
+    content = static_cast<const raw_t*>( map ) + sizeof( header_t );
+    size    = header.size;
+  }
+  else
+  {
+    logger( Logger::WARN ) << "GraphCache: '" << name << "' doesn't match, ignoring it\n"; logger.show();
+  }
+}
+
+GraphCache::~GraphCache()
+{
+  if( MAP_FAILED != map )
+    munmap( map, mapSize );
+}
+
+bool GraphCache::store( const std::string& path, uint64_t key, const Writer& content, const std::string& prefix )
+{
+  header_t header;
+  std::memset( &header, 0, sizeof( header ) );
+  std::memcpy( header.magic, cacheMagic, sizeof( cacheMagic ) );
+  header.version = cacheVersion;
+  header.key     = key;
+  header.size    = content.data().size();
+  
+  // write to a temporary file of this thread and replace the old one by it
+  // afterwards, so that a graph compiled at the same time or a crash can't
+  // leave a broken file
+  const std::string name      = fileName( path, key, prefix );
+  const std::string temporary = name + "." + std::to_string( getpid() ) + "." 
+                              + std::to_string( std::hash<std::thread::id>()( std::this_thread::get_id() ) );
+  const int file = ::open( temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  bool success = -1 != file
+              && sizeof( header ) == static_cast<size_t>( ::write( file, &header, sizeof( header ) ) )
+              && header.size == static_cast<size_t>( ::write( file, content.data().data(), header.size ) );
+  if( -1 != file )
+    ::close( file );
+  success = success && 0 == std::rename( temporary.c_str(), name.c_str() );
+  
+  if( !success )
+  {
+    std::remove( temporary.c_str() );
+    logger( Logger::WARN ) << "GraphCache: can't write '" << name << "'\n"; logger.show();
+  }
+  return success;
+}
+
+uint64_t GraphCache::key( const std::string& graph, uint64_t libraries )
+{
+  std::stringstream source;
+  source << cacheVersion << " " << libraries << "\n" << graph;
+  return Checkpoint::hash( source.str() );
+}
+
+std::string GraphCache::fileName( const std::string& path, uint64_t key, const std::string& prefix )
+{
+  std::stringstream name;
+  name << path << "/" << prefix << std::hex << std::setw( 16 ) << std::setfill( '0' ) << key << ".grafc";
+  return name.str();
+}
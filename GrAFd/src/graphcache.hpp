@@ -0,0 +1,204 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GRAPHCACHE_HPP
+#define GRAPHCACHE_HPP
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include "globals.h"
+#include "json.hpp"
+
+/**
+ * The GraphCache holds the compiled result of a Graph in a file, so that a
+ * restart doesn't have to parse and compile the graph again: the
+ * instructions, the layout and the initial values of the variables, the
+ * rate groups and blocks, and the imported variables.
+ * 
+ * The file is identified by the key(), a hash of the graph, the libraries
+ * and the version of the format. It's memory mapped while it's read, the format is the
+ * native one of the machine, as it's only a cache.
+ */
+class GraphCache
+{
+public:
+  /**
+   * Collects the content of a cache file.
+   */
+  class Writer
+  {
+  public:
+    /**
+     * Append the plain @p value.
+     */
+    template<typename T>
+    void put( const T& value )
+    {
+      content.append( reinterpret_cast<const char*>( &value ), sizeof( T ) );
+    }
+    
+    /**
+     * Append the @p text with its length.
+     */
+    void put( const std::string& text )
+    {
+      put<uint32_t>( text.size() );
+      content.append( text );
+    }
+    
+    /**
+     * Append @p size raw bytes from @p data.
+     */
+    void put( const raw_t* const data, size_t size )
+    {
+      content.append( reinterpret_cast<const char*>( data ), size );
+    }
+    
+    const std::string& data( void ) const
+    {
+      return content;
+    }
+  
+  private:
+    std::string content;
+  };
+  
+  /**
+   * Reads the content of a cache file in the order it was written, throws
+   * a JSON::parseError when reading behind its end.
+   */
+  class Reader
+  {
+  public:
+    Reader( const raw_t* const begin, const raw_t* const end ) : pos( begin ), last( end ) {}
+    
+    /**
+     * Read a plain value.
+     */
+    template<typename T>
+    T get( void )
+    {
+      T value;
+      std::memcpy( &value, take( sizeof( T ) ), sizeof( T ) );
+      return value;
+    }
+    
+    /**
+     * Read a text with its length.
+     */
+    std::string getString( void )
+    {
+      const uint32_t size = get<uint32_t>();
+      return std::string( reinterpret_cast<const char*>( take( size ) ), size );
+    }
+    
+    /**
+     * Copy @p size raw bytes to @p data.
+     */
+    void get( raw_t* const data, size_t size )
+    {
+      std::memcpy( data, take( size ), size );
+    }
+  
+  private:
+    const raw_t* pos;
+    const raw_t* const last;
+    
+    const raw_t* take( size_t size )
+    {
+      if( size > static_cast<size_t>( last - pos ) )
+        throw( JSON::parseError( "Graph cache is truncated!", __LINE__ ,__FILE__ ) );
+      const raw_t* const data = pos;
+      pos += size;
+      return data;
+    }
+  };
+  
+  /**
+   * Constructor - map the cache file for @p key from the directory @p path,
+   * its name starts with @p prefix.
+   */
+  GraphCache( const std::string& path, uint64_t key, const std::string& prefix = "grafd_" );
+  GraphCache( const GraphCache& ) = delete; // no copy
+  
+  /**
+   * Destructor - unmap the file.
+   */
+  ~GraphCache();
+  
+  /**
+   * Return true when the file exists and was written for the key.
+   */
+  bool valid( void ) const
+  {
+    return nullptr != content;
+  }
+  
+  /**
+   * Return a Reader of the content, only when valid().
+   */
+  Reader reader( void ) const
+  {
+    return Reader( content, content + size );
+  }
+  
+  /**
+   * Write the @p content of the cache file for @p key to the directory
+   * @p path, replacing an older one atomically. Its name starts with
+   * @p prefix.
+   * @return false on error
+   */
+  static bool store( const std::string& path, uint64_t key, const Writer& content,
+                     const std::string& prefix = "grafd_" );
+  
+  /**
+   * Return the key of the graph with the source @p graph that was compiled
+   * with the libraries that have the key @p libraries, see GraphLib::key().
+   * The version of the format is part of it, so that a changed compiler
+   * isn't using the results of the old one.
+   */
+  static uint64_t key( const std::string& graph, uint64_t libraries );
+  
+  /**
+   * Return the name of the cache file for @p key in the directory @p path,
+   * starting with @p prefix - other things than graphs use their own.
+   */
+  static std::string fileName( const std::string& path, uint64_t key, const std::string& prefix = "grafd_" );
+
+private:
+  /**
+   * The start of the file.
+   */
+  struct header_t
+  {
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t size;
+  };
+  
+  void*        map;      ///< the mapped file
+  size_t       mapSize;
+  const raw_t* content;  ///< behind the header, nullptr when not valid
+  size_t       size;
+};
+
+#endif // GRAPHCACHE_HPP
@@ -16,15 +16,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#define BOOST_FILESYSTEM_NO_DEPRECATED
-
 #include "graphlib.hpp"
 
-//#include <iostream>
-#include <fstream>
-
-#include <boost/filesystem.hpp>
-
 #include "globals.h"
 
 #include "json.hpp"
@@ -32,48 +25,66 @@
 
 using namespace std;
 
-bool GraphLib::addPath( const string& path )
+bool GraphLib::addPath( const string& path, const string& cache )
 {
-  using namespace boost::filesystem;
-  if( exists( path ) && is_directory( path ) )
-  {
-    for( auto file = directory_iterator( path ); file != directory_iterator(); file++ )
-    {
-      if( ".graflib" == file->path().extension() )
-        addSource( file->path().string() );
-    }
-    return true;
-  }
+  lock_guard<mutex> lock( libMutex );
+  const bool added = files.addPath( path, cache );
+  forget( files.names() ); // a later file replaces the Blocks
+  return added;
+}
 
-  return false;
+void GraphLib::addSource( const string& file )
+{
+  lock_guard<mutex> lock( libMutex );
+  files.addSource( file );
+  forget( files.names() );
 }
 
+const GraphBlock& GraphLib::operator[]( const string& key ) const
+{
+  lock_guard<mutex> lock( libMutex );
+  auto block = lib.find( key );
+  if( lib.end() != block )
+    return *block->second;
+  
+  string content;
+  vector<string> changed;
+  const string file = files.read( key, content, changed );
+  forget( changed );
+  
+  unique_ptr<GraphBlock> newBlock( new GraphBlock );
+  try
+  {
+    JSON::buffer in( content );
+    newBlock->readJsonBlock( in, key.substr( key.find( '/' ) + 1 ) );
+  }
+  catch( JSON::parseError e )
+  {
+    // the position of the error is only known while the content exists
+    GraphLibIndex::showError( "block '" + key + "' of file '" + file + "'", e );
+    throw( JSON::parseError( "Block '" + key + "' in '" + file + "' is broken", __LINE__ ,__FILE__ ) );
+  }
+  return *( lib[ key ] = std::move( newBlock ) );
+}
 
-void GraphLib::addSource( const string& file )
+void GraphLib::refresh( void ) const
 {
-  logger << "reading file '" << file << "'\n";
-  ifstream libSource( file );
+  lock_guard<mutex> lock( libMutex );
+  vector<string> changed;
+  if( files.refresh( changed ) )
+    forget( changed );
+}
 
-  try {
-    libSource >> JSON::consumeEmpty;
-    JSON::readJsonObject( libSource, [this]( istream &in, const string &libName )
-    {
-      JSON::readJsonObject( in, [this, &libName]( istream &in1, const string &blockName )
-      {
-        lib[ libName + "/" + blockName ].readJsonBlock( in1, blockName );
-      } );
-    } );
-  } catch( JSON::parseError e )
+void GraphLib::forget( const vector<string>& names ) const
+{
+  // a graph that is compiled meanwhile might still use the old Block
+  for( auto name = names.cbegin(); name != names.cend(); ++name )
   {
-    int lineNo, errorPos;
-    string wrongLine = e.getErrorLine( lineNo, errorPos ) ;
-    logger << "!!! caugt error \"" << e.text << "\" in line " << lineNo << " at postion " << errorPos << ":\n";
-    logger << "!!! " << wrongLine << "\n";
-    logger << "!!!";
-    while( 1 < errorPos-- )
-      logger << " ";
-    logger << "-^-" << endl;
-    logger.show();
+    auto block = lib.find( *name );
+    if( lib.end() == block )
+      continue;
+    retired.push_back( std::move( block->second ) );
+    lib.erase( block );
   }
 }
 
@@ -81,21 +92,36 @@ ostream& operator<<( ostream &stream, const GraphLib& lib )
 {
   stream << "{";
   string thisLib;
-  for( auto it = lib.lib.cbegin(); it != lib.lib.cend(); it++ )
+  vector<string> names;
   {
-    size_t lib_seperator = it->first.find_first_of('/');
-    bool lib_changed = it->first.substr( 0, lib_seperator ) != thisLib;
+    lock_guard<mutex> lock( lib.libMutex );
+    names = lib.files.names();
+  }
+  for( auto it = names.cbegin(); it != names.cend(); it++ )
+  {
+    const GraphBlock* block;
+    try
+    {
+      block = &lib[ *it ];
+    }
+    catch( JSON::parseError )
+    {
+      continue; // the error was shown already
+    }
+    
+    size_t lib_seperator = it->find_first_of('/');
+    bool lib_changed = it->substr( 0, lib_seperator ) != thisLib;
     if( lib_changed )
     {
       if( thisLib.size() != 0 ) // not the first run
         stream << "  },";
-      thisLib = it->first.substr( 0, lib_seperator );
+      thisLib = it->substr( 0, lib_seperator );
       stream << "\n  \"" << thisLib << "\": {\n";
     } else {
       stream << ",\n";
     }
-    stream << "    \"" << it->first << "\":\n";
-    stream << it->second;
+    stream << "    \"" << *it << "\":\n";
+    stream << *block;
   }
   return stream << "  }\n}" << endl;
 }
\ No newline at end of file
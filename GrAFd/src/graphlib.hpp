@@ -21,11 +21,21 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
 
 #include "graphblock.hpp"
+#include "graphlibindex.hpp"
 
 /**
  * The class to hold a library of known GraphBlock elements.
+ * 
+ * The .graflib files are only indexed when they are added, a GraphBlock is
+ * read from its file when it's looked up for the first time, see
+ * GraphLibIndex. The Blocks of a file that was changed meanwhile are read
+ * again.
  */
 class GraphLib
 {
@@ -33,13 +43,14 @@ public:
   /**
    * Constructor.
    */
-  GraphLib() : lib() {}
+  GraphLib() : lib(), retired(), files() {}
   
   /**
-   * Add a path and scan it for .graflib files.
+   * Add a path and scan it for .graflib files, their index is kept in the
+   * directory @p cache - if it isn't empty.
    * @returns true when @param path was added (i.e. a directory).
    */
-  bool addPath( const std::string& path );
+  bool addPath( const std::string& path, const std::string& cache = "" );
   
   /**
    * Add the content of the @param file to the library.
@@ -47,26 +58,64 @@ public:
   void addSource( const std::string& file );
   
   /**
-   * Look up the GraphBlock for the given key.
+   * Look up the GraphBlock for the given key, it's read from its file at
+   * the first time.
+   * Throws a JSON::parseError when it can't be read.
    */
-  const GraphBlock& operator[]( const std::string& key ) const
-  {
-    return lib.at( key );
-  }
+  const GraphBlock& operator[]( const std::string& key ) const;
   
   /**
    * Look up if the GraphBlock for the given key is in the library.
    */
   bool hasElement( const std::string& key ) const
   {
-    return lib.count( key ) == 1;
+    std::lock_guard<std::mutex> lock( libMutex );
+    return files.has( key );
+  }
+  
+  /**
+   * Return a key of the content of all added files, see GraphCache::key().
+   */
+  uint64_t key( void ) const
+  {
+    std::lock_guard<std::mutex> lock( libMutex );
+    return files.key();
   }
   
+  /**
+   * Index the files again that were changed since they were indexed and
+   * forget their Blocks that were read already - so that key() and the
+   * Blocks belong to the current content.
+   */
+  void refresh( void ) const;
+  
 private:
   /**
-   * The library of all known Blocks.
+   * The library of all Blocks that were read already.
+   */
+  mutable std::map<std::string, std::unique_ptr<GraphBlock> > lib;
+  
+  /**
+   * The Blocks of the files that were changed, kept as the references to
+   * them might still be used.
+   */
+  mutable std::vector<std::unique_ptr<GraphBlock> > retired;
+  
+  /**
+   * Guards lib, retired and files, as the Blocks are read while the graphs are
+   * compiled by many threads.
+   */
+  mutable std::mutex libMutex;
+  
+  /**
+   * The location of all known Blocks.
+   */
+  mutable GraphLibIndex files;
+  
+  /**
+   * Forget the read Blocks with the @p names.
    */
-  std::map<std::string, GraphBlock> lib;
+  void forget( const std::vector<std::string>& names ) const;
   
   friend std::ostream& operator<<( std::ostream &stream, const GraphLib& lib );
 };
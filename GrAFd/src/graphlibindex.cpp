@@ -0,0 +1,305 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "graphlibindex.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include <boost/filesystem.hpp>
+
+#include "logger.hpp"
+#include "checkpoint.hpp"
+#include "graphcache.hpp"
+
+using namespace std;
+
+void GraphLibIndex::showError( const string& where, JSON::parseError& e )
+{
+  int lineNo, errorPos;
+  string wrongLine = e.getErrorLine( lineNo, errorPos ) ;
+  logger << "!!! caugt error \"" << e.text << "\" in " << where << " line " << lineNo << " at postion " << errorPos << ":\n";
+  logger << "!!! " << wrongLine << "\n";
+  logger << "!!!";
+  while( 1 < errorPos-- )
+    logger << " ";
+  logger << "-^-" << endl;
+  logger.show();
+}
+
+static const string indexPrefix = "grafd_index_";
+
+uint64_t GraphLibIndex::indexKey( const string& path )
+{
+  // the indices of all libraries share the cache directory
+  return Checkpoint::hash( "GraphLib index " + boost::filesystem::absolute( path ).string() );
+}
+
+string GraphLibIndex::indexFile( const string& path, const string& cache )
+{
+  return GraphCache::fileName( cache, indexKey( path ), indexPrefix );
+}
+
+bool GraphLibIndex::addPath( const string& path, const string& cache )
+{
+  using namespace boost::filesystem;
+  if( !exists( path ) || !is_directory( path ) )
+    return false;
+  
+  // sorted, so that the key doesn't depend on the order in the directory
+  vector<string> files;
+  for( auto file = directory_iterator( path ); file != directory_iterator(); file++ )
+  {
+    if( ".graflib" == file->path().extension() )
+      files.push_back( file->path().string() );
+  }
+  sort( files.begin(), files.end() );
+  
+  // the index of the last time, by the name of the file
+  const uint64_t key = indexKey( path );
+  map<string, source_t> indexed;
+  if( !cache.empty() )
+  {
+    GraphCache file( cache, key, indexPrefix );
+    if( file.valid() )
+    {
+      try
+      {
+        GraphCache::Reader in = file.reader();
+        for( uint32_t sourceCount = in.get<uint32_t>(); sourceCount > 0; sourceCount-- )
+        {
+          source_t source;
+          source.file     = in.getString();
+          source.modified = in.get<int64_t>();
+          source.size     = in.get<uint64_t>();
+          source.hash     = in.get<uint64_t>();
+          for( uint32_t blockCount = in.get<uint32_t>(); blockCount > 0; blockCount-- )
+          {
+            const string name = in.getString();
+            location_t location;
+            location.source = 0;
+            location.offset = in.get<uint64_t>();
+            location.size   = in.get<uint64_t>();
+            source.blocks.push_back( make_pair( name, location ) );
+          }
+          indexed[ source.file ] = source;
+        }
+      }
+      catch( JSON::parseError e )
+      {
+        indexed.clear(); // scan all files again
+      }
+    }
+  }
+  
+  // use the index of each unchanged file and scan the others
+  bool changed = indexed.size() != files.size();
+  vector<size_t> valid;
+  for( auto file = files.cbegin(); file != files.cend(); ++file )
+  {
+    source_t source;
+    source.file = *file;
+    readStatus( source );
+    
+    auto cached = indexed.find( boost::filesystem::path( *file ).filename().string() );
+    if( indexed.end() != cached && cached->second.modified == source.modified && cached->second.size == source.size )
+    {
+      source.hash   = cached->second.hash;
+      source.blocks = std::move( cached->second.blocks );
+      add( source );
+      valid.push_back( sources.size() - 1 );
+      continue;
+    }
+    
+    changed = true;
+    logger << "indexing file '" << *file << "'\n"; logger.show();
+    const bool ok = scan( source );
+    add( source );
+    if( ok ) // a broken file is scanned again the next time, to show its error
+      valid.push_back( sources.size() - 1 );
+  }
+  
+  if( changed && !cache.empty() )
+  {
+    GraphCache::Writer out;
+    out.put<uint32_t>( valid.size() );
+    for( auto i = valid.cbegin(); i != valid.cend(); ++i )
+    {
+      const source_t& source = sources[ *i ];
+      out.put( boost::filesystem::path( source.file ).filename().string() );
+      out.put<int64_t>( source.modified );
+      out.put<uint64_t>( source.size );
+      out.put<uint64_t>( source.hash );
+      out.put<uint32_t>( source.blocks.size() );
+      for( auto block = source.blocks.cbegin(); block != source.blocks.cend(); ++block )
+      {
+        out.put( block->first );
+        out.put<uint64_t>( block->second.offset );
+        out.put<uint64_t>( block->second.size );
+      }
+    }
+    if( !GraphCache::store( cache, key, out, indexPrefix ) )
+    {
+      logger( Logger::WARN ) << "index of the library '" << path << "' can't be written to '" << cache << "'\n"; logger.show();
+    }
+  }
+  
+  return true;
+}
+
+void GraphLibIndex::addSource( const string& file )
+{
+  logger << "indexing file '" << file << "'\n"; logger.show();
+  source_t source;
+  source.file = file;
+  readStatus( source );
+  scan( source );
+  add( source );
+}
+
+vector<string> GraphLibIndex::names( void ) const
+{
+  vector<string> result;
+  for( auto it = index.cbegin(); it != index.cend(); ++it )
+    result.push_back( it->first );
+  return result;
+}
+
+string GraphLibIndex::read( const string& name, string& content, vector<string>& changed )
+{
+  auto location = index.find( name );
+  if( index.end() == location )
+    throw( JSON::parseError( "Block '" + name + "' not found", __LINE__ ,__FILE__ ) );
+  
+  // the offset is only valid for the content that was indexed
+  const string file = sources[ location->second.source ].file;
+  if( update( location->second.source, changed ) )
+  {
+    location = index.find( name );
+    if( index.end() == location )
+      throw( JSON::parseError( "Block '" + name + "' was removed from '" + file + "'", __LINE__ ,__FILE__ ) );
+  }
+  
+  ifstream libFile( sources[ location->second.source ].file, ios::binary );
+  content.assign( location->second.size, '\0' );
+  libFile.seekg( location->second.offset );
+  if( !libFile.read( &content[0], content.size() ) )
+    throw( JSON::parseError( "Block '" + name + "' can't be read from '" + file + "'", __LINE__ ,__FILE__ ) );
+  return sources[ location->second.source ].file;
+}
+
+bool GraphLibIndex::refresh( vector<string>& changed )
+{
+  bool any = false;
+  for( size_t source = 0; source < sources.size(); ++source )
+    any = update( source, changed ) || any;
+  return any;
+}
+
+void GraphLibIndex::readStatus( source_t& source )
+{
+  struct stat status;
+  if( 0 == ::stat( source.file.c_str(), &status ) )
+  {
+    source.modified = static_cast<int64_t>( status.st_mtim.tv_sec ) * 1000000000 + status.st_mtim.tv_nsec;
+    source.size     = status.st_size;
+  }
+  else
+  {
+    source.modified = -1;
+    source.size     = 0;
+  }
+}
+
+bool GraphLibIndex::scan( source_t& source )
+{
+  ifstream libFile( source.file );
+  const string content( (istreambuf_iterator<char>( libFile )), istreambuf_iterator<char>() );
+  source.hash = Checkpoint::hash( content );
+  source.blocks.clear();
+  JSON::buffer libSource( content );
+
+  try {
+    libSource >> JSON::consumeEmpty;
+    JSON::readJsonObject( libSource, [&source]( JSON::buffer &in, const JSON::stringRef &libName )
+    {
+      JSON::readJsonObject( in, [&source, &libName]( JSON::buffer &in1, const JSON::stringRef &blockName )
+      {
+        // only the place is needed, the Block is read when it's used
+        location_t location;
+        location.source = 0;
+        location.offset = in1.pos - in1.begin;
+        JSON::skipJsonValue( in1 );
+        location.size   = in1.pos - in1.begin - location.offset;
+        source.blocks.push_back( make_pair( libName + "/" + blockName, location ) );
+      } );
+    } );
+  } catch( JSON::parseError e )
+  {
+    showError( "file '" + source.file + "'", e );
+    return false;
+  }
+  
+  return true;
+}
+
+void GraphLibIndex::add( const source_t& source )
+{
+  sources.push_back( source );
+  apply( sources.size() - 1 );
+}
+
+void GraphLibIndex::apply( size_t source )
+{
+  sourceKey = Checkpoint::hash( to_string( sourceKey ) + "\n" + to_string( sources[ source ].hash ) );
+  const vector<pair<string, location_t> >& blocks = sources[ source ].blocks;
+  for( auto block = blocks.cbegin(); block != blocks.cend(); ++block )
+  {
+    location_t& location = index[ block->first ];
+    location = block->second;
+    location.source = source;
+  }
+}
+
+bool GraphLibIndex::update( size_t source, vector<string>& changed )
+{
+  source_t current;
+  current.file = sources[ source ].file;
+  readStatus( current );
+  if( current.modified == sources[ source ].modified && current.size == sources[ source ].size )
+    return false;
+  
+  logger << "indexing changed file '" << current.file << "'\n"; logger.show();
+  scan( current );
+  for( auto block = sources[ source ].blocks.cbegin(); block != sources[ source ].blocks.cend(); ++block )
+    changed.push_back( block->first );
+  for( auto block = current.blocks.cbegin(); block != current.blocks.cend(); ++block )
+    changed.push_back( block->first );
+  sources[ source ] = std::move( current );
+  
+  // a Block might be in several files, the last one wins
+  index.clear();
+  sourceKey = 0;
+  for( size_t i = 0; i < sources.size(); ++i )
+    apply( i );
+  return true;
+}
@@ -0,0 +1,180 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GRAPHLIBINDEX_HPP
+#define GRAPHLIBINDEX_HPP
+
+#include <string>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+#include "json.hpp"
+
+/**
+ * The index of the GraphBlock elements in the .graflib files, i.e. the
+ * place of the JSON structure of each Block in its file.
+ * 
+ * The index of a directory is kept in a file in the cache directory (see
+ * Graph::cachePath) and is valid for each .graflib file as long as the
+ * file has the same time of its last change and size. The same is checked before a Block is read, so a file that was
+ * changed meanwhile is indexed again.
+ * NOTE: it's not thread safe, the GraphLib guards it.
+ */
+class GraphLibIndex
+{
+public:
+  /**
+   * Constructor.
+   */
+  GraphLibIndex() : index(), sources(), sourceKey( 0 ) {}
+  
+  /**
+   * Add a path and scan it for .graflib files. Their index is kept in the
+   * directory @p cache - or not at all when it's empty.
+   * @returns true when @param path was added (i.e. a directory).
+   */
+  bool addPath( const std::string& path, const std::string& cache );
+  
+  /**
+   * Add the content of the @param file to the index.
+   */
+  void addSource( const std::string& file );
+  
+  /**
+   * Look up if the Block @p name is in the index.
+   */
+  bool has( const std::string& name ) const
+  {
+    return index.count( name ) == 1;
+  }
+  
+  /**
+   * Return the names of all Blocks, sorted.
+   */
+  std::vector<std::string> names( void ) const;
+  
+  /**
+   * Return a key of the content of all added files, see GraphCache::key().
+   */
+  uint64_t key( void ) const
+  {
+    return sourceKey;
+  }
+  
+  /**
+   * Read the JSON structure of the Block @p name into @p content, its file
+   * is indexed again first when it was changed - the Blocks of it before
+   * and after are added to @p changed then.
+   * Throws a JSON::parseError when it can't be read.
+   * @return the file of the Block
+   */
+  std::string read( const std::string& name, std::string& content, std::vector<std::string>& changed );
+  
+  /**
+   * Index all files again that were changed since they were indexed, their
+   * Blocks before and after are added to @p changed.
+   * @return true when a file was changed
+   */
+  bool refresh( std::vector<std::string>& changed );
+  
+  /**
+   * Return the file in the directory @p cache that keeps the index of the
+   * library directory @p path.
+   */
+  static std::string indexFile( const std::string& path, const std::string& cache );
+  
+  /**
+   * Show the parse error @p e, @p where tells the file of it.
+   */
+  static void showError( const std::string& where, JSON::parseError& e );
+  
+private:
+  /**
+   * The place of the JSON structure of a GraphBlock in its file.
+   */
+  struct location_t
+  {
+    size_t   source; ///< the entry in sources
+    uint64_t offset;
+    uint64_t size;
+  };
+  
+  /**
+   * An indexed .graflib file.
+   */
+  struct source_t
+  {
+    std::string file;
+    int64_t     modified;  ///< the time of the last change when it was indexed, in ns
+    uint64_t    size;
+    uint64_t    hash;      ///< the hash of the content
+    std::vector<std::pair<std::string, location_t> > blocks;
+  };
+  
+  /**
+   * The location of all known Blocks.
+   */
+  std::map<std::string, location_t> index;
+  
+  /**
+   * All added files.
+   */
+  std::vector<source_t> sources;
+  
+  /**
+   * The hash of the content of all added files.
+   */
+  uint64_t sourceKey;
+  
+  /**
+   * Return the key of the index of the library directory @p path.
+   */
+  static uint64_t indexKey( const std::string& path );
+  
+  /**
+   * Read the time of the last change and the size of the @p source.
+   */
+  static void readStatus( source_t& source );
+  
+  /**
+   * Read the Blocks of the @p source into the index.
+   * @return false when the file isn't valid
+   */
+  static bool scan( source_t& source );
+  
+  /**
+   * Add the scanned @p source to the index.
+   */
+  void add( const source_t& source );
+  
+  /**
+   * Add the Blocks of the entry @p source of sources to the index, they
+   * replace the ones of the files before.
+   */
+  void apply( size_t source );
+  
+  /**
+   * Index the entry @p source of sources again when its file was changed,
+   * its Blocks before and after are added to @p changed.
+   * @return true when it was changed
+   */
+  bool update( size_t source, std::vector<std::string>& changed );
+};
+
+#endif // GRAPHLIBINDEX_HPP
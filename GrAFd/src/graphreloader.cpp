@@ -0,0 +1,214 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "graphreloader.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <boost/filesystem.hpp>
+
+#include "logger.hpp"
+#include "json.hpp"
+#include "graph.hpp"
+#include "messageregister.hpp"
+
+constexpr std::chrono::milliseconds GraphReloader::retryInterval; // give it a home
+
+GraphReloader::GraphReloader( boost::asio::io_service& io_service, const std::string& directory, size_t threads )
+: io_service( io_service ), directory( directory ), running( true )
+{
+  if( !directory.empty() )
+  {
+    watchFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if( -1 == watchFd || -1 == inotify_add_watch( watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) )
+    {
+      logger( Logger::ERROR ) << "GraphReloader: can't watch '" << directory << "'\n"; logger.show();
+    }
+    else
+      watcher.reset( new AsyncSocket( io_service, watchFd, [this](){ handleEvents(); } ) ); // closes the watchFd
+    
+    reloadAll();
+  }
+  else
+    watchFd = -1;
+  
+  for( size_t i = 0; i < threads; ++i )
+    this->threads.push_back( std::thread( &GraphReloader::loop, this ) );
+}
+
+GraphReloader::~GraphReloader()
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    running = false;
+  }
+  wake.notify_all();
+  for( auto thread = threads.begin(); thread != threads.end(); ++thread )
+    thread->join();
+}
+
+void GraphReloader::reload( const std::string& name )
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    if( jobs.end() != std::find( jobs.begin(), jobs.end(), name ) )
+      return; // an editor usually causes more than one event
+    jobs.push_back( name );
+  }
+  wake.notify_one();
+}
+
+void GraphReloader::load( const std::string& name, const std::string& file )
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    files[ name ] = file;
+  }
+  reload( name );
+}
+
+void GraphReloader::reloadAll( void )
+{
+  using namespace boost::filesystem;
+  if( !is_directory( directory ) )
+    return;
+  
+  for( auto file = directory_iterator( directory ); file != directory_iterator(); file++ )
+  {
+    if( ".graf" == file->path().extension() )
+      reload( file->path().stem().string() );
+  }
+}
+
+void GraphReloader::handleEvents( void )
+{
+  static const std::string suffix = ".graf";
+  alignas( inotify_event ) char buffer[ 4096 ];
+  
+  ssize_t length;
+  while( 0 < ( length = read( watchFd, buffer, sizeof( buffer ) ) ) )
+  {
+    for( char* position = buffer; position < buffer + length; )
+    {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>( position );
+      position += sizeof( inotify_event ) + event->len;
+      
+      const std::string file( 0 == event->len ? "" : event->name );
+      if( file.length() > suffix.length() 
+       && 0 == file.compare( file.length() - suffix.length(), suffix.length(), suffix ) )
+        reload( file.substr( 0, file.length() - suffix.length() ) );
+    }
+  }
+}
+
+void GraphReloader::loop( void )
+{
+  std::unique_lock<std::mutex> lock( mutex );
+  for(;;)
+  {
+    auto job = jobs.end();
+    wake.wait( lock, [this, &job]{ 
+      job = std::find_if( jobs.begin(), jobs.end(), [this]( const std::string& name ){ return 0 == compiling.count( name ); } );
+      return !running || jobs.end() != job; 
+    });
+    if( !running )
+      break;
+    
+    const std::string name = *job;
+    const auto added = files.find( name );
+    const std::string file = files.end() != added ? added->second : directory + "/" + name + ".graf";
+    jobs.erase( job );
+    compiling.insert( name );
+    lock.unlock();
+    
+    std::shared_ptr<Graph> fresh = compile( file );
+    if( fresh )
+      io_service.post( [this, name, fresh](){ replace( name, fresh ); } );
+    
+    lock.lock();
+    compiling.erase( name );
+    wake.notify_all(); // a newer version might wait for it
+  }
+}
+
+std::shared_ptr<Graph> GraphReloader::compile( const std::string& file ) const
+{
+  std::ifstream in( file );
+  if( !in )
+  {
+    logger( Logger::WARN ) << "GraphReloader: can't open '" << file << "'\n"; logger.show();
+    return nullptr;
+  }
+  
+  logger << "GraphReloader: compiling '" << file << "'\n"; logger.show();
+  try
+  {
+    return std::shared_ptr<Graph>( new Graph( in ) );
+  }
+  catch( JSON::parseError e )
+  {
+    logger( Logger::ERROR ) << "GraphReloader: '" << file << "' not replaced, error \"" << e.text 
+                            << "\" (" << e.sourceFile << ":" << e.sourceLineNo << ")\n"; logger.show();
+  }
+  catch( std::exception& e )
+  {
+    logger( Logger::ERROR ) << "GraphReloader: '" << file << "' not replaced, error \"" << e.what() << "\"\n"; logger.show();
+  }
+  return nullptr;
+}
+
+void GraphReloader::replace( const std::string& name, const std::shared_ptr<Graph>& fresh )
+{
+  auto old = graphs.find( name );
+  const bool replacing = graphs.end() != old;
+  
+  // the old logic mustn't run anymore - when it's idle it's claimed by
+  // enableVariables(), so that no trigger can start it again
+  if( replacing && !old->second.le->enableVariables() )
+  {
+    std::shared_ptr<timer_t> timer( new timer_t( io_service, retryInterval ) );
+    timer->async_wait( [this, name, fresh, timer]( const boost::system::error_code& error ){
+      if( boost::asio::error::operation_aborted != error )
+        replace( name, fresh );
+    });
+    return;
+  }
+  
+  if( replacing )
+  {
+    const size_t adopted = fresh->le->adoptVariables( *old->second.le );
+    registry.unsubscribe( old->second.le );
+    graphs.erase( old ); // stops its timers
+    logger << "GraphReloader: replacing graph '" << name << "', " << adopted << " variables kept\n"; logger.show();
+  }
+  else
+  {
+    logger << "GraphReloader: adding graph '" << name << "'\n"; logger.show();
+  }
+  
+  auto added = graphs.insert( std::make_pair( name, std::move( *fresh ) ) );
+  added.first->second.init( io_service, name, !replacing );
+  
+  // the messages of its imports trigger the new logic from now on
+  added.first->second.le->subscribeImports();
+}
@@ -0,0 +1,147 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GRAPHRELOADER_HPP
+#define GRAPHRELOADER_HPP
+
+#include <deque>
+#include <set>
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <boost/asio.hpp>
+
+#include "globals.h"
+#include "asyncsocket.hpp"
+
+/**
+ * The GraphReloader loads all graphs of a directory and replaces a graph by
+ * a newer version of its file while all other graphs keep running.
+ * 
+ * It watches the directory by inotify, each changed file "<name>.graf" is
+ * compiled by one of its threads - the graphs are compiled in parallel, they
+ * share only the Graph::lib that isn't changed meanwhile. Afterwards the old
+ * graph "<name>" is replaced in the thread of the io_service, as soon as its
+ * logic isn't running: the new graph takes over the values of the variables
+ * with the same name and its imports are subscribed in the registry instead
+ * of the ones of the old graph.
+ * Graphs of other files are compiled by the same threads after load(), e.g.
+ * the ones of the start.
+ */
+class GraphReloader
+{
+public:
+  /**
+   * Constructor - load and watch the graphs in @p directory - or none when
+   * it's empty -, compiled by @p threads threads, the replacement is done by
+   * the @p io_service.
+   */
+  GraphReloader( boost::asio::io_service& io_service, const std::string& directory, 
+                 size_t threads = std::max( 1u, std::thread::hardware_concurrency() ) );
+  GraphReloader( const GraphReloader& ) = delete; // no copy
+  
+  /**
+   * Destructor - stop the threads after their current compilation.
+   */
+  ~GraphReloader();
+  
+  /**
+   * Compile the file of the graph @p name and replace the graph by it - or
+   * add it, when there's none yet. May be called by any thread.
+   */
+  void reload( const std::string& name );
+  
+  /**
+   * Compile all graphs of the directory and replace or add them. May be
+   * called by any thread.
+   */
+  void reloadAll( void );
+  
+  /**
+   * Compile the graph @p name from the @p file and replace or add it, a
+   * reload() of @p name uses the @p file afterwards, too. May be called by
+   * any thread.
+   */
+  void load( const std::string& name, const std::string& file );
+  
+private:
+  typedef boost::asio::basic_waitable_timer< std::chrono::steady_clock > timer_t;
+  
+  /**
+   * How long to wait before the next try, when the old graph is running.
+   */
+  static constexpr std::chrono::milliseconds retryInterval{ 10 };
+  
+  boost::asio::io_service& io_service;
+  const std::string directory;
+  
+  /**
+   * The inotify handling.
+   */
+  std::unique_ptr<AsyncSocket> watcher;
+  int watchFd;
+  
+  /**
+   * The names of the graphs to compile.
+   */
+  std::deque<std::string> jobs;
+  
+  /**
+   * The names of the graphs that are compiled right now, a newer version
+   * of one of them has to wait for it, so that they are replaced in order.
+   */
+  std::set<std::string> compiling;
+  
+  /**
+   * The files of the graphs that were added by load().
+   */
+  std::map<std::string, std::string> files;
+  bool running;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::vector<std::thread> threads;
+  
+  /**
+   * Read the events of the watched directory.
+   */
+  void handleEvents( void );
+  
+  /**
+   * The loop of each thread.
+   */
+  void loop( void );
+  
+  /**
+   * Compile the graph in @p file.
+   * @return nullptr on error
+   */
+  std::shared_ptr<class Graph> compile( const std::string& file ) const;
+  
+  /**
+   * Replace the graph @p name by @p fresh - or try again later when its
+   * logic is still running. Only in the thread of the io_service.
+   */
+  void replace( const std::string& name, const std::shared_ptr<class Graph>& fresh );
+};
+
+#endif // GRAPHRELOADER_HPP
@@ -23,30 +23,30 @@
 #include "graph.hpp"
 #include "json.hpp"
 
-void GraphSignal::grepSignal( std::istream& in, Graph& graph )
+void GraphSignal::grepSignal( JSON::buffer& in, Graph& graph )
 {
-  JSON::readJsonArray( in, [&]( std::istream& in1 ){
+  JSON::readJsonArray( in, [&]( JSON::buffer& in1 ){
     int count = 0;
     std::string fromBlock, toBlock;
     int fromPort, toPort;
-    JSON::readJsonArray( in1, [&]( std::istream& in2 ){
+    JSON::readJsonArray( in1, [&]( JSON::buffer& in2 ){
       switch( count++ )
       {
         case 0:
           fromBlock = JSON::readJsonString( in2 );
           break;
         case 1:
-          in2 >> fromPort;
+          fromPort = JSON::readJsonNumber<int>( in2 );
           break;
         case 2:
           toBlock = JSON::readJsonString( in2 );
           break;
         case 3:
-          in2 >> toPort;
+          toPort = JSON::readJsonNumber<int>( in2 );
           break;
         case 4:
-          JSON::readJsonObject( in2, []( std::istream& in3, const std::string& dummy ){
-            in3.peek(); dummy.c_str(); // fix warning
+          JSON::readJsonObject( in2, []( JSON::buffer& in3, const JSON::stringRef& dummy ){
+            in3.peek(); dummy.str(); // fix warning
           });
           break;
         default:
@@ -23,6 +23,7 @@
 #include <iosfwd>
 
 class Graph;
+namespace JSON { struct buffer; }
 struct GraphSignalExtended;
 
 /**
@@ -38,7 +39,7 @@ struct GraphSignal
   /**
    * Read a GraphSignal from @p in and insert it in the @p graph.
    */
-  static void grepSignal( std::istream& in, Graph& graph );
+  static void grepSignal( JSON::buffer& in, Graph& graph );
   
   GraphSignalExtended extend( const std::string& from, const std::string& to ) const;
 };
@@ -18,6 +18,9 @@
 
 #include "json.hpp"
 
+#include <cstdlib>
+#include <cctype>
+
 #include "globals.h"
 #include "logger.hpp"
 using namespace std;
@@ -30,33 +33,41 @@ using namespace std;
 #endif
 #define THROW( text, pos ) throw( JSON::parseError( (text), (pos), __LINE__ ,__FILE__ ) )
 
-JSON::Type JSON::identifyNext( std::istream& in )
+/**
+ * The type of the value that starts with the character @p c.
+ */
+static JSON::Type identify( int c )
 {
-  switch( in.peek() )
+  switch( c )
   {
     case 't':
     case 'f':
-      return BOOL;
+      return JSON::BOOL;
       
     case '+': case '-': case '0': case '1': case '2': case '3': case '4':
     case '5': case '6': case '7': case '8': case '9': case '.':
       // note: 'e' and 'E' can't the first character
-      return NUMBER;
+      return JSON::NUMBER;
       
     case '"':
-      return STRING;
+      return JSON::STRING;
       
     case '[':
-      return ARRAY;
+      return JSON::ARRAY;
       
     case '{':
-      return OBJECT;
+      return JSON::OBJECT;
       
     default:
-      return UNKNOWN;
+      return JSON::UNKNOWN;
   }
 }
 
+JSON::Type JSON::identifyNext( std::istream& in )
+{
+  return identify( in.peek() );
+}
+
 istream& JSON::consumeEmpty( istream& in )
 {
   in >> ws;              // skip starting whitespace
@@ -177,6 +188,182 @@ void JSON::readJsonObject( istream& in, jsonNamedObjectHandler_t entryHandler )
     THROW( "JSON Object '}' expected", in );
 }
 
+JSON::Type JSON::identifyNext( const buffer& in )
+{
+  return identify( in.peek() );
+}
+
+JSON::buffer& JSON::consumeEmpty( buffer& in )
+{
+  for(;;)
+  {
+    while( in.pos < in.end && isspace( static_cast<unsigned char>( *in.pos ) ) )
+      in.pos++;            // skip starting whitespace
+    
+    if( in.end - in.pos < 2 || '/' != in.pos[0] )
+      return in;
+    
+    if( '/' == in.pos[1] )
+    {
+      // C++ style comment found, skip to end of line
+      const char* eol = static_cast<const char*>( memchr( in.pos, '\n', in.end - in.pos ) );
+      in.pos = nullptr == eol ? in.end : eol + 1;
+    } else if( '*' == in.pos[1] )
+    {
+      // C style comment found
+      const char* c = in.pos + 2;
+      while( c + 1 < in.end && !( '*' == c[0] && '/' == c[1] ) )
+        c++;
+      in.pos = c + 1 < in.end ? c + 2 : in.end;
+    } else
+      return in;           // the '/' isn't a comment
+  }
+}
+
+bool JSON::readJsonBool( buffer& in )
+{
+  if( 4 <= in.end - in.pos && 0 == strncmp( in.pos, "true", 4 ) )
+  {
+    in.pos += 4;
+    return true;
+  } else if( 5 <= in.end - in.pos && 0 == strncmp( in.pos, "false", 5 ) )
+  {
+    in.pos += 5;
+    return false;
+  }
+  
+  THROW( "Boolean value expected", in );
+}
+
+double JSON::readJsonNumber( buffer& in )
+{
+  // strtod() needs a terminated string, the buffer doesn't have to be
+  char number[ 64 ];
+  size_t length = 0;
+  while( in.pos + length < in.end && length < sizeof( number ) - 1 && 
+         ( isdigit( static_cast<unsigned char>( in.pos[ length ] ) ) || nullptr != memchr( "+-.eE", in.pos[ length ], 5 ) ) )
+    length++;
+  memcpy( number, in.pos, length );
+  number[ length ] = '\0';
+  
+  char* parsed;
+  const double value = strtod( number, &parsed );
+  if( parsed == number )
+    THROW( "JSON Number expected", in );
+  
+  in.pos += parsed - number;
+  return value;
+}
+
+JSON::stringRef JSON::readJsonStringRef( buffer& in )
+{
+  if( '"' != in.peek() )
+    THROW( "JSON String expected", in );
+  
+  const char* start = ++in.pos;
+  bool escape = false;
+  for( ; in.pos < in.end; in.pos++ )
+  {
+    if( escape )
+      escape = false;
+    else if( '\\' == *in.pos )
+      escape = true;
+    else if( '"' == *in.pos )
+    {
+      stringRef ret = { start, static_cast<size_t>( in.pos - start ) };
+      in.pos++; // move past ending '"'
+      return ret;
+    }
+  }
+  
+  THROW( "JSON String not terminated", in );
+}
+
+string JSON::readJsonString( buffer& in )
+{
+  const stringRef ret = readJsonStringRef( in );
+  if( nullptr == memchr( ret.data, '\\', ret.size ) )
+    return ret.str();
+  
+  return unescape( ret.str() );
+}
+
+void JSON::skipJsonValue( buffer& in )
+{
+  switch( identifyNext( in ) )
+  {
+    case BOOL:
+      readJsonBool( in );
+      break;
+      
+    case NUMBER:
+      readJsonNumber( in );
+      break;
+      
+    case STRING:
+      readJsonStringRef( in );
+      break;
+      
+    case ARRAY:
+      readJsonArray( in, []( buffer& in1 ){ skipJsonValue( in1 ); } );
+      break;
+      
+    case OBJECT:
+      readJsonObject( in, []( buffer& in1, const stringRef& ){ skipJsonValue( in1 ); } );
+      break;
+      
+    default:
+      THROW( "JSON value expected", in );
+  }
+}
+
+void JSON::readJsonArray( buffer& in, bufferObjectHandler_t entryHandler )
+{
+  if( '[' != in.get() )
+    THROW( "JSON Array '[' expected", in );
+    
+  do
+  {
+    in >> consumeEmpty;
+    if( ']' == in.peek() )
+    {
+      in.get(); // consume ']'
+      break; // early exit
+    }
+    entryHandler( in );
+    in >> consumeEmpty;
+  }
+  while( ',' == in.get() );   // will also remove the remaining ']'
+}
+
+void JSON::readJsonObject( buffer& in, bufferNamedObjectHandler_t entryHandler )
+{
+  if( '{' != in.get() )
+    THROW( "JSON Object '{' expected", in );
+
+  int last;
+  do
+  {
+    in >> consumeEmpty;
+    if( '}' == in.peek() )
+    {
+      last = in.get(); // consume '}'
+      break; // early exit
+    }
+    const stringRef key = readJsonStringRef( in );
+    in >> consumeEmpty;
+    if( ':' != in.get() )
+      THROW( "JSON Object ':' expected", in );
+    in >> consumeEmpty;
+    entryHandler( in, key );
+    in >> consumeEmpty;
+  }
+  while( ',' == (last = in.get()) ); // will also remove the remaining '}'
+
+  if( '}' != last )
+    THROW( "JSON Object '}' expected", in );
+}
+
 string JSON::escape( const string& str, bool keepNewline )
 {
   string ret;
@@ -257,6 +444,22 @@ string JSON::unescape( const string& str )
 
 string JSON::parseError::getErrorLine( int& errorLineNo, int& errorCharPos )
 {
+  if( nullptr != bufferBegin )
+  {
+    // the lines are only counted now, as they are usually not needed
+    const char* lineStart = bufferBegin;
+    errorLineNo = 1;
+    for( const char* c = bufferBegin; c < bufferPos; c++ )
+      if( '\n' == *c )
+      {
+        errorLineNo++;
+        lineStart = c + 1;
+      }
+    const char* lineEnd = static_cast<const char*>( memchr( lineStart, '\n', bufferEnd - lineStart ) );
+    errorCharPos = bufferPos - lineStart;
+    return string( lineStart, nullptr == lineEnd ? bufferEnd : lineEnd );
+  }
+  
   if( !hasStream )
   {
     errorLineNo = -1;
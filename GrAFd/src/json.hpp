@@ -35,6 +35,9 @@
 #define JSON_HPP
 
 #include <istream>
+#include <string>
+#include <cstring>
+#include <cstdio>
 #include <functional>
 
 namespace JSON
@@ -91,6 +94,149 @@ namespace JSON
    */
   void readJsonObject( std::istream& in, jsonNamedObjectHandler_t entryHandler );
 
+  /**
+   * The position in a contiguous buffer that is parsed, e.g. the content of
+   * a std::string or of a memory mapped file - the counterpart of the
+   * std::istream for the functions below that work without copying.
+   * NOTE: the buffer has to exist as long as the parsing and a parseError
+   * of it.
+   */
+  struct buffer
+  {
+    const char* const begin;
+    const char* const end;
+    const char*       pos;
+    
+    buffer( const char* _begin, const char* _end ) : begin( _begin ), end( _end ), pos( _begin ) {}
+    explicit buffer( const std::string& text ) : begin( text.data() ), end( text.data() + text.size() ), pos( begin ) {}
+    
+    /**
+     * Return the next character or EOF at the end.
+     */
+    int peek( void ) const
+    {
+      return pos < end ? static_cast<unsigned char>( *pos ) : EOF;
+    }
+    
+    /**
+     * Return the next character or EOF at the end and move past it.
+     */
+    int get( void )
+    {
+      return pos < end ? static_cast<unsigned char>( *pos++ ) : EOF;
+    }
+  };
+  
+  /**
+   * A string inside of a buffer, e.g. the key of an object, that isn't
+   * copied.
+   */
+  struct stringRef
+  {
+    const char* data;
+    size_t size;
+    
+    bool operator==( const char* other ) const
+    {
+      return 0 == std::strncmp( data, other, size ) && '\0' == other[ size ];
+    }
+    
+    bool operator==( const std::string& other ) const
+    {
+      return other.size() == size && 0 == other.compare( 0, size, data, size );
+    }
+    
+    /**
+     * Return a copy.
+     */
+    std::string str( void ) const
+    {
+      return std::string( data, size );
+    }
+  };
+  
+  inline bool operator==( const char* a, const stringRef& b ) { return b == a; }
+  inline bool operator==( const std::string& a, const stringRef& b ) { return b == a; }
+  inline std::string operator+( const std::string& a, const stringRef& b ) { return a + b.str(); }
+  inline std::string operator+( const stringRef& a, const std::string& b ) { return a.str() + b; }
+  inline std::string operator+( const char* a, const stringRef& b ) { return a + b.str(); }
+  inline std::string operator+( const stringRef& a, const char* b ) { return a.str() + b; }
+  
+  Type identifyNext( const buffer& in );
+  
+  /**
+   * Skip whitespace an comments in C and/or C++ style
+   */
+  buffer& consumeEmpty( buffer& in );
+  
+  /**
+   * Apply the manipulator @p func, i.e. "in >> JSON::consumeEmpty".
+   */
+  inline buffer& operator>>( buffer& in, buffer& (*func)( buffer& ) )
+  {
+    return func( in );
+  }
+  
+  /**
+   * Read the string "true" or "false" from @param in and return it as an 
+   * boolean.
+   */
+  bool readJsonBool( buffer& in );
+  
+  /**
+   * Read a number from @param in.
+   */
+  double readJsonNumber( buffer& in );
+  
+  /**
+   * Read a number from @param in as type @p T.
+   */
+  template<typename T>
+  T readJsonNumber( buffer& in )
+  {
+    return static_cast<T>( readJsonNumber( in ) );
+  }
+  
+  /**
+   * Read a JSON style string from @param in and return it, it's copied only
+   * once - see readJsonString( std::istream& ).
+   */
+  std::string readJsonString( buffer& in );
+  
+  /**
+   * Read a JSON style string from @param in without copying it.
+   * NOTE: escaped characters are kept escaped.
+   */
+  stringRef readJsonStringRef( buffer& in );
+  
+  /**
+   * Move @param in past the next value of any type without reading it.
+   */
+  void skipJsonValue( buffer& in );
+  
+  /**
+   * Define the function signature of the function that will be called
+   * for each entry of an array in a buffer.
+   */
+  typedef std::function<void ( buffer& in )> bufferObjectHandler_t;
+  
+  /**
+   * Read a JSON array and call @param entryHandler for each entry.
+   */
+  void readJsonArray( buffer& in, bufferObjectHandler_t entryHandler );
+  
+  /**
+   * Define the function signature of the function that will be called
+   * for each object found in a buffer. The @param name contains the key for
+   * that object.
+   */
+  typedef std::function<void ( buffer& in, const stringRef& name )> bufferNamedObjectHandler_t;
+  
+  /**
+   * Read a JSON object and call @param entryHandler for each entry.
+   */
+  void readJsonObject( buffer& in, bufferNamedObjectHandler_t entryHandler );
+  
   /**
    * Escape the string.
    */
@@ -126,6 +272,13 @@ namespace JSON
      * The source filename where the exception was thown.
      */
     std::string sourceFile;
+    /**
+     * The buffer with the error and the position of the error in it,
+     * nullptr when the error isn't in a buffer.
+     */
+    const char* bufferBegin;
+    const char* bufferEnd;
+    const char* bufferPos;
     
     /**
      * Throw a JSON::parseError without a corresponding istream.
@@ -135,7 +288,8 @@ namespace JSON
       stream( *static_cast<std::istream*>(nullptr) ), 
       hasStream( false ),
       sourceLineNo( line ),
-      sourceFile( file )
+      sourceFile( file ),
+      bufferBegin( nullptr ), bufferEnd( nullptr ), bufferPos( nullptr )
     {}
     /**
      * Throw a JSON::parseError with error message and the stream s at the
@@ -146,7 +300,21 @@ namespace JSON
       stream( s ), 
       hasStream( true ),
       sourceLineNo( line ),
-      sourceFile( file )
+      sourceFile( file ),
+      bufferBegin( nullptr ), bufferEnd( nullptr ), bufferPos( nullptr )
+    {}
+    /**
+     * Throw a JSON::parseError with error message and the buffer b at the
+     * position of the parse error - the line of it is only searched by
+     * getErrorLine().
+     */
+    parseError( const std::string& t, const buffer& b, int line, const std::string& file = "" ) 
+    : text( t ), 
+      stream( *static_cast<std::istream*>(nullptr) ), 
+      hasStream( false ),
+      sourceLineNo( line ),
+      sourceFile( file ),
+      bufferBegin( b.begin ), bufferEnd( b.end ), bufferPos( b.pos )
     {}
     
     /**
@@ -27,6 +27,7 @@
 #include "logic_elements/logicelement_mul.hpp"
 #include "logic_elements/logicelement_rel.hpp"
 #include "logic_elements/logicelement_send.hpp"
+#include "logic_elements/logicelement_sendchanged.hpp"
 #include "logic_elements/logicelement_sleep.hpp"
 #include "logic_elements/logicelement_stop.hpp"
 #include "logic_elements/logicelement_sum.hpp"
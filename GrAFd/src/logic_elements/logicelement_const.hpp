@@ -47,10 +47,10 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
     using boost::lexical_cast;
-    return new LogicElement_Const<T>( lexical_cast<raw_offset_t>(p[0]), lexical_cast<T>(p[1]) ); 
+    return new( owner ) LogicElement_Const<T>( p[0].offset, lexical_cast<T>(p[1].text) ); 
   }
   
   /**
@@ -69,6 +69,11 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename T>
@@ -82,4 +87,12 @@ void LogicElement_Const<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out << ", " << value << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_Const<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CONST_BOOL, ByteCode::CONST_INT, ByteCode::CONST_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  ByteCode::setImmediate( instruction.b, value );
+}
+
 #endif // LOGICELEMENT_CONST_HPP
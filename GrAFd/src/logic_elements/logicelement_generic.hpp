@@ -19,10 +19,13 @@
 #ifndef LOGICELEMENT_GENERIC_HPP
 #define LOGICELEMENT_GENERIC_HPP
 
+#include <cstddef>
 #include <vector>
 #include <string>
+#include <chrono>
 
 #include "../globals.h"
+#include "../bytecode.hpp"
 
 #include "variabletype.hpp"
 
@@ -52,10 +55,23 @@ public:
   typedef std::vector<parameter_t> signature_t;
   typedef class LogicEngine* const ownerPtr_t;
   
+  /**
+   * A parameter for creating a LogicElement though the factory: an OFFSET
+   * is passed already resolved, everything else as the text of the program.
+   */
+  struct param_t
+  {
+    std::string  text;
+    raw_offset_t offset;
+    
+    param_t( const std::string& text ) : text( text ), offset( 0 ) {}
+    param_t( const char* text ) : text( text ), offset( 0 ) {}
+    param_t( raw_offset_t offset ) : text(), offset( offset ) {}
+  };
   /**
    * Type of parameters for creating a LogicElement though the factory.
    */
-  typedef std::vector<std::string> params_t;
+  typedef std::vector<param_t> params_t;
   /**
    * Type of the factory function to create a LogicElement
    */
@@ -67,6 +83,20 @@ public:
    */
   static const raw_offset_t ground = sizeof( LogicElement_Generic* );
   
+  /**
+   * What an element waits for, see await().
+   */
+  struct await_t
+  {
+    enum kind_t {
+      TIMER,   ///< wait for the delay
+      MESSAGE  ///< send the value to the target and wait for the reply
+    } kind;
+    std::chrono::milliseconds delay;
+    std::string target;
+    variable_t value;
+  };
+  
   /**
    * Destructor - virtual to allow overloading.
    */
@@ -82,6 +112,96 @@ public:
    */
   virtual void dump( std::ostream& out ) const 
   { out << "<unknown element>" << std::endl; }
+  
+  /**
+   * Lower the element to its ByteCode @p instruction - should be overloaded.
+   * The default keeps the prepared ByteCode::CALL so that the ByteCode
+   * backend will use calc().
+   */
+  virtual void lower( ByteCode::instruction_t& ) const 
+  {}
+  
+  /**
+   * Return true when the element might jump the instruction pointer, the
+   * relative distance is returned in @p offset then.
+   */
+  virtual bool getJumpOffset( long int& ) const
+  { return false; }
+  
+  /**
+   * Return true when all variables the element might read and write are
+   * known, they are appended to @p reads and @p writes then - should be
+   * overloaded by elements without a ByteCode opcode.
+   * The default is false: the element might read and write anything.
+   */
+  virtual bool getAccess( std::vector<raw_offset_t>&, std::vector<raw_offset_t>& ) const
+  { return false; }
+  
+  /**
+   * Return true when the element waits for something outside of the logic,
+   * e.g. a timer or the reply to a message. The LogicEngine can suspend the
+   * run meanwhile instead of blocking in calc(), see await().
+   */
+  virtual bool canAwait( void ) const
+  { return false; }
+  
+  /**
+   * Describe in @p wait what the element waits for with the variables at
+   * @p base - instead of waiting in calc(). Only used for elements where
+   * canAwait() returns true.
+   */
+  virtual void await( const raw_t* const, await_t& ) const
+  {}
+  
+  /**
+   * Set the relative jump distance to @p offset - only used for elements
+   * where getJumpOffset() returns true, e.g. when the instructions in between
+   * were changed.
+   */
+  virtual void relocate( const long int )
+  {}
+  
+  /**
+   * Allocate an element on the heap.
+   */
+  static void* operator new( std::size_t size )
+  {
+    raw_t* memory = static_cast<raw_t*>( ::operator new( header + size ) );
+    memory[0] = HEAP;
+    return memory + header;
+  }
+  
+  /**
+   * Allocate an element in the ElementArena of its @p owner, i.e. next to the
+   * element created before. The memory is freed together with the owner.
+   */
+  static void* operator new( std::size_t size, ownerPtr_t owner );
+  
+  /**
+   * Free an element - but only when it's on the heap.
+   */
+  static void operator delete( void* element )
+  {
+    if( nullptr == element )
+      return;
+    
+    raw_t* memory = static_cast<raw_t*>( element ) - header;
+    if( HEAP == memory[0] )
+      ::operator delete( memory );
+  }
+  
+  /**
+   * Free an element in an ElementArena whose constructor failed.
+   */
+  static void operator delete( void*, ownerPtr_t )
+  {}
+  
+private:
+  /**
+   * Each element is preceded by a header that tells where it is allocated.
+   */
+  static const std::size_t header = alignof( std::max_align_t );
+  enum allocation_t : raw_t { HEAP, ARENA };
 };
 
 #endif // LOGICELEMENT_GENERIC_HPP
@@ -27,7 +27,7 @@
 class LogicElement_Jump : public LogicElement_Generic
 {
 private:
-  const long int offset;
+  long int offset;
   
 public:
   /**
@@ -45,10 +45,9 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Jump( lexical_cast<long int>(p[0]) ); 
+    return new( owner ) LogicElement_Jump( p[0].offset ); 
   }
   
   /**
@@ -63,6 +62,28 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+  
+  /**
+   * Return the jump distance in @p _offset.
+   */
+  bool getJumpOffset( long int& _offset ) const
+  {
+    _offset = offset;
+    return true;
+  }
+  
+  /**
+   * Change the jump distance to @p _offset.
+   */
+  void relocate( const long int _offset )
+  {
+    offset = _offset;
+  }
 };
 
 //const typename LogicElement_Jump::signature_t LogicElement_Jump::signature { OFFSET };
@@ -72,6 +93,12 @@ inline void LogicElement_Jump::dump( std::ostream& stream_out ) const
   stream_out << "jump( " << offset << " )" << std::endl; 
 }
 
+inline void LogicElement_Jump::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::JUMP;
+  instruction.a.jump = static_cast<int32_t>( offset );
+}
+
 /**
  * A LogicElement that will conditionally jump the instruction pointer.
  */
@@ -79,7 +106,7 @@ template <typename T>
 class LogicElement_JumpTrue : public LogicElement_Generic
 {
 private:
-  const long int offset;
+  long int offset;
   const raw_offset_t in1;
   
 public:
@@ -98,11 +125,10 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_JumpTrue<T>( lexical_cast<long int>(p[0]), 
-                                         lexical_cast<raw_offset_t>(p[1]) ); 
+    return new( owner ) LogicElement_JumpTrue<T>( p[0].offset, 
+                                                   p[1].offset ); 
   }
   
   /**
@@ -120,6 +146,28 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+  
+  /**
+   * Return the jump distance in @p _offset.
+   */
+  bool getJumpOffset( long int& _offset ) const
+  {
+    _offset = offset;
+    return true;
+  }
+  
+  /**
+   * Change the jump distance to @p _offset.
+   */
+  void relocate( const long int _offset )
+  {
+    offset = _offset;
+  }
 };
 
 template <typename T>
@@ -133,6 +181,14 @@ void LogicElement_JumpTrue<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << offset << ", " << in1 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_JumpTrue<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::JUMPTRUE_BOOL, ByteCode::JUMPTRUE_INT, ByteCode::CALL );
+  instruction.a.jump   = static_cast<int32_t>( offset );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+}
+
 /**
  * A LogicElement that will conditionally jump the instruction pointer.
  */
@@ -140,7 +196,7 @@ template <typename T>
 class LogicElement_JumpZero : public LogicElement_Generic
 {
 private:
-  const long int offset;
+  long int offset;
   const raw_offset_t in1;
   
 public:
@@ -159,11 +215,10 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_JumpZero<T>( lexical_cast<long int>(p[0]), 
-                                         lexical_cast<raw_offset_t>(p[1]) ); 
+    return new( owner ) LogicElement_JumpZero<T>( p[0].offset, 
+                                                   p[1].offset ); 
   }
   
   /**
@@ -181,6 +236,28 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+  
+  /**
+   * Return the jump distance in @p _offset.
+   */
+  bool getJumpOffset( long int& _offset ) const
+  {
+    _offset = offset;
+    return true;
+  }
+  
+  /**
+   * Change the jump distance to @p _offset.
+   */
+  void relocate( const long int _offset )
+  {
+    offset = _offset;
+  }
 };
 
 template <typename T>
@@ -194,6 +271,14 @@ void LogicElement_JumpZero<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << offset << ", " << in1 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_JumpZero<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::JUMPZERO_BOOL, ByteCode::JUMPZERO_INT, ByteCode::CALL );
+  instruction.a.jump   = static_cast<int32_t>( offset );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+}
+
 /**
  * A LogicElement that will conditionally jump the instruction pointer.
  */
@@ -201,7 +286,7 @@ template <typename T>
 class LogicElement_JumpEqual : public LogicElement_Generic
 {
 private:
-  const long int offset;
+  long int offset;
   const raw_offset_t in1;
   const raw_offset_t in2;
   
@@ -222,12 +307,11 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_JumpEqual<T>( lexical_cast<long int>(p[0]), 
-                                          lexical_cast<raw_offset_t>(p[1]),
-                                          lexical_cast<raw_offset_t>(p[2]) ); 
+    return new( owner ) LogicElement_JumpEqual<T>( p[0].offset, 
+                                                    p[1].offset,
+                                                    p[2].offset ); 
   }
   
   /**
@@ -245,6 +329,28 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+  
+  /**
+   * Return the jump distance in @p _offset.
+   */
+  bool getJumpOffset( long int& _offset ) const
+  {
+    _offset = offset;
+    return true;
+  }
+  
+  /**
+   * Change the jump distance to @p _offset.
+   */
+  void relocate( const long int _offset )
+  {
+    offset = _offset;
+  }
 };
 
 template <typename T>
@@ -258,6 +364,15 @@ void LogicElement_JumpEqual<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << offset << ", " << in1 << ", " << in2 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_JumpEqual<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::JUMPEQUAL_INT, ByteCode::JUMPEQUAL_FLOAT );
+  instruction.a.jump   = static_cast<int32_t>( offset );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
 /**
  * A LogicElement that will conditionally jump the instruction pointer.
  */
@@ -265,7 +380,7 @@ template <typename T>
 class LogicElement_JumpNotEqual : public LogicElement_Generic
 {
 private:
-  const long int offset;
+  long int offset;
   const raw_offset_t in1;
   const raw_offset_t in2;
   
@@ -286,12 +401,11 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_JumpNotEqual<T>( lexical_cast<long int>(p[0]), 
-                                             lexical_cast<raw_offset_t>(p[1]),
-                                             lexical_cast<raw_offset_t>(p[2]) ); 
+    return new( owner ) LogicElement_JumpNotEqual<T>( p[0].offset, 
+                                                       p[1].offset,
+                                                       p[2].offset ); 
   }
   
   /**
@@ -309,6 +423,28 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+  
+  /**
+   * Return the jump distance in @p _offset.
+   */
+  bool getJumpOffset( long int& _offset ) const
+  {
+    _offset = offset;
+    return true;
+  }
+  
+  /**
+   * Change the jump distance to @p _offset.
+   */
+  void relocate( const long int _offset )
+  {
+    offset = _offset;
+  }
 };
 
 template <typename T>
@@ -322,4 +458,13 @@ void LogicElement_JumpNotEqual<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << offset << ", " << in1 << ", " << in2 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_JumpNotEqual<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::JUMPNOTEQUAL_INT, ByteCode::JUMPNOTEQUAL_FLOAT );
+  instruction.a.jump   = static_cast<int32_t>( offset );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
 #endif // LOGICELEMENT_JUMP_HPP
@@ -45,10 +45,9 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Move<T>( lexical_cast<raw_offset_t>(p[0]), lexical_cast<raw_offset_t>(p[1]) ); 
+    return new( owner ) LogicElement_Move<T>( p[0].offset, p[1].offset ); 
   }
   
   /**
@@ -68,6 +67,11 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename T>
@@ -81,4 +85,91 @@ void LogicElement_Move<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out  << ", " << in << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_Move<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::MOVE_BOOL, ByteCode::MOVE_INT, ByteCode::MOVE_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in  );
+}
+
+/**
+ * A LogicElement that will copy two values over others.
+ * This is a superinstruction for two LogicElement_Move in a row, the second
+ * copy happens after the first so that chains are kept intact.
+ */
+template <typename T>
+class LogicElement_Move2 : public LogicElement_Generic
+{
+  const raw_offset_t out1;
+  const raw_offset_t in1;
+  const raw_offset_t out2;
+  const raw_offset_t in2;
+  
+public:
+  /**
+   * Constructor.
+   */
+  LogicElement_Move2( const raw_offset_t _out1, const raw_offset_t _in1,
+                      const raw_offset_t _out2, const raw_offset_t _in2 ) 
+  : out1(_out1), in1(_in1), out2(_out2), in2(_in2)
+  {}
+  
+  /**
+   * Signature.
+   */
+  const static signature_t signature;
+  
+  /**
+   * Factory
+   */
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
+  { 
+    return new( owner ) LogicElement_Move2<T>( p[0].offset, p[1].offset,
+                                                p[2].offset, p[3].offset ); 
+  }
+  
+  /**
+   * Do the real work
+   */
+  void calc ( raw_t*const base ) const
+  {
+    *reinterpret_cast<T* const>( base + out1 ) = *reinterpret_cast<T* const>( base + in1 );
+    *reinterpret_cast<T* const>( base + out2 ) = *reinterpret_cast<T* const>( base + in2 );
+    
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Export the content in noGrAF format.
+   */
+  void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+};
+
+template <typename T>
+const typename LogicElement_Move2<T>::signature_t LogicElement_Move2<T>::signature { OFFSET, OFFSET, OFFSET, OFFSET };
+
+template <typename T>
+void LogicElement_Move2<T>::dump( std::ostream& stream_out ) const 
+{
+  stream_out << "move2<";
+  stream_out << variableType::getTypeName(variableType::getType<T>());
+  stream_out << ">( " << out1 << ", " << in1 << ", " << out2 << ", " << in2 << " )" << std::endl; 
+}
+
+template <typename T>
+void LogicElement_Move2<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::MOVE2_BOOL, ByteCode::MOVE2_INT, ByteCode::MOVE2_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out1 );
+  instruction.b.offset = static_cast<int32_t>( in1  );
+  instruction.c.offset = static_cast<int32_t>( out2 );
+  instruction.d.offset = static_cast<int32_t>( in2  );
+}
+
 #endif // LOGICELEMENT_MOVE_HPP
@@ -21,6 +21,8 @@
 
 #include "logicelement_generic.hpp"
 
+#include <boost/lexical_cast.hpp>
+
 /**
  * A LogicElement that will multiplicate two values.
  */
@@ -45,12 +47,11 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Mul<T>( lexical_cast<raw_offset_t>(p[0]), 
-                                    lexical_cast<raw_offset_t>(p[1]), 
-                                    lexical_cast<raw_offset_t>(p[2]) ); 
+    return new( owner ) LogicElement_Mul<T>( p[0].offset, 
+                                              p[1].offset, 
+                                              p[2].offset ); 
   }
   
   /**
@@ -68,6 +69,11 @@ public:
   }
   
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename T>
@@ -81,6 +87,93 @@ void LogicElement_Mul<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out << ", " << in1 << ", " << in2 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_Mul<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::MUL_INT, ByteCode::MUL_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
+/**
+ * A LogicElement that will multiplicate a value with a constant value,
+ * created by the Optimizer for constant folding.
+ */
+template <typename T>
+class LogicElement_MulConst : public LogicElement_Generic
+{
+  const raw_offset_t out;
+  const raw_offset_t in;
+  const T value;
+  
+public:
+  /**
+   * Constructor.
+   */
+  LogicElement_MulConst( const raw_offset_t _out, const raw_offset_t _in, const T _value ) : out(_out), in(_in), value( _value )
+  {}
+  
+  /**
+   * Signature.
+   */
+  const static signature_t signature;
+  
+  /**
+   * Factory
+   */
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
+  { 
+    using boost::lexical_cast;
+    return new( owner ) LogicElement_MulConst<T>( p[0].offset, 
+                                              p[1].offset, 
+                                              lexical_cast<T>(p[2].text) ); 
+  }
+  
+  /**
+   * Do the real work
+   */
+  void calc( raw_t* const base ) const 
+  {
+    T &_out = *reinterpret_cast<T* const>( base + out );
+    T &_in  = *reinterpret_cast<T* const>( base + in  );
+    
+    _out = _in * value;
+    
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Export the content in noGrAF format.
+   */
+  void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+};
+
+template <typename T>
+const typename LogicElement_MulConst<T>::signature_t LogicElement_MulConst<T>::signature { OFFSET, OFFSET, VARIABLE_T };
+
+template <typename T>
+void LogicElement_MulConst<T>::dump( std::ostream& stream_out ) const 
+{
+  stream_out << "mulconst<";
+  stream_out << variableType::getTypeName(variableType::getType<T>());
+  stream_out << ">( " << out << ", " << in << ", " << value << " )" << std::endl; 
+}
+
+template <typename T>
+void LogicElement_MulConst<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::MULCONST_INT, ByteCode::MULCONST_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in );
+  ByteCode::setImmediate( instruction.c, value );
+}
+
 /**
  * A LogicElement that will multiplicate two values and add it to the 
  * @param _out value.
@@ -106,12 +199,11 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_MulAdd<T>( lexical_cast<raw_offset_t>(p[0]), 
-                                       lexical_cast<raw_offset_t>(p[1]), 
-                                       lexical_cast<raw_offset_t>(p[2]) ); 
+    return new( owner ) LogicElement_MulAdd<T>( p[0].offset, 
+                                                 p[1].offset, 
+                                                 p[2].offset ); 
   }
   
   /**
@@ -129,6 +221,11 @@ public:
   }
   
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename T>
@@ -142,6 +239,15 @@ void LogicElement_MulAdd<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out << ", " << in1 << ", " << in2 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_MulAdd<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::MULADD_INT, ByteCode::MULADD_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
 /**
  * A LogicElement that will multiplicate two values and substract it from the 
  * @param _out value.
@@ -167,12 +273,11 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_MulSub<T>( lexical_cast<raw_offset_t>(p[0]), 
-                                       lexical_cast<raw_offset_t>(p[1]), 
-                                       lexical_cast<raw_offset_t>(p[2]) ); 
+    return new( owner ) LogicElement_MulSub<T>( p[0].offset, 
+                                                 p[1].offset, 
+                                                 p[2].offset ); 
   }
   
   /**
@@ -193,6 +298,11 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename T>
@@ -206,4 +316,98 @@ void LogicElement_MulSub<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out << ", " << in1 << ", " << in2 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_MulSub<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::MULSUB_INT, ByteCode::MULSUB_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
+/**
+ * A LogicElement that will multiplicate two values and add a third one.
+ * This is a superinstruction for a LogicElement_Mul followed by a
+ * LogicElement_Sum of its result, the product is still written to @p tmp.
+ */
+template <typename T>
+class LogicElement_MulSum : public LogicElement_Generic
+{
+  const raw_offset_t out;
+  const raw_offset_t tmp;
+  const raw_offset_t in1;
+  const raw_offset_t in2;
+  const raw_offset_t in3;
+public:
+  /**
+   * Constructor.
+   */
+  LogicElement_MulSum( const raw_offset_t _out, const raw_offset_t _tmp, const raw_offset_t _in1, 
+                       const raw_offset_t _in2, const raw_offset_t _in3 ) 
+  : out(_out), tmp(_tmp), in1(_in1), in2(_in2), in3(_in3)
+  {}
+  
+  /**
+   * Signature.
+   */
+  const static signature_t signature;
+  
+  /**
+   * Factory
+   */
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
+  { 
+    return new( owner ) LogicElement_MulSum<T>( p[0].offset, 
+                                                 p[1].offset, 
+                                                 p[2].offset, 
+                                                 p[3].offset, 
+                                                 p[4].offset ); 
+  }
+  
+  /**
+   * Do the real work
+   */
+  void calc( raw_t* const base ) const 
+  {
+    T &_tmp = *reinterpret_cast<T* const>( base + tmp );
+    
+    _tmp = *reinterpret_cast<T* const>( base + in1 ) * *reinterpret_cast<T* const>( base + in2 );
+    *reinterpret_cast<T* const>( base + out ) = _tmp + *reinterpret_cast<T* const>( base + in3 );
+    
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+
+  /**
+   * Export the content in noGrAF format.
+   */
+  void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+};
+
+template <typename T>
+const typename LogicElement_MulSum<T>::signature_t LogicElement_MulSum<T>::signature { OFFSET, OFFSET, OFFSET, OFFSET, OFFSET };
+
+template <typename T>
+void LogicElement_MulSum<T>::dump( std::ostream& stream_out ) const 
+{
+  stream_out << "mulsum<";
+  stream_out << variableType::getTypeName(variableType::getType<T>());
+  stream_out << ">( " << out << ", " << tmp << ", " << in1 << ", " << in2 << ", " << in3 << " )" << std::endl; 
+}
+
+template <typename T>
+void LogicElement_MulSum<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::MULSUM_INT, ByteCode::MULSUM_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+  instruction.d.offset = static_cast<int32_t>( in3 );
+  instruction.e.offset = static_cast<int32_t>( tmp );
+}
+
 #endif // LOGICELEMENT_MUL_HPP
@@ -95,13 +95,12 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Rel<Tout, Tin>( lexical_cast<raw_offset_t>(p[0]),
-                                            lexical_cast<raw_offset_t>(p[1]),
-                                            lexical_cast<raw_offset_t>(p[2]),
-                                            string2type(p[3]) ); 
+    return new( owner ) LogicElement_Rel<Tout, Tin>( p[0].offset,
+                                                      p[1].offset,
+                                                      p[2].offset,
+                                                      string2type(p[3].text) ); 
   }
   
   /**
@@ -113,40 +112,49 @@ public:
     Tin  &_in1 = *reinterpret_cast<Tin * const>( base + in1 );
     Tin  &_in2 = *reinterpret_cast<Tin * const>( base + in2 );
     
+    _out = relate( type, _in1, _in2 );
+    
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Return the result of the relation @p type between @p _in1 and @p _in2.
+   */
+  static Tout relate( const relType type, const Tin& _in1, const Tin& _in2 )
+  {
     switch( type )
     {
       case EQUAL:
-        _out = _in1 == _in2;
-        break;
+        return _in1 == _in2;
         
       case NOTEQUAL:
-        _out = _in1 != _in2;
-        break;
+        return _in1 != _in2;
         
       case LESS:
-        _out = _in1 < _in2;
-        break;
+        return _in1 < _in2;
         
       case LESSEQUAL:
-        _out = _in1 <= _in2;
-        break;
+        return _in1 <= _in2;
         
       case GREATER:
-        _out = _in1 > _in2;
-        break;
+        return _in1 > _in2;
         
       case GREATEREQUAL:
-        _out = _in1 >= _in2;
-        break;
+        return _in1 >= _in2;
     }
     
-    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+    return false;
   }
   
   /**
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename Tout, typename Tin>
@@ -162,4 +170,128 @@ void LogicElement_Rel<Tout,Tin>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out << ", " << in1 << ", " << in2 << ", " << type2string(type) << " )" << std::endl; 
 }
 
+template <typename Tout, typename Tin>
+void LogicElement_Rel<Tout,Tin>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::relation<Tout, Tin>( type );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
+/**
+ * A LogicElement that will do a relation operation and jump the instruction
+ * pointer when it's true.
+ * This is a superinstruction for a LogicElement_Rel followed by a
+ * LogicElement_JumpTrue of its result.
+ */
+template <typename Tout, typename Tin>
+class LogicElement_RelJumpTrue : public LogicElement_Generic
+{
+public:
+  typedef typename LogicElement_Rel<Tout, Tin>::relType relType;
+  
+private:
+  long int offset;
+  const raw_offset_t out;
+  const raw_offset_t in1;
+  const raw_offset_t in2;
+  const relType type;
+  
+public:
+  /**
+   * Constructor.
+   */
+  LogicElement_RelJumpTrue( const long int _offset, const raw_offset_t _out, 
+                            const raw_offset_t _in1, const raw_offset_t _in2, 
+                            const relType _type ) : 
+                            offset( _offset ), out(_out), in1(_in1), in2(_in2), type( _type )
+  {}
+  
+  /**
+   * Signature.
+   */
+  const static signature_t signature;
+  
+  /**
+   * Factory
+   */
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
+  { 
+    return new( owner ) LogicElement_RelJumpTrue<Tout, Tin>( p[0].offset,
+                                                              p[1].offset,
+                                                              p[2].offset,
+                                                              p[3].offset,
+                                                              LogicElement_Rel<Tout, Tin>::string2type(p[4].text) ); 
+  }
+  
+  /**
+   * Do the real work
+   */
+  void calc( raw_t* const base ) const 
+  {
+    Tout &_out = *reinterpret_cast<Tout* const>( base + out );
+    Tin  &_in1 = *reinterpret_cast<Tin * const>( base + in1 );
+    Tin  &_in2 = *reinterpret_cast<Tin * const>( base + in2 );
+    
+    _out = LogicElement_Rel<Tout, Tin>::relate( type, _in1, _in2 );
+    
+    if( _out > 0 )
+      reinterpret_cast<iterator*>( base )[0] += offset; // jump instruction pointer
+    else
+      ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Export the content in noGrAF format.
+   */
+  void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+  
+  /**
+   * Return the jump distance in @p _offset.
+   */
+  bool getJumpOffset( long int& _offset ) const
+  {
+    _offset = offset;
+    return true;
+  }
+  
+  /**
+   * Change the jump distance to @p _offset.
+   */
+  void relocate( const long int _offset )
+  {
+    offset = _offset;
+  }
+};
+
+template <typename Tout, typename Tin>
+const typename LogicElement_RelJumpTrue<Tout,Tin>::signature_t LogicElement_RelJumpTrue<Tout,Tin>::signature { OFFSET, OFFSET, OFFSET, OFFSET, VARIABLE_T };
+
+template <typename Tout, typename Tin>
+void LogicElement_RelJumpTrue<Tout,Tin>::dump( std::ostream& stream_out ) const 
+{
+  stream_out << "reljumptrue<";
+  stream_out << variableType::getTypeName(variableType::getType<Tout>());
+  stream_out << ", ";
+  stream_out << variableType::getTypeName(variableType::getType<Tin>());
+  stream_out << ">( " << offset << ", " << out << ", " << in1 << ", " << in2 << ", " 
+             << LogicElement_Rel<Tout, Tin>::type2string(type) << " )" << std::endl; 
+}
+
+template <typename Tout, typename Tin>
+void LogicElement_RelJumpTrue<Tout,Tin>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::relation<Tout, Tin>( type, ByteCode::RELJUMP_EQUAL_BOOL_INT );
+  instruction.a.jump   = static_cast<int32_t>( offset );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+  instruction.d.offset = static_cast<int32_t>( out );
+}
+
 #endif // LOGICELEMENT_REL_HPP
@@ -22,6 +22,7 @@
 #include "message.hpp"
 
 #include "logicelement_generic.hpp"
+#include "../logicengine.hpp"
 
 /**
  * A LogicElement that will send a value to the bus.
@@ -32,13 +33,15 @@ class LogicElement_Send : public LogicElement_Generic
 private:
   const raw_offset_t in1;
   const std::string target;
+  LogicEngine* const owner;
   
 public:
   /**
-   * Constructor.
+   * Constructor - the message is queued to the outbox of the @p _owner,
+   * when it has one.
    */
-  LogicElement_Send( const raw_offset_t _in1, const std::string& _target ) 
-  : in1( _in1 ), target( _target )
+  LogicElement_Send( const raw_offset_t _in1, const std::string& _target, LogicEngine* const _owner = nullptr ) 
+  : in1( _in1 ), target( _target ), owner( _owner )
   {}
   
   /**
@@ -49,11 +52,10 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Send<T>( lexical_cast<raw_offset_t>(p[0]), 
-                                     p[1] ); 
+    return new( owner ) LogicElement_Send<T>( p[0].offset, 
+                                               p[1].text, owner ); 
   }
   
   /**
@@ -61,16 +63,59 @@ public:
    */
   void calc( raw_t*const base ) const
   {
-    logger( Logger::ALL ) << "sending to '" << target << "' the value '" << *reinterpret_cast<T* const>( base + in1 ) << "';\n";
+    deliver( owner, target, *reinterpret_cast<T* const>( base + in1 ) );
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Send the @p value to @p target - queued to the outbox of the @p owner
+   * when it has one, otherwise by waiting for the reply.
+   */
+  static void deliver( LogicEngine* const owner, const std::string& target, const T value )
+  {
+    if( nullptr != owner && owner->hasOutbox() )
+    {
+      owner->post( LogicMessage::shared_ptr( new LogicMessage( target, value ) ) );
+      return;
+    }
+    
+    logger( Logger::ALL ) << "sending to '" << target << "' the value '" << value << "';\n";
     logger.show();
     
-    LogicMessage msg( target, *reinterpret_cast<T* const>( base + in1 ) );
+    LogicMessage msg( target, value );
     msg.send( *sender );
   
     // clean up - catch the reply
     LogicMessage reply = recieveMessage( *sender );
-    
-    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * The reply can be awaited while the run is suspended - there is no reply
+   * when the message goes to an outbox.
+   */
+  bool canAwait( void ) const
+  {
+    return nullptr == owner || !owner->hasOutbox();
+  }
+  
+  /**
+   * Let the message be sent and the reply be awaited instead of blocking
+   * in calc().
+   */
+  void await( const raw_t* const base, await_t& wait ) const
+  {
+    wait.kind   = await_t::MESSAGE;
+    wait.target = target;
+    wait.value  = variable_t( *reinterpret_cast<const T* const>( base + in1 ) );
+  }
+  
+  /**
+   * The only variable read is the input.
+   */
+  bool getAccess( std::vector<raw_offset_t>& reads, std::vector<raw_offset_t>& ) const
+  {
+    reads.push_back( in1 );
+    return true;
   }
   
   /**
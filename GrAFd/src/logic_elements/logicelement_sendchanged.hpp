@@ -0,0 +1,149 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGICELEMENT_SENDCHANGED_HPP
+#define LOGICELEMENT_SENDCHANGED_HPP
+
+#include "logicelement_send.hpp"
+
+/**
+ * A LogicElement that sends a message only when the value has changed
+ * noticeably since it was sent last time.
+ * 
+ * The state lives in variables of the logic: the last sent value, the time
+ * since it was sent and whether anything was sent at all. The time is
+ * advanced by the variable @p dt at each run, i.e. by "__dt" of the rate
+ * group.
+ * The value is sent when it differs by more than the absolute @p deadband
+ * and by more than the @p relative deadband times the last value - but not
+ * before @p minInterval has passed. After @p maxAge it is sent again even
+ * without a change, a @p maxAge of 0 disables this heartbeat.
+ */
+template <typename T>
+class LogicElement_SendChanged : public LogicElement_Generic
+{
+private:
+  const raw_offset_t in1;
+  const raw_offset_t last;
+  const raw_offset_t age;
+  const raw_offset_t valid;
+  const raw_offset_t dt;
+  const raw_offset_t deadband;
+  const raw_offset_t relative;
+  const raw_offset_t minInterval;
+  const raw_offset_t maxAge;
+  const std::string target;
+  LogicEngine* const owner;
+  
+public:
+  /**
+   * Constructor.
+   */
+  LogicElement_SendChanged( const raw_offset_t _in1, const raw_offset_t _last, const raw_offset_t _age, const raw_offset_t _valid,
+                            const raw_offset_t _dt, const raw_offset_t _deadband, const raw_offset_t _relative,
+                            const raw_offset_t _minInterval, const raw_offset_t _maxAge, const std::string& _target,
+                            LogicEngine* const _owner = nullptr ) 
+  : in1( _in1 ), last( _last ), age( _age ), valid( _valid ), dt( _dt ), deadband( _deadband ), relative( _relative ),
+    minInterval( _minInterval ), maxAge( _maxAge ), target( _target ), owner( _owner )
+  {}
+  
+  /**
+   * Signature.
+   */
+  const static signature_t signature;
+  
+  /**
+   * Factory
+   */
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
+  { 
+    return new( owner ) LogicElement_SendChanged<T>( p[0].offset, p[1].offset,
+                                                      p[2].offset, p[3].offset,
+                                                      p[4].offset, p[5].offset,
+                                                      p[6].offset, p[7].offset,
+                                                      p[8].offset, p[9].text, owner ); 
+  }
+  
+  /**
+   * Do the real work
+   */
+  void calc( raw_t*const base ) const
+  {
+    const T value      = *reinterpret_cast<T* const>( base + in1 );
+    T&      lastValue  = *reinterpret_cast<T* const>( base + last );
+    float&  lastAge    = *reinterpret_cast<float* const>( base + age );
+    bool&   isValid    = *reinterpret_cast<bool* const>( base + valid );
+    const float maxAgeValue = *reinterpret_cast<float* const>( base + maxAge );
+    
+    lastAge += *reinterpret_cast<float* const>( base + dt );
+    
+    bool due;
+    if( !isValid )
+      due = true;   // nothing sent yet
+    else if( 0.0f < maxAgeValue && maxAgeValue <= lastAge )
+      due = true;   // heartbeat
+    else if( lastAge < *reinterpret_cast<float* const>( base + minInterval ) )
+      due = false;  // rate limit
+    else
+    {
+      const T difference = value > lastValue ? value - lastValue : lastValue - value;
+      const T magnitude  = lastValue < T() ? T() - lastValue : lastValue;
+      due = *reinterpret_cast<float* const>( base + deadband ) < difference 
+         && *reinterpret_cast<float* const>( base + relative ) * magnitude < difference;
+    }
+    
+    if( due )
+    {
+      lastValue = value;
+      lastAge   = 0.0f;
+      isValid   = true;
+      LogicElement_Send<T>::deliver( owner, target, value );
+    }
+    
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Besides the input and the parameters the state is read and written.
+   */
+  bool getAccess( std::vector<raw_offset_t>& reads, std::vector<raw_offset_t>& writes ) const
+  {
+    reads.insert( reads.end(), { in1, last, age, valid, dt, deadband, relative, minInterval, maxAge } );
+    writes.insert( writes.end(), { last, age, valid } );
+    return true;
+  }
+  
+  /**
+   * Export the content in noGrAF format.
+   */
+  void dump( std::ostream& stream_out ) const;
+};
+
+template <typename T>
+const typename LogicElement_SendChanged<T>::signature_t LogicElement_SendChanged<T>::signature { OFFSET, OFFSET, OFFSET, OFFSET, OFFSET, OFFSET, OFFSET, OFFSET, OFFSET, STRING };
+
+template <typename T>
+void LogicElement_SendChanged<T>::dump( std::ostream& stream_out ) const 
+{
+  stream_out << "sendchanged<";
+  stream_out << variableType::getTypeName(variableType::getType<T>());
+  stream_out << ">( " << in1 << ", " << last << ", " << age << ", " << valid << ", " << dt << ", " 
+             << deadband << ", " << relative << ", " << minInterval << ", " << maxAge << ", " << target << " )" << std::endl; 
+}
+
+#endif // LOGICELEMENT_SENDCHANGED_HPP
@@ -45,10 +45,9 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Sleep( lexical_cast<raw_offset_t>(p[0]) ); 
+    return new( owner ) LogicElement_Sleep( p[0].offset ); 
   }
   
   /**
@@ -71,6 +70,40 @@ public:
     ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
   }
   
+  /**
+   * The sleep can be done by a timer while the run is suspended.
+   */
+  bool canAwait( void ) const
+  {
+    return true;
+  }
+  
+  /**
+   * Wait for a timer instead of sleeping in calc().
+   */
+  void await( const raw_t* const base, await_t& wait ) const
+  {
+    int duration = *reinterpret_cast<const int*>( base + in1 );
+    if( duration < 0 )
+    {
+      logger( Logger::ERROR ) << "Error during LogicElement_Sleep: duration has to be a"
+        "positive number, but it is '" << duration << "'" << std::endl; 
+      logger.show();
+      duration = 0;
+    }
+    wait.kind  = await_t::TIMER;
+    wait.delay = std::chrono::milliseconds( duration );
+  }
+  
+  /**
+   * The only variable read is the input.
+   */
+  bool getAccess( std::vector<raw_offset_t>& reads, std::vector<raw_offset_t>& ) const
+  {
+    reads.push_back( in1 );
+    return true;
+  }
+  
   /**
    * Export the content in noGrAF format.
    */
@@ -53,6 +53,11 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 inline void LogicElement_Stop::dump( std::ostream& stream_out ) const 
@@ -60,4 +65,9 @@ inline void LogicElement_Stop::dump( std::ostream& stream_out ) const
   stream_out << "stop" << std::endl; 
 }
 
+inline void LogicElement_Stop::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::STOP;
+}
+
 #endif // LOGICELEMENT_STOP_HPP
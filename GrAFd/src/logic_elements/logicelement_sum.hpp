@@ -23,6 +23,8 @@
 
 #include "../globals.h"
 
+#include <boost/lexical_cast.hpp>
+
 /**
  * A LogicElement that will sum two values together.
  */
@@ -48,12 +50,11 @@ public:
   /**
    * Factory
    */
-  static LogicElement_Generic* create( ownerPtr_t, const params_t& p ) 
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
   { 
-    using boost::lexical_cast;
-    return new LogicElement_Sum<T>( lexical_cast<raw_offset_t>(p[0]), 
-                                    lexical_cast<raw_offset_t>(p[1]), 
-                                    lexical_cast<raw_offset_t>(p[2]) ); 
+    return new( owner ) LogicElement_Sum<T>( p[0].offset, 
+                                              p[1].offset, 
+                                              p[2].offset ); 
   }
   
   /**
@@ -74,6 +75,11 @@ public:
    * Export the content in noGrAF format.
    */
   void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
 };
 
 template <typename T>
@@ -87,4 +93,91 @@ void LogicElement_Sum<T>::dump( std::ostream& stream_out ) const
   stream_out << ">( " << out << ", " << in1 << ", " << in2 << " )" << std::endl; 
 }
 
+template <typename T>
+void LogicElement_Sum<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::SUM_INT, ByteCode::SUM_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in1 );
+  instruction.c.offset = static_cast<int32_t>( in2 );
+}
+
+/**
+ * A LogicElement that will add a constant value to a value, created by the
+ * Optimizer for constant folding.
+ */
+template <typename T>
+class LogicElement_SumConst : public LogicElement_Generic
+{
+  const raw_offset_t out;
+  const raw_offset_t in;
+  const T value;
+  
+public:
+  /**
+   * Constructor.
+   */
+  LogicElement_SumConst( const raw_offset_t _out, const raw_offset_t _in, const T _value ) : out(_out), in(_in), value( _value )
+  {}
+  
+  /**
+   * Signature.
+   */
+  const static signature_t signature;
+  
+  /**
+   * Factory
+   */
+  static LogicElement_Generic* create( ownerPtr_t owner, const params_t& p ) 
+  { 
+    using boost::lexical_cast;
+    return new( owner ) LogicElement_SumConst<T>( p[0].offset, 
+                                              p[1].offset, 
+                                              lexical_cast<T>(p[2].text) ); 
+  }
+  
+  /**
+   * Do the real work
+   */
+  void calc( raw_t* const base ) const 
+  {
+    T &_out = *reinterpret_cast<T* const>( base + out );
+    T &_in  = *reinterpret_cast<T* const>( base + in  );
+    
+    _out = _in + value;
+    
+    ++reinterpret_cast<iterator*>( base )[0]; // increase instruction pointer
+  }
+  
+  /**
+   * Export the content in noGrAF format.
+   */
+  void dump( std::ostream& stream_out ) const;
+  
+  /**
+   * Lower the element to its ByteCode.
+   */
+  void lower( ByteCode::instruction_t& instruction ) const;
+};
+
+template <typename T>
+const typename LogicElement_SumConst<T>::signature_t LogicElement_SumConst<T>::signature { OFFSET, OFFSET, VARIABLE_T };
+
+template <typename T>
+void LogicElement_SumConst<T>::dump( std::ostream& stream_out ) const 
+{
+  stream_out << "sumconst<";
+  stream_out << variableType::getTypeName(variableType::getType<T>());
+  stream_out << ">( " << out << ", " << in << ", " << value << " )" << std::endl; 
+}
+
+template <typename T>
+void LogicElement_SumConst<T>::lower( ByteCode::instruction_t& instruction ) const 
+{
+  instruction.op = ByteCode::select<T>( ByteCode::CALL, ByteCode::SUMCONST_INT, ByteCode::SUMCONST_FLOAT );
+  instruction.a.offset = static_cast<int32_t>( out );
+  instruction.b.offset = static_cast<int32_t>( in );
+  ByteCode::setImmediate( instruction.c, value );
+}
+
 #endif // LOGICELEMENT_SUM_HPP
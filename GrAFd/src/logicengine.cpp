@@ -18,37 +18,105 @@
 
 #include "logicengine.hpp"
 
+#include <cstdlib>
 #include <cstdint>
+#include <climits>
+#include <limits>
 #include <sstream>
 #include <iomanip>
 #include <vector>
 #include <string>
+#include <algorithm>
 
 #include "globals.h"
 
 #include "logger.hpp"
+#include "variablearena.hpp"
+#include "batchengine.hpp"
 #include "logic_elements.hpp"
 #include "json.hpp"
 #include "utilities.hpp"
 
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * The cycles of the CPU for the profiling - or the nanoseconds where there's
+ * no time stamp counter.
+ */
+static inline unsigned long long timeStampCounter( void )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
+
+typedef std::map< std::string, std::pair<const LogicElement_Generic::signature_t&, LogicElement_Generic::FactoryType> > le_map;
+
+/**
+ * The signature and the factory of each element, by its name in the noGrAF.
+ */
+static const le_map& elementLookup( void )
+{
+  static const le_map lookup {
+    { "const<float>"   , le_map::value_type::second_type( LogicElement_Const<float>   ::signature, LogicElement_Const<float>   ::create ) },
+    { "move<float>"    , le_map::value_type::second_type( LogicElement_Move<float>    ::signature, LogicElement_Move<float>    ::create ) },
+    { "mul<float>"     , le_map::value_type::second_type( LogicElement_Mul<float>     ::signature, LogicElement_Mul<float>     ::create ) },
+    { "muladd<float>"  , le_map::value_type::second_type( LogicElement_MulAdd<float>  ::signature, LogicElement_MulAdd<float>  ::create ) },
+    { "rel<bool,float>", le_map::value_type::second_type( LogicElement_Rel<bool,float>::signature, LogicElement_Rel<bool,float>::create ) },
+    { "jumptrue<bool>" , le_map::value_type::second_type( LogicElement_JumpTrue<bool> ::signature, LogicElement_JumpTrue<bool> ::create ) },
+    { "send<float>"    , le_map::value_type::second_type( LogicElement_Send<float>    ::signature, LogicElement_Send<float>    ::create ) },
+    { "sendchanged<float>", le_map::value_type::second_type( LogicElement_SendChanged<float>::signature, LogicElement_SendChanged<float>::create ) },
+    { "get<float>"     , le_map::value_type::second_type( LogicElement_Get<float>     ::signature, LogicElement_Get<float>     ::create ) },
+    { "sum<float>"     , le_map::value_type::second_type( LogicElement_Sum<float>     ::signature, LogicElement_Sum<float>     ::create ) },
+    // superinstructions, usually only created by the Optimizer:
+    { "move2<float>"   , le_map::value_type::second_type( LogicElement_Move2<float>   ::signature, LogicElement_Move2<float>   ::create ) },
+    { "mulsum<float>"  , le_map::value_type::second_type( LogicElement_MulSum<float>  ::signature, LogicElement_MulSum<float>  ::create ) },
+    { "reljumptrue<bool,float>", le_map::value_type::second_type( LogicElement_RelJumpTrue<bool,float>::signature, LogicElement_RelJumpTrue<bool,float>::create ) },
+    { "sumconst<float>", le_map::value_type::second_type( LogicElement_SumConst<float>::signature, LogicElement_SumConst<float>::create ) },
+    { "mulconst<float>", le_map::value_type::second_type( LogicElement_MulConst<float>::signature, LogicElement_MulConst<float>::create ) }
+  };
+  return lookup;
+}
+
 constexpr const char *const LogicEngine::logicStateName[]; // give it a home
 
 LogicEngine::LogicEngine( size_t maxSize, int logicId ) :
   thisLogicId( logicId ),
   logicState( STOPPED ),
   rerun( false ),
+  dueGroups( 0 ),
+  taskPool( nullptr ),
+  nextSegment( 0 ),
+  instructionBudget( 0 ),
+  priority( 0 ),
+  awaitPending( false ),
+  outbox( nullptr ),
+  checkpoint( nullptr ),
+  snapshot( nullptr ),
+  batch( nullptr ),
+  backend( VIRTUAL ),
+  tracing( false ),
+  profiling( false ),
   variableRegistry( {std::pair<std::string, variableRegistryStorage>( "ground", { ground(), variableType::getType<float>(), &LogicEngine::readString<float> } )} ),
   lastVariableImport( MessageRegister::now() )
 {
   elementList = new LogicElement_Generic*[ maxSize ];
   elementCount = 0;
   mainTask = elementList;
-  globVar = new raw_t[10000]; // FIXME make dynamic!!!
-  for( size_t initp = 0; initp != 10000; initp++ ) globVar[initp]=0; // make valgrind happy for now...
+  globVar = nullptr;
   variableCount = variableStart();
+  variableCapacity = 0;
+  variablesFrozen = false;
+  growVariables(); // ... and "ground" is zero
   
-  // make sure "ground" is zero:
-  *reinterpret_cast<long long* const>( globVar + ground() ) = 0;
+  dt = registerVariable<float>( clockName( 0 ) );
+  groups.push_back( { 0, 0.0f, dt, lastVariableImport } );
   
   logger << "created Logicengine #" << thisLogicId << " @ " << this << " for " << maxSize << " entries;\n"; logger.show();
 }
@@ -57,24 +125,185 @@ LogicEngine::LogicEngine( LogicEngine&& other )
 : thisLogicId( other.thisLogicId ),
   logicState( other.logicState.load() ),
   rerun( other.rerun.load() ),
+  elementArena( std::move( other.elementArena ) ),
   mainTask( std::move( other.mainTask ) ),
-  lastVariableImport( std::move( other.lastVariableImport ) )
+  groups( std::move( other.groups ) ),
+  dueGroups( other.dueGroups.load() ),
+  blockStart( std::move( other.blockStart ) ),
+  blockNames( std::move( other.blockNames ) ),
+  blocks( std::move( other.blocks ) ),
+  importReaders( std::move( other.importReaders ) ),
+  statusReaders( std::move( other.statusReaders ) ),
+  unseenStatus( std::move( other.unseenStatus ) ),
+  clockReaders( std::move( other.clockReaders ) ),
+  pending( std::move( other.pending ) ),
+  followers( std::move( other.followers ) ),
+  taskPool( other.taskPool ),
+  taskCode( std::move( other.taskCode ) ),
+  segments( std::move( other.segments ) ),
+  nextSegment( other.nextSegment ),
+  instructionBudget( other.instructionBudget ),
+  priority( other.priority ),
+  awaitHandler( std::move( other.awaitHandler ) ),
+  yieldHandler( std::move( other.yieldHandler ) ),
+  awaiting( std::move( other.awaiting ) ),
+  awaitPending( other.awaitPending ),
+  outbox( other.outbox ),
+  outgoing( std::move( other.outgoing ) ),
+  checkpoint( other.checkpoint ),
+  checkpointPeriod( other.checkpointPeriod ),
+  lastCheckpoint( other.lastCheckpoint ),
+  snapshot( other.snapshot ),
+  batch( other.batch ),
+  backend( other.backend ),
+  tracing( other.tracing ),
+  profiling( other.profiling ),
+  profile( std::move( other.profile ) ),
+  byteCode( std::move( other.byteCode ) ),
+  nativeCode( std::move( other.nativeCode ) ),
+  globVar( nullptr ),
+  variableCount( 0 ),
+  variableCapacity( 0 ),
+  variablesFrozen( false ),
+  variableRegistry( std::move( other.variableRegistry ) ),
+  importRegistry( std::move( other.importRegistry ) ),
+  stateVariables( std::move( other.stateVariables ) ),
+  lastVariableImport( std::move( other.lastVariableImport ) ),
+  dt( other.dt )
 {
+  elementList = nullptr;
+  elementCount = 0;
   std::swap( elementList, other.elementList );
   std::swap( elementCount, other.elementCount );
   std::swap( globVar, other.globVar );
+  std::swap( variableCount, other.variableCount );
+  std::swap( variableCapacity, other.variableCapacity );
+  std::swap( variablesFrozen, other.variablesFrozen );
   
   logger << "moved Logicengine #" << thisLogicId << " @ " << this << ";\n"; logger.show();
 }
 
+LogicEngine::LogicEngine( GraphCache::Reader& in, int logicId )
+: LogicEngine( GraphCache::Reader( in ).get<uint64_t>(), logicId ) // peek at the number of elements
+{
+  const size_t count = in.get<uint64_t>();
+  
+  // the variables with their initial values
+  variableCount = in.get<uint64_t>();
+  if( variableCount < variableStart() )
+    throw( JSON::parseError( "Graph cache has no variables!", __LINE__ ,__FILE__ ) );
+  growVariables();
+  in.get( globVar + variableStart(), variableCount - variableStart() );
+  
+  variableRegistry.clear();
+  for( uint32_t entries = in.get<uint32_t>(); 0 < entries; --entries )
+  {
+    const std::string name = in.getString();
+    const raw_offset_t offset = in.get<uint32_t>();
+    const variableType::type type = static_cast<variableType::type>( in.get<uint8_t>() );
+    const bool imported = in.get<uint8_t>();
+    const bool state    = in.get<uint8_t>();
+    
+    variableRegistryStorage entry = { offset, type, nullptr };
+    switch( type )
+    {
+      case variableType::BOOL : entry.read = &LogicEngine::readString<bool> ; break;
+      case variableType::INT  : entry.read = &LogicEngine::readString<int>  ; break;
+      case variableType::FLOAT: entry.read = &LogicEngine::readString<float>; break;
+      default:
+        throw( JSON::parseError( "Graph cache has variable '" + name + "' of unsupported type!", __LINE__ ,__FILE__ ) );
+    }
+    if( variableCount < offset + variableType::sizeOf( type ) )
+      throw( JSON::parseError( "Graph cache has variable '" + name + "' outside of the variables!", __LINE__ ,__FILE__ ) );
+    
+    variableRegistry[ name ] = entry;
+    if( imported )
+      importRegistry[ name ] = entry;
+    if( state )
+      stateVariables.insert( name );
+  }
+  
+  // the structure of the main task
+  groups.clear();
+  for( uint32_t entries = in.get<uint32_t>(); 0 < entries; --entries )
+  {
+    const size_t start = in.get<uint64_t>();
+    const float period = in.get<float>();
+    const raw_offset_t clock = in.get<uint32_t>();
+    groups.push_back( { start, period, clock, lastVariableImport } );
+  }
+  if( groups.empty() )
+    throw( JSON::parseError( "Graph cache has no rate group!", __LINE__ ,__FILE__ ) );
+  dt = groups.front().dt;
+  
+  const size_t main = in.get<uint64_t>();
+  for( uint32_t entries = in.get<uint32_t>(); 0 < entries; --entries )
+  {
+    blockStart.push_back( in.get<uint64_t>() );
+    blockNames.push_back( in.getString() );
+  }
+  
+  // the elements, by the index of their name
+  std::vector<const le_map::mapped_type*> factories;
+  for( uint32_t entries = in.get<uint32_t>(); 0 < entries; --entries )
+  {
+    const std::string name = in.getString();
+    auto instruction = elementLookup().find( name );
+    if( elementLookup().end() == instruction )
+      throw( JSON::parseError( "Command '" + name + "' not found!", __LINE__ ,__FILE__ ) );
+    factories.push_back( &instruction->second );
+  }
+  
+  LogicElement_Generic::params_t params;
+  for( size_t i = 0; i < count; ++i )
+  {
+    const uint32_t factory = in.get<uint32_t>();
+    if( factories.size() <= factory )
+      throw( JSON::parseError( "Graph cache has an unknown element!", __LINE__ ,__FILE__ ) );
+    
+    const LogicElement_Generic::signature_t& signature = factories[ factory ]->first;
+    params.clear();
+    for( auto type = signature.cbegin(); type != signature.cend(); ++type )
+    {
+      if( LogicElement_Generic::OFFSET == *type )
+        params.push_back( static_cast<raw_offset_t>( in.get<int64_t>() ) );
+      else
+        params.push_back( in.getString() );
+    }
+    
+    addElement( factories[ factory ]->second( this, params ) ); // add by calling the Factory function
+  }
+  
+  if( count < main || std::any_of( groups.cbegin(), groups.cend(), [count]( const group_t& group ){ return count < group.start; } )
+   || std::any_of( blockStart.cbegin(), blockStart.cend(), [count]( size_t start ){ return count < start; } ) )
+    throw( JSON::parseError( "Graph cache has a task outside of the elements!", __LINE__ ,__FILE__ ) );
+  mainTask = elementList + main;
+  
+  logger << "loaded Logicengine #" << thisLogicId << " @ " << this << " with " << count << " elements from the cache;\n"; logger.show();
+}
+
 LogicEngine::~LogicEngine()
 {
   logger << "destructing LogicEngine @ " << this << ", deleting " << elementCount << " elements;\n"; logger.show();
+  // the memory of the elements in the elementArena is freed all together
+  // afterwards, only the ones on the heap are freed here
   for( size_t i = 0; i < elementCount; ++i )
   {
     delete elementList[i];
   }
   delete[] elementList;
+  
+  if( variablesFrozen )
+    VariableArena::release( globVar, variableCapacity );
+  else
+    delete[] globVar;
+}
+
+void* LogicElement_Generic::operator new( std::size_t size, ownerPtr_t owner )
+{
+  raw_t* memory = owner->elementArena.allocate( header + size );
+  memory[0] = ARENA;
+  return memory + header;
 }
 
 void LogicEngine::addElement( LogicElement_Generic* element )
@@ -82,6 +311,53 @@ void LogicEngine::addElement( LogicElement_Generic* element )
   elementList[elementCount++] = element;
 }
 
+void LogicEngine::markStartOfGroup( float period )
+{
+  if( 1 == groups.size() && nextElementPosition() == mainTask )
+  {
+    groups.front().period = period;
+    return;
+  }
+  
+  if( 8 * sizeof( dueGroups.load() ) <= groups.size() )
+    throw( JSON::parseError( "Too many rate groups!", __LINE__ ,__FILE__ ) );
+  
+  const raw_offset_t clock = registerVariable<float>( clockName( groups.size() ) );
+  groups.push_back( { elementCount, period, clock, MessageRegister::now() } );
+}
+
+void LogicEngine::growVariables( void )
+{
+  if( variableCount <= variableCapacity )
+    return;
+  
+  if( variablesFrozen )
+    throw( JSON::parseError( "Variables can't be registered while the logic is running!", __LINE__ ,__FILE__ ) );
+  
+  const size_t newCapacity = std::max<size_t>( 2 * variableCapacity, VariableArena::roundUp( variableCount ) );
+  raw_t* newVar = new raw_t[ newCapacity ]();
+  if( nullptr != globVar )
+    std::copy( globVar, globVar + variableCapacity, newVar );
+  delete[] globVar;
+  globVar = newVar;
+  variableCapacity = newCapacity;
+}
+
+void LogicEngine::freezeVariables( void )
+{
+  raw_t* store = VariableArena::allocate( variableCount );
+  std::copy( globVar, globVar + variableCount, store );
+  delete[] globVar;
+  globVar = store;
+  variableCapacity = variableCount;
+  variablesFrozen = true;
+}
+
+size_t LogicEngine::variableMemory( void ) const
+{
+  return variablesFrozen ? VariableArena::roundUp( variableCapacity ) : variableCapacity;
+}
+
 raw_offset_t LogicEngine::registerVariable( const std::string& name, variableType::type type )
 {
   switch( type )
@@ -116,15 +392,80 @@ raw_offset_t LogicEngine::registerVariable( const std::string& name, const varia
   return thisVariable;
 }
 
-void LogicEngine::copyImportedVariables( MessageRegister::timestamp_t timestamp )
+void LogicEngine::runInstances( MessageRegister::timestamp_t timestamp )
+{
+  std::vector<raw_t> value;
+  for( size_t instance = 0; instance < batch->size(); ++instance )
+  {
+    // the clocks of the rate groups are the same for all
+    for( auto group = groups.cbegin(); group != groups.cend(); ++group )
+      batch->write( instance, group->dt, globVar + group->dt, sizeof( float ) );
+    
+    for( auto it = importRegistry.cbegin(); it != importRegistry.cend(); ++it )
+    {
+      // like copyImportedVariables(), the status follows the value
+      const size_t size = variableType::sizeOf( it->second.type );
+      value.resize( size + sizeof( int ) );
+      batch->read( instance, it->second.offset, value.data(), size );
+      *reinterpret_cast<int*>( value.data() + size ) = 
+        registry.copy_value( instanceName( it->first, instance ), it->second.type, value.data(), lastVariableImport );
+      batch->write( instance, it->second.offset, value.data(), value.size() );
+    }
+  }
+  lastVariableImport = timestamp;
+  
+  batch->run();
+}
+
+std::string LogicEngine::instanceName( const std::string& name, size_t instance )
+{
+  std::string result( name );
+  const std::string number = std::to_string( instance );
+  for( size_t pos = result.find( "%i" ); std::string::npos != pos; pos = result.find( "%i", pos + number.size() ) )
+    result.replace( pos, 2, number );
+  return result;
+}
+
+void LogicEngine::copyImportedVariables( MessageRegister::timestamp_t timestamp, const std::vector<bool>& active )
 {
-  for( auto it = importRegistry.begin(); it != importRegistry.end(); ++it )
+  unsigned long long ran = 0, all = 0;
+  for( size_t g = 0; g < active.size(); ++g )
+  {
+    all |= 1ull << g;
+    if( active[g] )
+      ran |= 1ull << g;
+  }
+  
+  unseenStatus.resize( importRegistry.size(), 0 );
+  size_t index = 0;
+  for( auto it = importRegistry.begin(); it != importRegistry.end(); ++it, ++index )
   {
     register raw_t* var_p    = globVar + it->second.offset;
     register raw_t* status_p = var_p + variableType::sizeOf(it->second.type);
     
-    *reinterpret_cast<int*>( status_p ) =
-    registry.copy_value( it->first, it->second.type, var_p, lastVariableImport );
+    const int status = registry.copy_value( it->first, it->second.type, var_p, lastVariableImport );
+    int shown = status;
+    
+    if( MessageRegister::NEW_MSG == status )
+    {
+      if( blocks.empty() )
+        unseenStatus[ index ] = all;
+      else
+      {
+        markChanged( importReaders[ index ] );
+        unseenStatus[ index ] = 0;
+        for( auto b = statusReaders[ index ].cbegin(); b != statusReaders[ index ].cend(); ++b )
+          unseenStatus[ index ] |= 1ull << blocks[ *b ].group;
+      }
+    }
+    else if( MessageRegister::OLD_MSG == status && 0 != unseenStatus[ index ] )
+      shown = MessageRegister::NEW_MSG; // a group that didn't run hasn't seen it yet
+    unseenStatus[ index ] &= ~ran;
+    
+    // the readers in the groups that didn't run are still marked
+    if( !blocks.empty() && ( MessageRegister::NEW_MSG == status || *reinterpret_cast<int*>( status_p ) != shown ) )
+      markChanged( statusReaders[ index ] );
+    *reinterpret_cast<int*>( status_p ) = shown;
   }
   
   lastVariableImport = timestamp;
@@ -161,7 +502,36 @@ void LogicEngine::dump( const std::string& prefix ) const
 
 void LogicEngine::run( const instructionPointer start, const instructionPointer elEnd ) const
 {
-  logger << "LogicEngine("<<this<<")::run( " << start << ", " << elEnd << "), logicState: " << logicState << " => Running: " << (RUNNING == logicState?"true":"false") <<"\n"; logger.show();
+  // nobody would continue the run, so the elements are waiting here
+  long int unlimited = LONG_MAX;
+  instructionPointer from = start;
+  while( !run( from, elEnd, unlimited ) )
+  {
+    instructionPointer& ip = reinterpret_cast<instructionPointer*>(globVar)[0];
+    (*ip)->calc( globVar );
+    if( elEnd <= ip )
+      break;
+    from = ip;
+  }
+}
+
+bool LogicEngine::run( const instructionPointer start, const instructionPointer elEnd, long int& budget ) const
+{
+  if( isTracing() )
+    return execute<tracingAvailable, false>( start, elEnd, budget ); // only instantiate when available
+  else if( profiling )
+    return execute<false, true>( start, elEnd, budget );
+  else
+    return execute<false, false>( start, elEnd, budget );
+}
+
+template<bool trace, bool profile>
+bool LogicEngine::execute( const instructionPointer start, const instructionPointer elEnd, long int& budget ) const
+{
+  if( trace )
+  {
+    logger << "LogicEngine("<<this<<")::run( " << start << ", " << elEnd << "), logicState: " << logicState << " => Running: " << (RUNNING == logicState?"true":"false") <<"\n"; logger.show();
+  }
 
   ASSERT_MSG( start < elEnd, "Instruction pointers unplausible, " << start << " must be less than " << elEnd );
   
@@ -171,47 +541,468 @@ void LogicEngine::run( const instructionPointer start, const instructionPointer
   instructionPointer& ip = reinterpret_cast<instructionPointer*>(globVar)[0];
   //reinterpret_cast<instructionPointer*>(globVar)[0] = start;
   ip = start;
-  logger << "LogicEngine("<<this<<")::run: is running from " << start << " to " << elEnd << "...\n"; logger.show();
+  
+  if( trace )
+  {
+    logger << "LogicEngine("<<this<<")::run: is running from " << start << " to " << elEnd << "...\n"; logger.show();
+  }
+  else if( profile )
+  {
+    if( this->profile.size() != elementCount )
+      this->profile.assign( elementCount, { 0, 0 } );
+  }
+  else if( NATIVE == backend && nativeCode.isLoaded() && ( elEnd == mainTask || elEnd == elementList + elementCount ) )
+  {
+    nativeCode.run( globVar, start - elementList, elEnd - elementList, elementList );
+    return true;
+  }
+  else if( BYTECODE == backend )
+  {
+    if( !byteCode.isCompiledFrom( elementList, elementCount ) )
+      byteCode.compile( elementList, elementCount, ByteCode::END, static_cast<bool>( awaitHandler ) );
+    
+    return byteCode.run( globVar, start - elementList, elEnd - elementList, budget );
+  }
+  
+  const bool awaits = static_cast<bool>( awaitHandler );
   //while( reinterpret_cast<instructionPointer*>(globVar)[0] < elEnd )
   while( ip < elEnd )
   {
+    if( awaits && (*ip)->canAwait() )
+      return false;
+    
     //ip = reinterpret_cast<instructionPointer*>(globVar)[0];
-    (*ip)->dump( logger << "calling " << ip << ": " ); logger.show();
+    if( trace )
+    {
+      (*ip)->dump( logger << "calling " << ip << ": " ); logger.show();
+    }
     
+    const instructionPointer current = ip;
+    const unsigned long long before = profile ? timeStampCounter() : 0;
     (*ip)->calc( globVar );
+    if( profile )
+    {
+      profile_t& counter = this->profile[ current - elementList ];
+      ++counter.count;
+      counter.cycles += timeStampCounter() - before;
+    }
+    
+    if( trace )
+    {
+      ASSERT_MSG( 
+        elementList <= ip && 
+        ( ip <= elEnd || ip == reinterpret_cast<instructionPointer>(SIZE_MAX)),
+        "LogicEngine instruction pointer " << ip << " out of valid range "
+          << elementList << " ... " << elEnd << "!"
+      );
+    }
     
-    ASSERT_MSG( 
-      elementList <= ip && 
-      ( ip <= elEnd || ip == reinterpret_cast<instructionPointer>(SIZE_MAX)),
-      "LogicEngine instruction pointer " << ip << " out of valid range "
-        << elementList << " ... " << elEnd << "!"
-    );
+    // a loop uses up the budget by the instructions it jumped back
+    if( ip <= current && 0 > ( budget -= current + 1 - ip ) )
+      return false;
   }
+  
+  return true;
 }
 
-void LogicEngine::scheduleRun( MessageRegister::timestamp_t timestamp )
+bool LogicEngine::scheduleRun( MessageRegister::timestamp_t timestamp )
 {
-  logger << this << ": !!! scheduleRun 0 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+  const bool trace = isTracing();
+  if( trace )
+  {
+    logger << this << ": !!! scheduleRun 0 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+  }
   do {
-    logger << this << ": !!! scheduleRun 1 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
-    write<float>( variableRegistry.at( "__dt" ).offset, std::chrono::duration_cast<seconds_float>(timestamp - lastVariableImport).count() );
-    copyImportedVariables( timestamp );
-    logger << this << ": !!! scheduleRun 2 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
-    rerun = false;
-    run();
-    logger << this << ": !!! scheduleRun 3 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+    if( !isSuspended() )
+    {
+      if( trace )
+      {
+        logger << this << ": !!! scheduleRun 1 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+      }
+      // each group runs on its own timer, any other trigger like a message
+      // only marks the readers of the imports for the next run of their
+      // group - the groups that are only run by events are always run
+      const unsigned long long due = dueGroups.exchange( 0 );
+      std::vector<bool> active( groups.size() );
+      for( size_t g = 0; g < groups.size(); ++g )
+      {
+        active[g] = 0.0f >= groups[g].period || ( due >> g ) & 1;
+        if( !active[g] )
+          continue;
+        write<float>( groups[g].dt, std::chrono::duration_cast<seconds_float>(timestamp - groups[g].lastRun).count() );
+        groups[g].lastRun = timestamp;
+      }
+      if( nullptr != batch )
+      {
+        rerun = false;
+        runInstances( timestamp );
+      }
+      else
+      {
+        copyImportedVariables( timestamp, active );
+        if( trace )
+        {
+          logger << this << ": !!! scheduleRun 2 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+        }
+        rerun = false;
+        runChanged( active );
+      }
+    }
+    const bool finished = runSegments();
+    flushOutgoing();
+    if( !finished )
+    {
+      if( trace )
+      {
+        logger << this << ": !!! scheduleRun suspended at " << segments[ nextSegment ].first << std::endl; logger.show();
+      }
+      if( awaitPending )
+      {
+        // the handler might continue the run at once - in another thread
+        awaitPending = false;
+        const LogicElement_Generic::await_t wait = awaiting;
+        awaitHandler( this, wait );
+      }
+      else if( yieldHandler )
+      {
+        // the budget was used up, the handler might continue at once, too
+        yieldHandler( this );
+      }
+      return false;
+    }
+    if( trace )
+    {
+      logger << this << ": !!! scheduleRun 3 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+    }
     timestamp = MessageRegister::now();
+    if( nullptr == batch ) // the variables would only be the prototype
+    {
+      saveCheckpoint( timestamp );
+      if( nullptr != snapshot )
+        snapshot->publish( globVar + variableStart() );
+    }
     bool could_stop = stopLogic();
     ASSERT_MSG( could_stop, "LogicEngine state couldn't be set to STOPPED!" );
-    logger << this << ": !!! scheduleRun 4 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
-  } while( rerun );
-  logger << this << ": !!! scheduleRun 5 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
-  dump();
+    if( trace )
+    {
+      logger << this << ": !!! scheduleRun 4 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+    }
+    // a rerun starts the logic again - unless it was STOPPED and another
+    // trigger has started it meanwhile, that one runs it then
+  } while( rerun && enableVariables() && startLogic() );
+  if( trace )
+  {
+    logger << this << ": !!! scheduleRun 5 rr:" << (rerun?"t":"f") << ", state: " << logicStateName[logicState] << std::endl; logger.show();
+    dump();
+  }
+  return true;
 }
 
-std::string LogicEngine::export_noGrAF( void ) const
+void LogicEngine::setCheckpoint( Checkpoint* target, float period )
+{
+  checkpoint = target;
+  checkpointPeriod = std::chrono::duration_cast<MessageRegister::timestamp_t::duration>( seconds_float( period ) );
+  lastCheckpoint = MessageRegister::now();
+}
+
+bool LogicEngine::takeSnapshot( std::map<std::string, variable_t>& values ) const
+{
+  if( nullptr == snapshot )
+    return false;
+  
+  std::vector<raw_t> copy( snapshot->size() );
+  snapshot->read( copy.data() );
+  const Snapshot::table_t table = snapshot->table();
+  for( auto it = table.cbegin(); it != table.cend(); ++it )
+  {
+    const raw_t* const variable = copy.data() + it->offset;
+    switch( it->type )
+    {
+      case variableType::BOOL:
+        values[ it->name ] = variable_t( *reinterpret_cast<const bool*>( variable ) );
+        break;
+      case variableType::INT:
+        values[ it->name ] = variable_t( *reinterpret_cast<const int*>( variable ) );
+        break;
+      case variableType::FLOAT:
+        values[ it->name ] = variable_t( *reinterpret_cast<const float*>( variable ) );
+        break;
+      default:
+        ; // not stored in the variables
+    }
+  }
+  return true;
+}
+
+Snapshot::table_t LogicEngine::snapshotTable( void ) const
+{
+  Snapshot::table_t table;
+  for( auto it = variableRegistry.cbegin(); it != variableRegistry.cend(); ++it )
+  {
+    if( it->second.offset < variableStart() )
+      continue; // "ground"
+    
+    const Snapshot::variable_t variable = { it->first, static_cast<size_t>( it->second.offset - variableStart() ), it->second.type };
+    table.push_back( variable );
+  }
+  return table;
+}
+
+void LogicEngine::getProfile( std::vector<profile_t>& elements, std::map<std::string, profile_t>& perBlock ) const
+{
+  elements = profile;
+  for( size_t i = 0; i < elements.size(); ++i )
+  {
+    // the block that starts last before the element
+    const auto next = std::upper_bound( blockStart.cbegin(), blockStart.cend(), i );
+    const std::string& block = blockStart.cbegin() == next ? "" : blockNames[ next - blockStart.cbegin() - 1 ];
+    profile_t& sum = perBlock.insert( std::make_pair( block, profile_t{ 0, 0 } ) ).first->second;
+    sum.count  += elements[i].count;
+    sum.cycles += elements[i].cycles;
+  }
+}
+
+size_t LogicEngine::adoptVariables( const LogicEngine& other )
+{
+  // only the state is carried over, parameters and constants written by the
+  // init of the new logic stay as they are. The imports are kept as well,
+  // as the bus won't send their current values again.
+  std::set<std::string> names( stateVariables );
+  for( auto it = importRegistry.cbegin(); it != importRegistry.cend(); ++it )
+  {
+    names.insert( it->first );
+    names.insert( it->first + "_status" );
+  }
+  
+  size_t adopted = 0;
+  for( auto name = names.cbegin(); name != names.cend(); ++name )
+  {
+    auto target = variableRegistry.find( *name );
+    auto source = other.variableRegistry.find( *name );
+    if( variableRegistry.end() == target || other.variableRegistry.end() == source 
+     || source->second.type != target->second.type )
+      continue;
+    
+    std::copy( other.globVar + source->second.offset, 
+               other.globVar + source->second.offset + variableType::sizeOf( target->second.type ),
+               globVar + target->second.offset );
+    ++adopted;
+  }
+  return adopted;
+}
+
+void LogicEngine::subscribeImports( void )
+{
+  const size_t instances = nullptr == batch ? 1 : batch->size();
+  for( auto it = importRegistry.cbegin(); it != importRegistry.cend(); ++it )
+    for( size_t instance = 0; instance < instances; ++instance )
+      registry.subscribe( nullptr == batch ? it->first : instanceName( it->first, instance ), it->second.type,
+                          MessageRegister::MessageRegisterSubscribers_t( this, nullptr ) );
+}
+
+uint64_t LogicEngine::layoutKey( void ) const
+{
+  std::stringstream layout;
+  layout << variableCount << "\n";
+  for( auto it = variableRegistry.cbegin(); it != variableRegistry.cend(); ++it )
+    layout << it->first << " " << it->second.type << " " << it->second.offset << "\n";
+  return Checkpoint::hash( layout.str() );
+}
+
+std::vector<const LogicEngine::variableRegistryStorage*> LogicEngine::stateEntries( void ) const
+{
+  // a state variable might have been removed by the Optimizer
+  std::vector<const variableRegistryStorage*> entries;
+  for( auto name = stateVariables.cbegin(); name != stateVariables.cend(); ++name )
+  {
+    auto variable = variableRegistry.find( *name );
+    if( variableRegistry.end() != variable )
+      entries.push_back( &variable->second );
+  }
+  return entries;
+}
+
+uint64_t LogicEngine::stateKey( void ) const
+{
+  // the place of a variable doesn't matter, the state is stored by name
+  std::stringstream layout;
+  for( auto name = stateVariables.cbegin(); name != stateVariables.cend(); ++name )
+  {
+    auto variable = variableRegistry.find( *name );
+    if( variableRegistry.end() != variable )
+      layout << *name << " " << variable->second.type << "\n";
+  }
+  return Checkpoint::hash( layout.str() );
+}
+
+size_t LogicEngine::stateSize( void ) const
+{
+  const std::vector<const variableRegistryStorage*> entries = stateEntries();
+  size_t size = 0;
+  for( auto entry = entries.cbegin(); entry != entries.cend(); ++entry )
+    size += variableType::sizeOf( (*entry)->type );
+  return size;
+}
+
+std::vector<raw_t> LogicEngine::captureState( void ) const
+{
+  const std::vector<const variableRegistryStorage*> entries = stateEntries();
+  std::vector<raw_t> state;
+  for( auto entry = entries.cbegin(); entry != entries.cend(); ++entry )
+    state.insert( state.end(), globVar + (*entry)->offset, globVar + (*entry)->offset + variableType::sizeOf( (*entry)->type ) );
+  return state;
+}
+
+bool LogicEngine::restoreCheckpoint( void )
+{
+  std::vector<raw_t> state( stateSize() );
+  if( nullptr == checkpoint || !checkpoint->restore( state.data() ) )
+    return false;
+  
+  const std::vector<const variableRegistryStorage*> entries = stateEntries();
+  const raw_t* value = state.data();
+  for( auto entry = entries.cbegin(); entry != entries.cend(); ++entry )
+  {
+    const size_t size = variableType::sizeOf( (*entry)->type );
+    std::copy( value, value + size, globVar + (*entry)->offset );
+    value += size;
+  }
+  return true;
+}
+
+void LogicEngine::runChanged( const std::vector<bool>& active )
+{
+  const bool all = std::all_of( active.cbegin(), active.cend(), []( bool a ){ return a; } );
+  
+  if( blocks.empty() )
+  {
+    if( all )
+      segments.push_back( { groupStart( 0 ), elementCount } );
+    else
+      for( size_t g = 0; g < groups.size(); ++g )
+        if( active[g] && groupStart( g ) < groupEnd( g ) )
+          segments.push_back( { groupStart( g ), groupEnd( g ) } );
+    return;
+  }
+  
+  for( size_t g = 0; g < groups.size(); ++g )
+    if( active[g] )
+      markChanged( clockReaders[g] );
+  
+  // the successors are always behind their block and in the same group, so
+  // a single pass in program order finds all affected blocks
+  std::vector<bool> dirty( blocks.size(), false );
+  bool changed = false;
+  for( size_t b = 0; b < blocks.size(); ++b )
+  {
+    if( !active[ blocks[b].group ] || !( dirty[b] || pending[b] ) )
+      continue;
+    dirty[b] = true;
+    pending[b] = false;
+    changed = true;
+    for( auto s = blocks[b].successors.cbegin(); s != blocks[b].successors.cend(); ++s )
+      dirty[ *s ] = true;
+  }
+  
+  if( !changed )
+  {
+    if( isTracing() )
+    {
+      logger << this << ": nothing changed, run skipped\n"; logger.show();
+    }
+    return;
+  }
+  
+  if( all && NATIVE == backend && nativeCode.isLoaded() && !profiling )
+  {
+    // the native code can only run the main task as a whole
+    std::fill( dirty.begin(), dirty.end(), true );
+    segments.push_back( { groupStart( 0 ), elementCount } );
+  }
+  else if( taskPool && BYTECODE == backend && !isTracing() && !profiling &&
+           1 < std::count( dirty.cbegin(), dirty.cend(), true ) && !awaitsIn( dirty ) )
+    runParallel( dirty );
+  else
+  {
+    // neighbouring blocks are run together
+    for( size_t b = 0; b < blocks.size(); ++b )
+    {
+      if( !dirty[b] )
+        continue;
+      const size_t first = b;
+      while( b + 1 < blocks.size() && dirty[b + 1] )
+        ++b;
+      segments.push_back( { blocks[first].start, blocks[b].end } );
+    }
+  }
+  
+  for( size_t b = 0; b < blocks.size(); ++b )
+  {
+    if( !dirty[b] )
+      continue;
+    for( auto c = blocks[b].carried.cbegin(); c != blocks[b].carried.cend(); ++c )
+      pending[ *c ] = true;
+  }
+}
+
+bool LogicEngine::runSegments( void )
+{
+  long int left = 0 < instructionBudget ? instructionBudget : LONG_MAX;
+  for( ; nextSegment < segments.size(); ++nextSegment )
+  {
+    segment_t& segment = segments[ nextSegment ];
+    if( segment.first < segment.second && 
+        !run( elementList + segment.first, elementList + segment.second, left ) )
+    {
+      const instructionPointer ip = reinterpret_cast<instructionPointer*>( globVar )[0];
+      if( awaitHandler && (*ip)->canAwait() )
+      {
+        // the awaitHandler does the work of the element, the run continues
+        // behind it
+        (*ip)->await( globVar, awaiting );
+        awaitPending = true;
+        segment.first = ip + 1 - elementList;
+      }
+      else
+        segment.first = ip - elementList; // continue there with the next slice
+      return false;
+    }
+  }
+  
+  segments.clear();
+  nextSegment = 0;
+  return true;
+}
+
+void LogicEngine::runParallel( const std::vector<bool>& dirty )
+{
+  ASSERT_MSG( RUNNING == logicState, "LogicEngine::runParallel() called during wrong state (" << logicStateName[logicState] << ")" );
+  
+  if( taskCode.size() != blocks.size() )
+  {
+    // the blocks don't store the instruction pointer at their end, so they
+    // don't disturb each other
+    taskCode.assign( blocks.size(), ByteCode() );
+    for( size_t b = 0; b < blocks.size(); ++b )
+      taskCode[b].compile( elementList + blocks[b].start, blocks[b].end - blocks[b].start, ByteCode::RETURN );
+  }
+  
+  taskPool->run( followers, dirty, [this]( size_t b ){
+    if( blocks[b].calls )
+    {
+      std::lock_guard<std::mutex> lock( callMutex );
+      taskCode[b].run( globVar );
+    }
+    else
+      taskCode[b].run( globVar );
+  });
+}
+
+std::string LogicEngine::export_noGrAF( bool exact ) const
 {
   std::stringstream out;
+  if( exact )
+    out.precision( std::numeric_limits<float>::max_digits10 );
   
   instructionPointer ip = elementList;
   const instructionPointer elEnd = elementList + elementCount;
@@ -228,22 +1019,133 @@ std::string LogicEngine::export_noGrAF( void ) const
   return out.str();
 }
 
-void LogicEngine::import_noGrAF( std::istream& in, bool symbolicVariables, std::string prefix, const translation_t& translation )
+bool LogicEngine::exportCompiled( GraphCache::Writer& out ) const
 {
-  std::string line;
+  // split the elements into their name and parameters like import_noGrAF()
+  // does, the numbers are written exactly and the offsets as binary values
+  std::map<std::string, uint32_t> names;
+  std::vector<std::pair<uint32_t, LogicElement_Generic::params_t>> elements;
+  std::vector<const LogicElement_Generic::signature_t*> signatures;
+  for( size_t i = 0; i < elementCount; ++i )
+  {
+    std::stringstream dump;
+    dump.precision( std::numeric_limits<float>::max_digits10 );
+    elementList[i]->dump( dump );
+    std::string line = dump.str();
+    line.erase( std::remove_if( line.begin(), line.end(), ::isspace ), line.end() );
+    
+    const size_t paramStart = line.find( "(" );
+    const size_t paramEnd   = line.rfind( ")" );
+    if( std::string::npos == paramStart || std::string::npos == paramEnd || paramEnd < paramStart )
+      return false;
+    
+    const std::string name = line.substr( 0, paramStart );
+    auto instruction = elementLookup().find( name );
+    if( elementLookup().end() == instruction )
+      return false;
+    
+    const LogicElement_Generic::signature_t& signature = instruction->second.first;
+    LogicElement_Generic::params_t params;
+    std::stringstream list( line.substr( paramStart + 1, paramEnd - paramStart - 1 ) );
+    std::string param;
+    while( getline( list, param, ',' ) )
+    {
+      if( signature.size() <= params.size() )
+        return false;
+      if( LogicElement_Generic::OFFSET == signature[ params.size() ] )
+      {
+        char* end;
+        const raw_offset_t offset = std::strtoll( param.c_str(), &end, 10 );
+        if( param.empty() || '\0' != *end )
+          return false;
+        params.push_back( offset );
+        continue;
+      }
+      if( '"' == param[0] )
+        param = param.substr( 1, param.length()-2 );
+      params.push_back( param );
+    }
+    if( signature.size() != params.size() )
+      return false;
+    
+    auto index = names.insert( std::make_pair( name, names.size() ) ).first;
+    elements.push_back( std::make_pair( index->second, std::move( params ) ) );
+    signatures.push_back( &signature );
+  }
+  
+  out.put<uint64_t>( elementCount );
+  
+  out.put<uint64_t>( variableCount );
+  out.put( globVar + variableStart(), variableCount - variableStart() );
+  out.put<uint32_t>( variableRegistry.size() );
+  for( auto it = variableRegistry.cbegin(); it != variableRegistry.cend(); ++it )
+  {
+    out.put( it->first );
+    out.put<uint32_t>( it->second.offset );
+    out.put<uint8_t>( it->second.type );
+    out.put<uint8_t>( importRegistry.count( it->first ) );
+    out.put<uint8_t>( stateVariables.count( it->first ) );
+  }
+  
+  out.put<uint32_t>( groups.size() );
+  for( auto group = groups.cbegin(); group != groups.cend(); ++group )
+  {
+    out.put<uint64_t>( group->start );
+    out.put<float>( group->period );
+    out.put<uint32_t>( group->dt );
+  }
+  
+  out.put<uint64_t>( mainTask - elementList );
+  out.put<uint32_t>( blockStart.size() );
+  for( size_t b = 0; b < blockStart.size(); ++b )
+  {
+    out.put<uint64_t>( blockStart[b] );
+    out.put( blockNames[b] );
+  }
+  
+  std::vector<std::string> table( names.size() );
+  for( auto it = names.cbegin(); it != names.cend(); ++it )
+    table[ it->second ] = it->first;
+  out.put<uint32_t>( table.size() );
+  for( auto name = table.cbegin(); name != table.cend(); ++name )
+    out.put( *name );
+  
+  for( size_t i = 0; i < elements.size(); ++i )
+  {
+    out.put<uint32_t>( elements[i].first );
+    for( size_t p = 0; p < elements[i].second.size(); ++p )
+    {
+      if( LogicElement_Generic::OFFSET == (*signatures[i])[p] )
+        out.put<int64_t>( elements[i].second[p].offset );
+      else
+        out.put( elements[i].second[p].text );
+    }
+  }
+  
+  return true;
+}
 
-  typedef std::map< std::string, std::pair<const LogicElement_Generic::signature_t&, LogicElement_Generic::FactoryType> > le_map;
-  static const le_map lookup {
-    { "const<float>"   , le_map::value_type::second_type( LogicElement_Const<float>   ::signature, LogicElement_Const<float>   ::create ) },
-    { "move<float>"    , le_map::value_type::second_type( LogicElement_Move<float>    ::signature, LogicElement_Move<float>    ::create ) },
-    { "mul<float>"     , le_map::value_type::second_type( LogicElement_Mul<float>     ::signature, LogicElement_Mul<float>     ::create ) },
-    { "muladd<float>"  , le_map::value_type::second_type( LogicElement_MulAdd<float>  ::signature, LogicElement_MulAdd<float>  ::create ) },
-    { "rel<bool,float>", le_map::value_type::second_type( LogicElement_Rel<bool,float>::signature, LogicElement_Rel<bool,float>::create ) },
-    { "jumptrue<bool>" , le_map::value_type::second_type( LogicElement_JumpTrue<bool> ::signature, LogicElement_JumpTrue<bool> ::create ) },
-    { "send<float>"    , le_map::value_type::second_type( LogicElement_Send<float>    ::signature, LogicElement_Send<float>    ::create ) },
-    { "get<float>"     , le_map::value_type::second_type( LogicElement_Get<float>     ::signature, LogicElement_Get<float>     ::create ) },
-    { "sum<float>"     , le_map::value_type::second_type( LogicElement_Sum<float>     ::signature, LogicElement_Sum<float>     ::create ) }
-  };
+void LogicEngine::exportNative( std::ostream& out ) const
+{
+  ByteCode code;
+  code.compile( elementList, elementCount );
+  NativeCode::generate( code, mainTask - elementList, nativeKey(), out );
+}
+
+bool LogicEngine::loadNative( const std::string& path )
+{
+  if( !nativeCode.load( path, nativeKey() ) )
+    return false;
+  
+  backend = NATIVE;
+  return true;
+}
+
+LogicEngine::program_t LogicEngine::parse_noGrAF( std::istream& in )
+{
+  program_t program;
+  std::map<std::string, size_t> symbols;
+  std::string line;
   
   while( in.good() )
   {
@@ -265,17 +1167,18 @@ void LogicEngine::import_noGrAF( std::istream& in, bool symbolicVariables, std::
         throw( JSON::parseError( "Implementation error at variable definition: '" + line + "'", __LINE__ ,__FILE__ ) );
       
       std::string type = line.substr( 4, found - 4 );
-      std::string name = prefix + line.substr( found + 1 );
+      program_t::statement_t definition = { nullptr, variableType::UNKNOWN, { { program_t::LITERAL, line.substr( found + 1 ), 0, 0 } } };
 
       if( "bool" == type )
-        registerVariable<bool>( name );
+        definition.type = variableType::BOOL;
       else if( "int" == type )
-        registerVariable<int>( name );
+        definition.type = variableType::INT;
       else if( "float" == type )
-        registerVariable<float>( name );
+        definition.type = variableType::FLOAT;
       else
         throw( JSON::parseError( "Implementation error at variable definition, unknown type '" + type + "' in '" + line + "'", __LINE__ ,__FILE__ ) );
       
+      program.statements.push_back( std::move( definition ) );
       continue;
     }
     
@@ -293,81 +1196,145 @@ void LogicEngine::import_noGrAF( std::istream& in, bool symbolicVariables, std::
       continue;  // nothing to do in a empty line
       
     size_t paramStart = line.find( "(" );
-    auto instruction = lookup.find( line.substr( 0, paramStart ) );
-    if( lookup.end() == instruction )
+    auto instruction = elementLookup().find( line.substr( 0, paramStart ) );
+    if( elementLookup().end() == instruction )
     {
       throw( JSON::parseError( "Command '" + line.substr( 0, paramStart ) + "' not found!", __LINE__ ,__FILE__ ) );
     }
-      
+    
     // find parameters
+    const LogicElement_Generic::signature_t& signature = instruction->second.first;
+    program_t::statement_t statement = { instruction->second.second, variableType::UNKNOWN, {} };
     size_t found;
     paramStart++; // move post '('
-    std::vector<std::string> params;
-    auto getParam = [&]( size_t start, size_t end ) -> std::string {
+    auto getParam = [&]( size_t start, size_t end ) -> program_t::operand_t {
       std::string pureVar = line.substr( start, end - start );
-      switch( instruction->second.first.at(params.size()) )
+      if( signature.size() <= statement.operands.size() )
+        throw( JSON::parseError( "Too many parameters in '" + line + "'", __LINE__ ,__FILE__ ) );
+      
+      switch( signature[ statement.operands.size() ] )
       {
         case LogicElement_Generic::VARIABLE_T:
           if( '"' == pureVar[0] )
-            return pureVar.substr( 1, pureVar.length()-2 );
-          return pureVar;
+            return { program_t::LITERAL, pureVar.substr( 1, pureVar.length()-2 ), 0, 0 };
+          return { program_t::LITERAL, pureVar, 0, 0 };
           
         case LogicElement_Generic::STRING:
           if( '"' == pureVar[0] )
-            return pureVar.substr( 1, pureVar.length()-2 );
-          {
-            auto variable = translation.find( prefix + pureVar );
-            if( translation.end() != variable )
-              return variable->second;
-            variable = translation.find( pureVar );
-            if( translation.end() != variable )
-              return variable->second;
-          }
-          return pureVar;
+            return { program_t::LITERAL, pureVar.substr( 1, pureVar.length()-2 ), 0, 0 };
+          return { program_t::STRING, pureVar, 0, 0 };
           
         default:
           ;// just continue outside...
       } 
       
       // case LogicElement_Generic::OFFSET:
-      if( std::all_of(pureVar.begin(), pureVar.end(), ::isdigit) )
-        return pureVar;
-
-      std::string var = prefix + pureVar;
-      if( symbolicVariables )
-      {
-        auto translationEntry = translation.find( var );
-        if( translationEntry != translation.end() )
-          var = translationEntry->second;
-        auto variable = variableRegistry.find( var );
-        
-        if( variableRegistry.end() == variable ) // if not found: retry global
-          variable = variableRegistry.find( pureVar );
-        
-        if( variableRegistry.end() == variable ) 
-          throw( JSON::parseError( "Variable '" + var + "' not found! Connection missing?", __LINE__ ,__FILE__ ) );
-        
-        return std::to_string( variable->second.offset );
-      }
-      else
-        return var;
+      auto digits = pureVar.begin() + ( '-' == pureVar[0] ? 1 : 0 );
+      if( digits != pureVar.end() && std::all_of( digits, pureVar.end(), ::isdigit ) )
+        return { program_t::ADDRESS, pureVar, static_cast<raw_offset_t>( std::stoll( pureVar ) ), 0 };
+      auto symbol = symbols.insert( std::make_pair( pureVar, program.symbols.size() ) );
+      if( symbol.second )
+        program.symbols.push_back( pureVar );
+      return { program_t::OFFSET, pureVar, 0, symbol.first->second };
     };
 
     while( (found = line.find( ",", paramStart )) != std::string::npos )
     {
-      params.push_back( getParam( paramStart, found ) );
+      statement.operands.push_back( getParam( paramStart, found ) );
       paramStart = found+1;
     }
     if( (found = line.find( ")", paramStart )) != std::string::npos )
+      statement.operands.push_back( getParam( paramStart, found ) );
+    else
+      throw( JSON::parseError( "Syntax error in '" + line + "'", __LINE__ ,__FILE__ ) );
+    
+    if( signature.size() != statement.operands.size() )
+      throw( JSON::parseError( "Missing parameters in '" + line + "'", __LINE__ ,__FILE__ ) );
+    
+    program.statements.push_back( std::move( statement ) );
+    program.instructions++;
+  }
+  
+  return program;
+}
+
+void LogicEngine::import_noGrAF( std::istream& in, bool symbolicVariables, std::string prefix, const translation_t& translation )
+{
+  import_noGrAF( parse_noGrAF( in ), symbolicVariables, prefix, translation );
+}
+
+void LogicEngine::import_noGrAF( const program_t& program, bool symbolicVariables, const std::string& prefix, const translation_t& translation )
+{
+  LogicElement_Generic::params_t params;
+  // each variable is looked up only once per import, the instructions get
+  // the offsets directly
+  std::vector<raw_offset_t> offsets( program.symbols.size(), -1 );
+  auto resolve = [&]( size_t symbol ) -> raw_offset_t {
+    if( -1 != offsets[ symbol ] )
+      return offsets[ symbol ];
+    
+    const std::string& pureVar = program.symbols[ symbol ];
+    std::string var = prefix + pureVar;
+    if( !symbolicVariables )
+      throw( JSON::parseError( "Variable '" + var + "' used without symbolic variables!", __LINE__ ,__FILE__ ) );
+    
+    auto translationEntry = translation.find( var );
+    if( translationEntry != translation.end() )
+      var = translationEntry->second;
+    auto variable = variableRegistry.find( var );
+    
+    if( variableRegistry.end() == variable ) // if not found: retry global
+      variable = variableRegistry.find( pureVar );
+    
+    if( variableRegistry.end() == variable ) 
+      throw( JSON::parseError( "Variable '" + var + "' not found! Connection missing?", __LINE__ ,__FILE__ ) );
+    
+    return offsets[ symbol ] = variable->second.offset;
+  };
+  
+  for( auto statement = program.statements.cbegin(); statement != program.statements.cend(); ++statement )
+  {
+    if( nullptr == statement->create )
+    {
+      const std::string name = prefix + statement->operands.front().text;
+      if( variableType::BOOL == statement->type )
+        registerVariable<bool>( name );
+      else if( variableType::INT == statement->type )
+        registerVariable<int>( name );
+      else
+        registerVariable<float>( name );
+      continue;
+    }
+    
+    params.clear();
+    for( auto operand = statement->operands.cbegin(); operand != statement->operands.cend(); ++operand )
     {
-      params.push_back( getParam( paramStart, found ) );
-    } else {
-      // FIXME thow error!
-      // throw "Syntax error!";
-      logger << "Syntax error! '" << line << "'" << std::endl;
+      switch( operand->kind )
+      {
+        case program_t::LITERAL:
+          params.push_back( operand->text );
+          break;
+          
+        case program_t::STRING:
+          {
+            auto variable = translation.find( prefix + operand->text );
+            if( translation.end() == variable )
+              variable = translation.find( operand->text );
+            params.push_back( translation.end() != variable ? variable->second : operand->text );
+          }
+          break;
+          
+        case program_t::OFFSET:
+          params.push_back( resolve( operand->symbol ) );
+          break;
+          
+        case program_t::ADDRESS:
+          params.push_back( operand->offset );
+          break;
+      }
     }
     
-    addElement( instruction->second.second( this, params ) ); // add by calling the Factory function
+    addElement( statement->create( this, params ) ); // add by calling the Factory function
   }
 }
 
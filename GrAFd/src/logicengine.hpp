@@ -22,24 +22,40 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include <iostream>
 #include <sstream>
 #include <atomic>
 #include <chrono>
+#include <mutex>
+#include <functional>
 
 #include "globals.h"
 
 #include "variabletype.hpp"
 #include "messageregister.hpp"
 #include "logger.hpp"
+#include "bytecode.hpp"
+#include "nativecode.hpp"
+#include "elementarena.hpp"
+#include "taskpool.hpp"
+#include "outbox.hpp"
+#include "checkpoint.hpp"
+#include "snapshot.hpp"
+#include "graphcache.hpp"
+#include "logic_elements/logicelement_generic.hpp"
 
-class LogicElement_Generic;
+class BatchEngine;
 
 /**
  * The LogicEngine holds and runs a list of LogicElements.
  */
 class LogicEngine
 {
+  friend class Optimizer;
+  friend class BatchEngine;
+  friend class LogicElement_Generic;
+  
 public:
   /**
    * Instruction pointer - an iterator in the array
@@ -59,6 +75,45 @@ public:
    */
   constexpr static const char *const logicStateName[3] = { "STOPPED", "COPIED", "RUNNING" };
   
+  /**
+   * Is the tracing of the execution compiled in? (Build option GRAFD_TRACING)
+   */
+#ifdef GRAFD_TRACING
+  static constexpr bool tracingAvailable = true;
+#else
+  static constexpr bool tracingAvailable = false;
+#endif
+  
+  /**
+   * The possible backends to execute the logic.
+   */
+  enum backend_t {
+    VIRTUAL,  ///< call the virtual calc() of each LogicElement - the reference
+    BYTECODE, ///< run the lowered ByteCode in a threaded dispatch loop
+    NATIVE    ///< run the ahead of time compiled NativeCode, see loadNative()
+  };
+  
+  /**
+   * The function that does the waiting of an element for the suspended
+   * LogicEngine, see setAwaitHandler().
+   */
+  typedef std::function<void( LogicEngine*, const LogicElement_Generic::await_t& )> awaitHandler_t;
+  
+  /**
+   * The function that queues the LogicEngine again when its run was
+   * suspended as the budget was used up, see setYieldHandler().
+   */
+  typedef std::function<void( LogicEngine* )> yieldHandler_t;
+  
+  /**
+   * The counters of the profiling, see setProfiling().
+   */
+  struct profile_t
+  {
+    unsigned long long count;  ///< the number of executions
+    unsigned long long cycles; ///< the time stamp counter cycles used
+  };
+  
 private:
   /**
    * The logic ID of this logic.
@@ -85,11 +140,225 @@ private:
    */
   size_t elementCount;
   
+  /**
+   * The memory of the elements, in program order.
+   */
+  ElementArena elementArena;
+  
   /**
    * The first LogicElement that is from the normal task, i.e. not belonging to
    * the init task.
    */
   instructionPointer mainTask;
+  
+  /**
+   * A rate group, i.e. the part of the main task that runs with one sample
+   * time. The groups follow each other in program order, the first starts
+   * at the mainTask.
+   */
+  struct group_t
+  {
+    size_t start;         ///< index of the first element, not used for the first group
+    float period;         ///< the sample time in seconds, 0 when only run by events
+    raw_offset_t dt;      ///< offset of the time since its last run, __dt for the first group
+    MessageRegister::timestamp_t lastRun;
+  };
+  
+  /**
+   * All rate groups, there is at least the first one.
+   */
+  std::vector<group_t> groups;
+  
+  /**
+   * The groups whose timer has fired since the last run, one bit each.
+   */
+  std::atomic<unsigned long long> dueGroups;
+  
+  /**
+   * The index of the first element of each block of the main task, i.e. of
+   * the instructions of one GraphBlock, in program order.
+   */
+  std::vector<size_t> blockStart;
+  
+  /**
+   * The name of the GraphBlock of each entry in blockStart.
+   */
+  std::vector<std::string> blockNames;
+  
+  /**
+   * A block of the main task and the blocks that depend on it.
+   */
+  struct block_t
+  {
+    size_t start;                   ///< index of the first element
+    size_t end;                     ///< index behind the last element
+    size_t group;                   ///< the rate group it belongs to
+    std::vector<size_t> successors; ///< the later blocks of its group that read its results
+    std::vector<size_t> carried;    ///< the blocks that read its results in the next run
+    bool calls;                     ///< it has elements that are called, i.e. without opcode
+    bool awaits;                    ///< it has elements that can await, e.g. a sleep or a send
+  };
+  
+  /**
+   * The blocks for the incremental run, created by
+   * Optimizer::dependencies() - empty when the whole main task has to run.
+   */
+  std::vector<block_t> blocks;
+  
+  /**
+   * The blocks that read each imported variable, in the order of the
+   * importRegistry.
+   */
+  std::vector<std::vector<size_t>> importReaders;
+  
+  /**
+   * The blocks that read the status of each imported variable, in the order
+   * of the importRegistry.
+   */
+  std::vector<std::vector<size_t>> statusReaders;
+  
+  /**
+   * For each imported variable the groups, one bit each, that read its
+   * status and haven't run since it got a new message - it stays NEW_MSG
+   * for them.
+   */
+  std::vector<unsigned long long> unseenStatus;
+  
+  /**
+   * The blocks that read the time since the last run of each group, i.e.
+   * that have to run every time their group runs.
+   */
+  std::vector<std::vector<size_t>> clockReaders;
+  
+  /**
+   * The blocks that have to run at the next run.
+   */
+  std::vector<bool> pending;
+  
+  /**
+   * For each block the later blocks that access a variable it writes or that
+   * write a variable it reads, i.e. that have to wait for it when the blocks
+   * run in parallel.
+   */
+  std::vector<std::vector<size_t>> followers;
+  
+  /**
+   * The pool that runs the blocks in parallel, nullptr when they run one
+   * after the other.
+   */
+  TaskPool* taskPool;
+  
+  /**
+   * The ByteCode of each block for the parallel run. It's created on demand
+   * at the first parallel run after the blocks were changed.
+   */
+  std::vector<ByteCode> taskCode;
+  
+  /**
+   * Held by a block with called elements during the parallel run, as these
+   * use the instruction pointer and might have side effects.
+   */
+  std::mutex callMutex;
+  
+  /**
+   * A part of the elements that has to be run: the index of the first and
+   * of the one behind the last element.
+   */
+  typedef std::pair<size_t, size_t> segment_t;
+  
+  /**
+   * The parts of the logic that the current run still has to run, starting
+   * at nextSegment - the run continues there after it was suspended.
+   */
+  std::vector<segment_t> segments;
+  size_t nextSegment;
+  
+  /**
+   * The instructions a run may use up before it's suspended, 0 without
+   * limit. See setBudget().
+   */
+  long int instructionBudget;
+  
+  /**
+   * The priority of this logic when it's queued to run.
+   */
+  int priority;
+  
+  /**
+   * Does the waiting of the elements while the run is suspended, empty when
+   * the elements are waiting in calc().
+   */
+  awaitHandler_t awaitHandler;
+  
+  /**
+   * Queues the suspended run again when the budget was used up, empty when
+   * the caller of scheduleRun() has to do it.
+   */
+  yieldHandler_t yieldHandler;
+  
+  /**
+   * What the element that suspended the run waits for - valid while
+   * awaitPending.
+   */
+  LogicElement_Generic::await_t awaiting;
+  bool awaitPending;
+  
+  /**
+   * Where the messages of a run are queued to, nullptr when each send is
+   * waiting for its reply.
+   */
+  Outbox* outbox;
+  
+  /**
+   * The messages of the current run, queued to the outbox after it.
+   */
+  Outbox::batch_t outgoing;
+  
+  /**
+   * Where the variables are saved to after a run, at most once per
+   * checkpointPeriod - nullptr for never.
+   */
+  Checkpoint* checkpoint;
+  MessageRegister::timestamp_t::duration checkpointPeriod;
+  MessageRegister::timestamp_t lastCheckpoint;
+  
+  /**
+   * Where the variables are published after each run, nullptr for nowhere.
+   */
+  Snapshot* snapshot;
+  
+  /**
+   * Runs the instances of this logic instead of it, nullptr when there's
+   * only this one.
+   */
+  BatchEngine* batch;
+  
+  /**
+   * The backend that is used by run().
+   */
+  backend_t backend;
+  
+  /**
+   * Log each executed element and the scheduling, i.e. debug this logic.
+   */
+  bool tracing;
+  
+  /**
+   * Count the executions and the cycles of each element, see setProfiling().
+   */
+  bool profiling;
+  mutable std::vector<profile_t> profile;
+  
+  /**
+   * The elementList lowered for the BYTECODE backend. It's created on demand
+   * at the first run() after the elements were changed.
+   */
+  mutable ByteCode byteCode;
+  
+  /**
+   * The shared object for the NATIVE backend.
+   */
+  NativeCode nativeCode;
 
   /**
    * Store of all variables.
@@ -107,6 +376,19 @@ private:
    */
   size_t variableCount;
   
+  /**
+   * The size of the array globVar[]. While the logic is build it grows as
+   * needed, freezeVariables() moves it to the VariableArena with the exact
+   * size.
+   */
+  size_t variableCapacity;
+  
+  /**
+   * Is globVar[] in the VariableArena, i.e. no more variables can be
+   * registered?
+   */
+  bool variablesFrozen;
+  
   struct variableRegistryStorage
   {
     raw_offset_t offset;
@@ -116,7 +398,18 @@ private:
   typedef std::map<std::string, variableRegistryStorage> variableRegistry_t;
   variableRegistry_t variableRegistry;
   variableRegistry_t importRegistry;
+  
+  /**
+   * The names of the variables that carry the state of the logic, see
+   * markState().
+   */
+  std::set<std::string> stateVariables;
   typename MessageRegister::timestamp_t lastVariableImport;
+  
+  /**
+   * Offset of the variable "__dt", the time since the last run.
+   */
+  raw_offset_t dt;
   typedef std::chrono::duration<float, std::ratio<1>> seconds_float;
   
 public:
@@ -130,6 +423,13 @@ public:
    * @param logicId ID of this LogicEngine
    */
   LogicEngine( size_t maxSize, int logicId=0 );
+  
+  /**
+   * Constructor - the compiled logic that was written to the GraphCache by
+   * exportCompiled() before.
+   * Throws a JSON::parseError when the content doesn't fit.
+   */
+  LogicEngine( GraphCache::Reader& in, int logicId=0 );
   LogicEngine( const LogicEngine& ) = delete; // no copy
   LogicEngine( LogicEngine&& );               // but move
   /**
@@ -155,13 +455,16 @@ public:
   
   /**
    * Set state to allow copying of variables.
+   * Only one of the threads that try it at the same time succeeds.
    * @return true when state could be set
    */
   bool enableVariables( void )
   {
-    if( STOPPED == logicState )
+    logicState_t expected = STOPPED;
+    if( logicState.compare_exchange_strong( expected, COPIED ) )
     {
-      logicState = COPIED;
+      if( !variablesFrozen )
+        freezeVariables();
       return true;
     } 
     
@@ -202,6 +505,300 @@ public:
     return false;
   }
   
+  /**
+   * Select the @p newBackend that will be used to run the logic.
+   * NOTE: NATIVE is only possible after a successful loadNative().
+   */
+  void setBackend( backend_t newBackend )
+  {
+    backend = newBackend;
+  }
+  
+  /**
+   * Return the backend that is used to run the logic.
+   */
+  backend_t getBackend( void ) const
+  {
+    return backend;
+  }
+  
+  /**
+   * Run the independent blocks of the main task in parallel on the @p pool
+   * - or one after the other when it is nullptr. This needs the blocks of
+   * Optimizer::dependencies() and the BYTECODE backend. The blocks with
+   * elements that can await run one after the other when there is an
+   * awaitHandler, as the parallel run can't continue behind them.
+   * NOTE: the pool must live as long as it is used by this LogicEngine.
+   */
+  void setTaskPool( TaskPool* pool )
+  {
+    taskPool = pool;
+  }
+  
+  /**
+   * Limit the instructions of a run to @p instructions - or not at all
+   * when it is 0. Only the loops are counted: each taken backward jump
+   * uses up the instructions it jumps over. When the budget is used up the
+   * run is suspended and scheduleRun() returns false, the run is continued
+   * by the next call of it.
+   * NOTE: the NATIVE backend and the parallel run can't be suspended.
+   */
+  void setBudget( long int instructions )
+  {
+    instructionBudget = instructions;
+  }
+  
+  /**
+   * Return the instruction budget of a run, 0 when it's unlimited.
+   */
+  long int getBudget( void ) const
+  {
+    return instructionBudget;
+  }
+  
+  /**
+   * Set the @p newPriority of this logic when it's queued to run, higher
+   * values run first.
+   */
+  void setPriority( int newPriority )
+  {
+    priority = newPriority;
+  }
+  
+  /**
+   * Return the priority of this logic when it's queued to run.
+   */
+  int getPriority( void ) const
+  {
+    return priority;
+  }
+  
+  /**
+   * Let the @p handler queue this logic again when its run used up the
+   * budget: scheduleRun() returns false and calls the @p handler, which has
+   * to continue the run by scheduleRun() later on - e.g. after the logics
+   * of a higher priority.
+   */
+  void setYieldHandler( const yieldHandler_t& handler )
+  {
+    yieldHandler = handler;
+  }
+  
+  /**
+   * Let the @p handler do the waiting of the elements that can await
+   * something (see LogicElement_Generic::canAwait()) instead of blocking the
+   * thread: the run is suspended there and scheduleRun() returns false, then
+   * the @p handler is called. It has to continue the run by scheduleRun()
+   * once the waiting is done - with the instruction behind the element.
+   * NOTE: the NATIVE backend and the parallel run are always waiting in
+   * calc().
+   */
+  void setAwaitHandler( const awaitHandler_t& handler )
+  {
+    awaitHandler = handler;
+    byteCode.clear(); // the elements are compiled differently
+  }
+  
+  /**
+   * Let the sends of this logic queue their messages to the @p box instead
+   * of waiting for the reply - or not when it's nullptr. All messages of a
+   * run are queued together after it.
+   */
+  void setOutbox( Outbox* box )
+  {
+    outbox = box;
+    byteCode.clear(); // the sends can't await anything anymore
+  }
+  
+  /**
+   * Return true when the sends are queued to an outbox.
+   */
+  bool hasOutbox( void ) const
+  {
+    return nullptr != outbox;
+  }
+  
+  /**
+   * Send the @p message after the run - only when hasOutbox().
+   */
+  void post( const LogicMessage::shared_ptr& message )
+  {
+    outgoing.push_back( message );
+  }
+  
+  /**
+   * Mark the registered variable @p name as part of the state of the logic,
+   * i.e. its value is carried from one run to the next, like a state port or
+   * a variable of an implementation. Only the state is saved by a
+   * checkpoint - a parameter or a constant keeps the value of the current
+   * graph.
+   */
+  void markState( const std::string& name )
+  {
+    stateVariables.insert( name );
+  }
+  
+  /**
+   * Save the state variables to the @p target after a finished run, but
+   * only when at least @p period seconds have passed since the last time -
+   * or never when @p target is nullptr.
+   * The @p target has to be created for the stateKey() and stateSize() of
+   * this logic.
+   */
+  void setCheckpoint( Checkpoint* target, float period );
+  
+  /**
+   * Overwrite the state variables with the ones saved in the checkpoint,
+   * e.g. after run_init().
+   * @return false when there's nothing saved for this logic
+   */
+  bool restoreCheckpoint( void );
+  
+  /**
+   * Publish the variables to the @p target after each finished run - or
+   * not when it's nullptr. The @p target has to be created for the
+   * layoutKey(), variablesSize() and snapshotTable() of this logic.
+   */
+  void setSnapshot( Snapshot* target )
+  {
+    snapshot = target;
+  }
+  
+  /**
+   * Run the instances of the @p instances instead of this logic - or this
+   * logic again when it's nullptr. Each instance reads the imports by its
+   * instanceName(), the change tracking, the budget and the rate groups
+   * aren't used then: each run is a full run of all instances. Neither is
+   * the checkpoint nor the snapshot, the variables of this logic are only
+   * the prototype of the instances.
+   * NOTE: the @p instances must be created from this logic and live as
+   * long as they are used.
+   */
+  void setBatch( BatchEngine* instances )
+  {
+    batch = instances;
+  }
+  
+  /**
+   * Return the import @p name of the @p instance, i.e. each "%i" in it is
+   * replaced by the number of the instance.
+   */
+  static std::string instanceName( const std::string& name, size_t instance );
+  
+  /**
+   * Return the values of all named variables in @p values, as they were
+   * after the last finished run - from any thread, without disturbing the
+   * logic.
+   * @return false when there is no snapshot
+   */
+  bool takeSnapshot( std::map<std::string, variable_t>& values ) const;
+  
+  /**
+   * Copy the value of each state variable (see markState()) and import that
+   * has the same name and type in the logic @p other, e.g. to continue with
+   * the state of a graph that was replaced by a newer version.
+   * NOTE: neither logic may run meanwhile.
+   * @return the number of copied variables
+   */
+  size_t adoptVariables( const LogicEngine& other );
+  
+  /**
+   * Subscribe this logic in the registry to the messages of its imports -
+   * of each instance when it's a batch - so that they trigger its run.
+   * Call it once the logic is complete, e.g. after replacing an older
+   * version that was unsubscribed.
+   */
+  void subscribeImports( void );
+  
+  /**
+   * Return a key of the names, types and places of the variables - a
+   * snapshot can only be read with the same key.
+   */
+  uint64_t layoutKey( void ) const;
+  
+  /**
+   * Return the names, places and types of the named variables for a
+   * snapshot.
+   */
+  Snapshot::table_t snapshotTable( void ) const;
+  
+  /**
+   * Return the number of bytes of all variables, e.g. for a snapshot.
+   */
+  size_t variablesSize( void ) const
+  {
+    return variableCount - variableStart();
+  }
+  
+  /**
+   * Return a key of the names and types of the state variables - a
+   * checkpoint can only be restored by a logic with the same key.
+   */
+  uint64_t stateKey( void ) const;
+  
+  /**
+   * Return the number of bytes a checkpoint of the state variables needs.
+   */
+  size_t stateSize( void ) const;
+  
+  /**
+   * Return true when the last run used up its budget or waits for an
+   * element and has to be continued by scheduleRun().
+   */
+  bool isSuspended( void ) const
+  {
+    return nextSegment < segments.size();
+  }
+  
+  /**
+   * Switch the tracing of this LogicEngine on or off.
+   * When tracing each executed element and the scheduling is logged and
+   * checked, this will always use the VIRTUAL backend.
+   * NOTE: this is only possible when tracingAvailable, otherwise everything
+   * is compiled out.
+   */
+  void setTracing( bool enable )
+  {
+    tracing = enable;
+  }
+  
+  /**
+   * Switch the profiling of this LogicEngine on or off, the counters are
+   * cleared when it's switched on.
+   * When profiling the executions and the cycles of each element are
+   * counted, this will always use the VIRTUAL backend. Without it the runs
+   * have no overhead at all.
+   */
+  void setProfiling( bool enable )
+  {
+    profiling = enable;
+    profile.clear();
+  }
+  
+  /**
+   * Return true when this LogicEngine is profiling.
+   */
+  bool isProfiling( void ) const
+  {
+    return profiling;
+  }
+  
+  /**
+   * Return the counters of each element in @p elements and summed up for
+   * the block they belong to in @p perBlock, the elements of the
+   * initialisation are counted for the block "".
+   * NOTE: while the logic is running these are only approximate.
+   */
+  void getProfile( std::vector<profile_t>& elements, std::map<std::string, profile_t>& perBlock ) const;
+  
+  /**
+   * Return true when this LogicEngine is tracing.
+   */
+  bool isTracing( void ) const
+  {
+    return tracingAvailable && tracing;
+  }
+  
   /**
    * Add an element at the end to the instructions of this LogicEngine.
    */
@@ -226,7 +823,54 @@ public:
   }
   
   /**
-   * Register an anonymous variable of size T.
+   * Set the next element as the start of a block of the main task, i.e. the
+   * instructions of the GraphBlock @p name. scheduleRun() runs only the
+   * blocks that are affected by a change, see Optimizer::dependencies().
+   */
+  void markStartOfBlock( const std::string& name = "" )
+  {
+    blockStart.push_back( elementCount );
+    blockNames.push_back( name );
+  }
+  
+  /**
+   * Set the next element as the start of a rate group that runs every
+   * @p period seconds - or only by events when it is 0. Each group gets its
+   * own variable for the time since its last run, see clockName().
+   * NOTE: the first group starts at the main task, it's only getting its
+   * period here.
+   */
+  void markStartOfGroup( float period );
+  
+  /**
+   * Return the number of rate groups.
+   */
+  size_t groupCount( void ) const
+  {
+    return groups.size();
+  }
+  
+  /**
+   * Return the name of the variable that holds the time since the last run
+   * of the rate group @p group.
+   */
+  static std::string clockName( size_t group )
+  {
+    return 0 == group ? "__dt" : "__dt" + std::to_string( group );
+  }
+  
+  /**
+   * The timer of the rate group @p group has fired, it will run at the next
+   * scheduleRun().
+   */
+  void scheduleGroup( size_t group )
+  {
+    dueGroups |= 1ull << group;
+  }
+  
+  /**
+   * Register an anonymous variable of size T, aligned to its natural
+   * alignment like all variables.
    */
   template<typename T>
   raw_offset_t registerVariable();
@@ -272,9 +916,11 @@ public:
   raw_offset_t importVariable( const std::string& name );
   
   /**
-   * Get all bus variables
+   * Get all bus variables for a run of the @p active groups. A new message
+   * is only consumed by them, the status of it stays NEW_MSG till the other
+   * groups that read it have run, too.
    */
-  void copyImportedVariables( MessageRegister::timestamp_t timestamp );
+  void copyImportedVariables( MessageRegister::timestamp_t timestamp, const std::vector<bool>& active );
   
   /**
    * Show all (named) variables
@@ -306,9 +952,18 @@ public:
   }
   
   /**
-   * Do a full run, i.e. including copying of the variables
+   * Do a full run, i.e. including copying of the variables. Only the rate
+   * groups whose timers have fired and the ones without a period are run.
+   * Only the blocks that are affected by a changed variable are run - and
+   * nothing at all when nothing has changed.
+   * When the last run was suspended it's continued instead.
+   * 
+   * @return false when the budget was used up or an element awaits something
+   *         and the run was suspended, the logic stays RUNNING and has to
+   *         be queued again then - or gets continued by the awaitHandler
+   *         or the yieldHandler.
    */
-  void scheduleRun( MessageRegister::timestamp_t timestamp = MessageRegister::now() );
+  bool scheduleRun( MessageRegister::timestamp_t timestamp = MessageRegister::now() );
   
   /**
    * Rerun this script after it was finished - e.g. because it's currently
@@ -385,29 +1040,274 @@ public:
    * Export the logic in a way that could be imported later. This allows storing
    * the logic in a file.
    * The format used is the "native object GrAF" notation (abbreviation: noGrAF)
+   * @param exact write the numbers with all digits, e.g. for a key
    */
-  std::string export_noGrAF( void ) const;
+  std::string export_noGrAF( bool exact = false ) const;
   
   /**
    * Type of the translation map for import_noGrAF().
    */
   typedef std::map<std::string,std::string> translation_t;
+  /**
+   * A noGrAF source that was parsed by parse_noGrAF(), so that it can be
+   * imported many times by only binding its variables, e.g. the
+   * implementation of a block of the library for each of its instances.
+   */
+  struct program_t
+  {
+    /**
+     * How a parameter gets its value during the import.
+     */
+    enum kind_t {
+      LITERAL, ///< the text as it is
+      STRING,  ///< the translation of the text, else the text
+      OFFSET,  ///< the offset of the variable named by symbols[symbol]
+      ADDRESS  ///< the offset that was given as number
+    };
+    struct operand_t
+    {
+      kind_t kind;
+      std::string text;
+      raw_offset_t offset; ///< the value of an ADDRESS
+      size_t symbol;       ///< the index in symbols of an OFFSET
+    };
+    /**
+     * An instruction or - when create is nullptr - a variable definition
+     * with the name as only operand.
+     */
+    struct statement_t
+    {
+      LogicElement_Generic::FactoryType create;
+      variableType::type type; ///< the type of the defined variable
+      std::vector<operand_t> operands;
+    };
+    std::vector<statement_t> statements;
+    std::vector<std::string> symbols; ///< the variable names used by OFFSET operands, each only once
+    size_t instructions; ///< the number of instructions, see instructionsCount()
+    
+    program_t() : instructions( 0 ) {}
+  };
+  
+  /**
+   * Parse the noGrAF source @p in, throws a JSON::parseError on errors.
+   */
+  static program_t parse_noGrAF( std::istream& in );
+  
+  /**
+   * Parse the noGrAF source @p src, throws a JSON::parseError on errors.
+   */
+  static program_t parse_noGrAF( const std::string& src )
+  {
+    std::stringstream in( src );
+    return parse_noGrAF( in );
+  }
+  
   /**
    * Import the logic that was exported earlier.
    * The format used is the "native object GrAF" notation (abbreviation: noGrAF)
    */
   void import_noGrAF( std::istream& in, bool symbolicVariables = false, std::string prefix = "", const translation_t& translation = *static_cast<translation_t*>(nullptr) );
   
+  /**
+   * Import the parsed @p program, the names of its variables get the
+   * @p prefix and are looked up in the @p translation first.
+   */
+  void import_noGrAF( const program_t& program, bool symbolicVariables, const std::string& prefix, const translation_t& translation );
+  
+  /**
+   * Export the compiled logic to the GraphCache: the elements with their
+   * resolved parameters, the variables with their initial values and the
+   * registry, the rate groups and the blocks.
+   * NOTE: only before the logic was initialised, i.e. before run_init().
+   * @return false when an element can't be exported
+   */
+  bool exportCompiled( GraphCache::Writer& out ) const;
+  
   /**
    * Count the amount of instructions in the passed string.
    */
   static size_t instructionsCount( const std::string& src );
+  
+  /**
+   * Return the key that identifies the logic for the NATIVE backend.
+   */
+  std::string nativeKey( void ) const
+  {
+    return NativeCode::key( export_noGrAF( true ) );
+  }
+  
+  /**
+   * Export the logic as C++ translation unit for the NATIVE backend.
+   */
+  void exportNative( std::ostream& out ) const;
+  
+  /**
+   * Load the shared object of the logic from the directory @p path and
+   * use the NATIVE backend.
+   * @return true on success, false when there is no matching shared object
+   *         and the backend wasn't changed.
+   */
+  bool loadNative( const std::string& path );
+  
+  /**
+   * Move the variables to their final place in the VariableArena. Afterwards
+   * no more variables can be registered.
+   * NOTE: this is done by the first enableVariables().
+   */
+  void freezeVariables( void );
+  
+  /**
+   * Return the number of bytes used by the variables of this LogicEngine.
+   */
+  size_t variableMemory( void ) const;
+  
+  /**
+   * Return the number of bytes used by the elements of this LogicEngine.
+   */
+  size_t elementMemory( void ) const
+  {
+    return elementArena.size();
+  }
+  
+private:
+  /**
+   * Make sure globVar[] can hold variableCount bytes.
+   */
+  void growVariables( void );
+  
+  /**
+   * Round the variableCount up to the natural alignment of the type @p T.
+   * @return the aligned variableCount
+   */
+  template<typename T>
+  raw_offset_t alignVariable( void )
+  {
+    return variableCount = ( variableCount + alignof( T ) - 1 ) & ~( alignof( T ) - 1 );
+  }
+  
+  /**
+   * Run the logic, starting at @p start till @p elEnd, as long as the
+   * @p budget lasts.
+   * @return false when the budget was used up
+   */
+  bool run( const instructionPointer start, const instructionPointer elEnd, long int& budget ) const;
+  
+  /**
+   * Run the logic, starting at @p start till @p elEnd - with or without
+   * @p trace of each step and the @p profile of each element - as long as
+   * the @p budget lasts.
+   * @return false when the budget was used up
+   */
+  template<bool trace, bool profile>
+  bool execute( const instructionPointer start, const instructionPointer elEnd, long int& budget ) const;
+  
+  /**
+   * Mark the blocks in @p readers to run at the next run.
+   */
+  void markChanged( const std::vector<size_t>& readers )
+  {
+    if( blocks.empty() )
+      return;
+    for( auto block = readers.cbegin(); block != readers.cend(); ++block )
+      pending[ *block ] = true;
+  }
+  
+  /**
+   * Return the index of the first element of the rate group @p group.
+   */
+  size_t groupStart( size_t group ) const
+  {
+    return 0 == group ? mainTask - elementList : groups[ group ].start;
+  }
+  
+  /**
+   * Return the index behind the last element of the rate group @p group.
+   */
+  size_t groupEnd( size_t group ) const
+  {
+    return group + 1 < groups.size() ? groups[ group + 1 ].start : elementCount;
+  }
+  
+  /**
+   * Run the pending blocks of the @p active rate groups and all blocks that
+   * depend on them - or add them to the segments when they can be
+   * suspended.
+   */
+  void runChanged( const std::vector<bool>& active );
+  
+  /**
+   * Do a full run of all instances of the batch with their own imports.
+   */
+  void runInstances( MessageRegister::timestamp_t timestamp );
+  
+  /**
+   * Run the segments, starting at nextSegment, with the budget.
+   * @return false when the budget was used up or an element awaits
+   *         something, see awaitPending
+   */
+  bool runSegments( void );
+  
+  /**
+   * Return the registry entries of the state variables, by their name.
+   */
+  std::vector<const variableRegistryStorage*> stateEntries( void ) const;
+  
+  /**
+   * Return the values of the state variables one after another.
+   */
+  std::vector<raw_t> captureState( void ) const;
+  
+  /**
+   * Let the checkpoint save the variables when the period has passed since
+   * @p timestamp.
+   */
+  void saveCheckpoint( MessageRegister::timestamp_t timestamp )
+  {
+    if( nullptr == checkpoint || timestamp - lastCheckpoint < checkpointPeriod )
+      return;
+    checkpoint->capture( captureState().data() );
+    lastCheckpoint = timestamp;
+  }
+  
+  /**
+   * Queue the messages of the run to the outbox.
+   */
+  void flushOutgoing( void )
+  {
+    if( outgoing.empty() )
+      return;
+    outbox->push( std::move( outgoing ) );
+    outgoing.clear();
+  }
+  
+  /**
+   * Run the @p dirty blocks on the taskPool and return after all are
+   * finished.
+   */
+  void runParallel( const std::vector<bool>& dirty );
+  
+  /**
+   * Return true when one of the @p dirty blocks has an element that would
+   * be continued by the awaitHandler, which only the sequential run can do.
+   */
+  bool awaitsIn( const std::vector<bool>& dirty ) const
+  {
+    if( !awaitHandler )
+      return false;
+    for( size_t b = 0; b < blocks.size(); ++b )
+      if( dirty[b] && blocks[b].awaits )
+        return true;
+    return false;
+  }
 };
 
 template<typename T>
 raw_offset_t LogicEngine::registerVariable()
 {
-  return variableCount += sizeof( T );
+  register raw_offset_t thisVariable = alignVariable<T>();
+  variableCount += sizeof( T );
+  growVariables();
+  return thisVariable;
 }
 
 template<typename T>
@@ -421,9 +1321,10 @@ raw_offset_t LogicEngine::registerVariable( const T& value )
 template<typename T>
 raw_offset_t LogicEngine::registerVariable( const std::string& name )
 {
-  register raw_offset_t thisVariable = variableCount;
+  register raw_offset_t thisVariable = alignVariable<T>();
   variableRegistry[ name ] = { thisVariable, variableType::getType<T>(), &LogicEngine::readString<T> };
   variableCount += sizeof( T );
+  growVariables();
   return thisVariable;
 }
 
@@ -443,10 +1344,13 @@ raw_offset_t LogicEngine::importVariable( const std::string& name )
     // already imported
     return variableRegistry[ name ].offset;
   }
+  // the status has to follow directly, see copyImportedVariables()
+  const size_t statusAlign = alignof( int ) - 1;
+  variableCount = ( ( variableCount + sizeof( T ) + statusAlign ) & ~statusAlign ) - sizeof( T );
   raw_offset_t pos = registerVariable<T>( name );
   registerVariable<int>( name + "_status" );
   importRegistry[ name ] = variableRegistry[ name ];
-  //TODO update and reenable: registry.subscribe( name, variableType::getType<T>(), thisLogicId );
+  // subscribed by subscribeImports() when the logic is complete
   return pos;
 }
 
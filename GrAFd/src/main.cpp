@@ -37,6 +37,10 @@
 #include "logic_elements.hpp"
 #include "json.hpp"
 #include "asyncsocket.hpp"
+#include "awaiter.hpp"
+#include "runqueue.hpp"
+#include "outbox.hpp"
+#include "graphreloader.hpp"
 #include "editorhandler.hpp"
 #include "worker.hpp"
 
@@ -47,6 +51,9 @@ MessageRegister registry;
 zmq::socket_t *sender;
 graphs_t graphs;
 Worker* worker;
+Awaiter* awaiter;
+RunQueue* runQueue;
+Outbox* outbox;
 
 void showHelp( void )
 {
@@ -56,14 +63,30 @@ void showHelp( void )
   "\n"
   "Parameters:\n"
   "    -h, --help           This help message\n"
-  "    -v, --vebose         Verbose output - repeatable" << endl;
+  "    -v, --vebose         Verbose output - repeatable\n"
+  "    --native=DIR         Use the logic compiled by graf2cpp in DIR\n"
+  "    --checkpoint=DIR     Save the state of the graphs in DIR and restore it\n"
+  "                         at the start\n"
+  "    --cache=DIR          Keep the compiled logic of the graphs in DIR and use\n"
+  "                         it while the graph and the libraries are unchanged,\n"
+  "                         as well as the index of the libraries\n"
+  "    --no-outbox          Send each message of a graph on its own and suspend\n"
+  "                         the graph till the reply, instead of queuing the\n"
+  "                         messages of a run to be sent as one request\n"
+  "    --shm                Export the variables of each graph as shared memory\n"
+  "                         /GrAFd.<graph name>\n"
+  "    --watch=DIR          Load the graph <name> from each file DIR/<name>.graf\n"
+  "                         and replace it each time the file is changed, the\n"
+  "                         graphs are compiled in parallel" << endl;
 }
 
 int main( int argc, const char *argv[] )
 {
   string logicNamespace = "logic";
+  string watchPath;
   size_t poolSize = 5;
   int verbose = 0;
+  bool useOutbox = true;
   while( argc-- > 1 )
   {
     string parameter( argv[ argc ] );
@@ -77,6 +100,30 @@ int main( int argc, const char *argv[] )
     {
       verbose++;
     } 
+    else if( parameter.substr( 0, 9 ) == "--native=" )
+    {
+      Graph::nativePath = parameter.substr( 9 );
+    }
+    else if( parameter.substr( 0, 8 ) == "--watch=" )
+    {
+      watchPath = parameter.substr( 8 );
+    }
+    else if( parameter == "--no-outbox" )
+    {
+      useOutbox = false;
+    }
+    else if( parameter == "--shm" )
+    {
+      Graph::exportSnapshots = true;
+    }
+    else if( parameter.substr( 0, 13 ) == "--checkpoint=" )
+    {
+      Graph::checkpointPath = parameter.substr( 13 );
+    }
+    else if( parameter.substr( 0, 8 ) == "--cache=" )
+    {
+      Graph::cachePath = parameter.substr( 8 );
+    }
   }
   logger.setLogLevel( static_cast<Logger::logLevels>( verbose ) );
   
@@ -90,10 +137,14 @@ int main( int argc, const char *argv[] )
   subscriber.setsockopt( ZMQ_SUBSCRIBE, "", 0 ); // get all messages
   sender = new zmq::socket_t( context, ZMQ_REQ );
   sender->connect( "ipc:///tmp/logicd.ipc" );
+  // without the outbox the sends await their replies by the awaiter
+  outbox = useOutbox ? new Outbox( context, "ipc:///tmp/logicd.ipc" ) : nullptr;
   
   // Setup the thread pool
   assert_main_thread( true ); // initalize assert
   worker = new Worker( poolSize );
+  awaiter = new Awaiter( io_service, context, "ipc:///tmp/logicd.ipc", []( LogicEngine* le ){ worker->enque_task( le ); } );
+  runQueue = new RunQueue( io_service, []( LogicEngine* le ){ worker->enque_task( le ); } );
   
   ///////////////////////////////////////////////////////////////////////////
   //
@@ -101,43 +152,13 @@ int main( int argc, const char *argv[] )
   //
   //###################################
 
-  Graph::lib.addPath( "../lib/" );
-  ifstream test1( "../test/test1.graf" );
-  ifstream test2( "../test/test2.graf" );
-  try {
-    logger << "---------------------------------------\n";
-    logger << "test1:" << endl; logger.show();
-    //scriptPool.push_back( LogicEngine_ptr( new LogicEngine( 200, scriptPool.size() ) ) );
-    //auto leG1 = scriptPool.back();
-    //graphs.insert( make_pair( "G1", Graph( *leG1, test1 ) ) );
-    //graphs.insert( make_pair( "G1", move( Graph( test1 ) ) ) ); 
-    graphs.insert( make_pair( "G1", Graph( test1 ) ) ); 
-    //graphs["G1"] = move( Graph( test1 ) );
-    //graphs.insert( { string("G1"), Graph( test1 ) } ); 
-    //graphs.emplace( make_pair( "G1", Graph( test1 ) ) ); 
-    graphs.at("G1").dump();
-    graphs.at("G1").init( io_service );
-    logger << "---------------------------------------\n";
-    logger << "test2:" << endl; logger.show();
-    //scriptPool.push_back( LogicEngine_ptr( new LogicEngine( 200, scriptPool.size() ) ) );
-    //auto leG2 = scriptPool.back();
-    //graphs.insert( make_pair( "G2", Graph( *leG2, test2 ) ) ); 
-    graphs.insert( make_pair( "G2", Graph( test2 ) ) );
-    graphs.at("G2").dump();
-    graphs.at("G2").init( io_service );
-  }
-  catch( JSON::parseError e )
-  {
-    int lineNo, errorPos;
-    string wrongLine = e.getErrorLine( lineNo, errorPos ) ;
-    logger << "!!! caugt error \"" << e.text << "\" in line " << lineNo << " at postion " << errorPos << " (" << e.sourceFile << ":" << e.sourceLineNo << "):\n";
-    logger << "!!! " << wrongLine << "\n";
-    logger << "!!!";
-    while( 1 < errorPos-- )
-      logger << " ";
-    logger << "-^-" << endl;
-    logger.show();
-  }
+  Graph::lib.addPath( "../lib/", Graph::cachePath );
+  
+  // load the graphs - compiled in parallel by the threads of the reloader
+  // that replaces them by their changed files while running, too
+  GraphReloader* reloader = new GraphReloader( io_service, watchPath );
+  reloader->load( "G1", "../test/test1.graf" );
+  reloader->load( "G2", "../test/test2.graf" );
   logger << "fin ---------------------------------------\n";logger.show();
  //###################################
   int subscriber_fd;
@@ -213,7 +234,11 @@ int main( int argc, const char *argv[] )
   //
   
   // stop all threads and join them:
+  delete reloader;
   delete worker; // the destructor does all of that for us
+  delete awaiter;
+  delete runQueue;
+  delete outbox;
   
   delete sender;
 
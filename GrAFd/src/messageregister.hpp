@@ -100,11 +100,32 @@ public:
   }
   
   /**
-   * Stores a logic ID that will be called once the address arrives
+   * Stores a logic ID that will be called once the address arrives - only
+   * once, when it's already subscribed nothing is done.
    */
   void subscribe( const std::string& dst, const variableType::type type, const subscribers_t::value_type& logic_ID )
   {
-    look_for( dst, type )->second.subscribers.push_back( logic_ID );
+    subscribers_t& subscribers = look_for( dst, type )->second.subscribers;
+    for( auto s = subscribers.cbegin(); s != subscribers.cend(); ++s )
+      if( logic_ID.first == s->first )
+        return;
+    subscribers.push_back( logic_ID );
+  }
+  
+  /**
+   * Remove all subscriptions of the logic @p logic, e.g. when a graph is
+   * replaced by a newer version that subscribes its own imports.
+   */
+  void unsubscribe( const class LogicEngine* logic )
+  {
+    for( auto it = registry.begin(); it != registry.end(); ++it )
+    {
+      subscribers_t subscribers;
+      for( auto s = it->second.subscribers.cbegin(); s != it->second.subscribers.cend(); ++s )
+        if( logic != s->first )
+          subscribers.push_back( *s );
+      it->second.subscribers.swap( subscribers );
+    }
   }
   
   /**
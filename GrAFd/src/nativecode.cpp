@@ -0,0 +1,331 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nativecode.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#include <dlfcn.h>
+
+#include "logger.hpp"
+#include "json.hpp"
+#include "logic_elements/logicelement_generic.hpp"
+
+/**
+ * Version of the generated code, part of the key so that old shared objects
+ * won't be used after the code generation has changed.
+ */
+static const char *const nativeVersion = "1";
+
+NativeCode::NativeCode( NativeCode&& other )
+: handle( other.handle ), function( other.function )
+{
+  other.handle   = nullptr;
+  other.function = nullptr;
+}
+
+NativeCode::~NativeCode()
+{
+  if( nullptr != handle )
+    dlclose( handle );
+}
+
+std::string NativeCode::key( const std::string& noGrAF )
+{
+  // 64 bit FNV-1a - it must be stable between the builds, so std::hash is
+  // no option
+  uint64_t hash = 14695981039346656037ULL;
+  const std::string source = std::string( nativeVersion ) + "\n" + noGrAF;
+  for( auto c = source.cbegin(); c != source.cend(); ++c )
+  {
+    hash ^= static_cast<unsigned char>( *c );
+    hash *= 1099511628211ULL;
+  }
+  
+  std::stringstream out;
+  out << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+  return out.str();
+}
+
+/**
+ * The C++ types of the variables in the opcodes.
+ */
+static const char *const typeName[] = { "bool", "int", "float" };
+
+/**
+ * The C++ operators of the relations in the opcodes.
+ */
+static const char *const relationName[] = { "==", "!=", "<", "<=", ">", ">=" };
+
+/**
+ * Write the access to the variable of @p type at the @p operand to @p out.
+ */
+static std::ostream& var( std::ostream& out, const char* type, const ByteCode::operand_t& operand )
+{
+  return out << "V( " << type << ", " << operand.offset << " )";
+}
+
+void NativeCode::generate( const ByteCode& code, size_t mainTask, 
+                           const std::string& key, std::ostream& out )
+{
+  const size_t count = code.size();
+  
+  out << "// Generated by graf2cpp - do not edit!\n"
+         "#include <cstddef>\n"
+         "#include <cstdint>\n"
+         "#include <cstring>\n"
+         "\n"
+         "#define V( T, offset ) (*reinterpret_cast<T*>( base + (offset) ))\n"
+         "#define EXIT( index ) do { *reinterpret_cast<void *const **>( base ) = elements + (index); return; } while( 0 )\n"
+         "\n"
+         "static inline float F( uint32_t bits )\n"
+         "{\n"
+         "  float value;\n"
+         "  std::memcpy( &value, &bits, sizeof( value ) );\n"
+         "  return value;\n"
+         "}\n"
+         "\n"
+         "extern \"C\" const char grafd_key[] = \"" << key << "\";\n"
+         "\n"
+         "extern \"C\" void grafd_run( unsigned char *const base, size_t index, const size_t end,\n"
+         "                           void *const * elements, size_t (*const call)( void *const *, size_t, unsigned char *const ) )\n"
+         "{\n";
+  // the dispatch is only needed again after a CALL
+  for( size_t i = 0; i < count; ++i )
+    if( ByteCode::CALL == code[i].op )
+    {
+      out << "dispatch:\n";
+      break;
+    }
+  out << "  switch( index )\n"
+         "  {\n";
+  for( size_t i = 0; i <= count; ++i )
+    out << "    case " << i << ": goto L" << i << ";\n";
+  out << "    default: EXIT( index );\n"
+         "  }\n"
+         "\n";
+  
+  for( size_t i = 0; i < count; ++i )
+  {
+    const ByteCode::instruction_t& instruction = code[i];
+    const ByteCode::opcode_t opcode = instruction.op;
+    const long int target = static_cast<long int>( i ) + instruction.a.jump;
+    auto jumpTarget = [&]() -> long int {
+      if( target < 0 || static_cast<long int>( count ) < target )
+        throw( JSON::parseError( "Jump target out of range at instruction " + std::to_string( i ), __LINE__ ,__FILE__ ) );
+      return target;
+    };
+    
+    out << "L" << i << ":";
+    if( mainTask == i )
+      out << " if( " << i << " == end ) EXIT( " << i << " );";
+    out << " // " << ByteCode::opcodeName[ opcode ] << "\n  ";
+    
+    switch( instruction.op )
+    {
+      case ByteCode::CALL:
+      case ByteCode::AWAIT:
+        out << "index = call( elements, " << i << ", base ); "
+               "if( SIZE_MAX == index ) return; "
+               "if( " << i + 1 << " != index ) goto dispatch;";
+        break;
+        
+      case ByteCode::STOP:
+        out << "*reinterpret_cast<size_t*>( base ) = SIZE_MAX; return;";
+        break;
+        
+      case ByteCode::JUMP:
+        out << "goto L" << jumpTarget() << ";";
+        break;
+        
+      case ByteCode::JUMPTRUE_BOOL:
+      case ByteCode::JUMPTRUE_INT:
+      case ByteCode::JUMPZERO_BOOL:
+      case ByteCode::JUMPZERO_INT:
+        var( out << "if( ", typeName[ (opcode - ByteCode::JUMPTRUE_BOOL) % 2 ], instruction.b )
+          << ( opcode < ByteCode::JUMPZERO_BOOL ? " > 0" : " == 0" )
+          << " ) goto L" << jumpTarget() << ";";
+        break;
+        
+      case ByteCode::JUMPEQUAL_INT:
+      case ByteCode::JUMPEQUAL_FLOAT:
+      case ByteCode::JUMPNOTEQUAL_INT:
+      case ByteCode::JUMPNOTEQUAL_FLOAT:
+        {
+          const char* type = typeName[ 1 + (opcode - ByteCode::JUMPEQUAL_INT) % 2 ];
+          var( var( out << "if( ", type, instruction.b )
+            << ( opcode < ByteCode::JUMPNOTEQUAL_INT ? " == " : " != " ), type, instruction.c )
+            << " ) goto L" << jumpTarget() << ";";
+        }
+        break;
+        
+      case ByteCode::CONST_BOOL:
+      case ByteCode::CONST_INT:
+        var( out, typeName[ opcode - ByteCode::CONST_BOOL ], instruction.a ) << " = " << instruction.b.i << ";";
+        break;
+        
+      case ByteCode::CONST_FLOAT:
+        {
+          uint32_t bits;
+          std::memcpy( &bits, &instruction.b.f, sizeof( bits ) );
+          var( out, "float", instruction.a ) << " = F( 0x" << std::hex << bits << std::dec 
+            << "u ); // " << instruction.b.f;
+        }
+        break;
+        
+      case ByteCode::MOVE_BOOL:
+      case ByteCode::MOVE_INT:
+      case ByteCode::MOVE_FLOAT:
+        {
+          const char* type = typeName[ opcode - ByteCode::MOVE_BOOL ];
+          var( var( out, type, instruction.a ) << " = ", type, instruction.b ) << ";";
+        }
+        break;
+        
+      case ByteCode::SUM_INT:
+      case ByteCode::SUM_FLOAT:
+      case ByteCode::MUL_INT:
+      case ByteCode::MUL_FLOAT:
+        {
+          const char* type = typeName[ 1 + (opcode - ByteCode::SUM_INT) % 2 ];
+          var( var( var( out, type, instruction.a ) << " = ", type, instruction.b )
+            << ( opcode < ByteCode::MUL_INT ? " + " : " * " ), type, instruction.c ) << ";";
+        }
+        break;
+        
+      case ByteCode::MULADD_INT:
+      case ByteCode::MULADD_FLOAT:
+      case ByteCode::MULSUB_INT:
+      case ByteCode::MULSUB_FLOAT:
+        {
+          const char* type = typeName[ 1 + (opcode - ByteCode::MULADD_INT) % 2 ];
+          var( var( var( out, type, instruction.a ) 
+            << ( opcode < ByteCode::MULSUB_INT ? " += " : " -= " ), type, instruction.b )
+            << " * ", type, instruction.c ) << ";";
+        }
+        break;
+        
+      case ByteCode::SUMCONST_INT:
+      case ByteCode::MULCONST_INT:
+        var( var( out, "int", instruction.a ) << " = ", "int", instruction.b )
+          << ( opcode < ByteCode::MULCONST_INT ? " + " : " * " ) << instruction.c.i << ";";
+        break;
+        
+      case ByteCode::SUMCONST_FLOAT:
+      case ByteCode::MULCONST_FLOAT:
+        {
+          uint32_t bits;
+          std::memcpy( &bits, &instruction.c.f, sizeof( bits ) );
+          var( var( out, "float", instruction.a ) << " = ", "float", instruction.b )
+            << ( opcode < ByteCode::MULCONST_INT ? " + " : " * " ) << "F( 0x" << std::hex << bits << std::dec 
+            << "u ); // " << instruction.c.f;
+        }
+        break;
+        
+      case ByteCode::MOVE2_BOOL:
+      case ByteCode::MOVE2_INT:
+      case ByteCode::MOVE2_FLOAT:
+        {
+          const char* type = typeName[ opcode - ByteCode::MOVE2_BOOL ];
+          var( var( out, type, instruction.a ) << " = ", type, instruction.b ) << "; ";
+          var( var( out, type, instruction.c ) << " = ", type, instruction.d ) << ";";
+        }
+        break;
+        
+      case ByteCode::MULSUM_INT:
+      case ByteCode::MULSUM_FLOAT:
+        {
+          const char* type = typeName[ 1 + opcode - ByteCode::MULSUM_INT ];
+          var( var( var( out, type, instruction.e ) << " = ", type, instruction.b ) << " * ", type, instruction.c ) << "; ";
+          var( var( var( out, type, instruction.a ) << " = ", type, instruction.e ) << " + ", type, instruction.d ) << ";";
+        }
+        break;
+        
+      default:
+        if( ByteCode::REL_EQUAL_BOOL_INT <= opcode && opcode <= ByteCode::REL_GREATEREQUAL_INT_FLOAT )
+        {
+          // the layout of the opcodes is described at ByteCode::opcode_t
+          const int relation = opcode - ByteCode::REL_EQUAL_BOOL_INT;
+          const char* typeIn = typeName[ 1 + (relation & 1) ];
+          var( var( var( out, typeName[ (relation & 2) / 2 ], instruction.a ) << " = ", typeIn, instruction.b )
+            << " " << relationName[ relation / 4 ] << " ", typeIn, instruction.c ) << ";";
+          break;
+        }
+        if( ByteCode::RELJUMP_EQUAL_BOOL_INT <= opcode && opcode <= ByteCode::RELJUMP_GREATEREQUAL_INT_FLOAT )
+        {
+          const int relation = opcode - ByteCode::RELJUMP_EQUAL_BOOL_INT;
+          const char* typeIn = typeName[ 1 + (relation & 1) ];
+          var( var( var( out << "if( ( ", typeName[ (relation & 2) / 2 ], instruction.d ) << " = ", typeIn, instruction.b )
+            << " " << relationName[ relation / 4 ] << " ", typeIn, instruction.c ) 
+            << " ) > 0 ) goto L" << jumpTarget() << ";";
+          break;
+        }
+        throw( JSON::parseError( std::string( "Opcode " ) + ByteCode::opcodeName[ opcode ] + " not supported!", __LINE__ ,__FILE__ ) );
+    }
+    out << "\n";
+  }
+  
+  out << "L" << count << ":\n"
+         "  EXIT( " << count << " );\n"
+         "}\n";
+}
+
+bool NativeCode::load( const std::string& path, const std::string& key )
+{
+  const std::string file = path + "/" + fileName( key ) + ".so";
+  
+  void* newHandle = dlopen( file.c_str(), RTLD_NOW | RTLD_LOCAL );
+  if( nullptr == newHandle )
+    return false;
+  
+  const char* objectKey = static_cast<const char*>( dlsym( newHandle, "grafd_key" ) );
+  void* runSymbol = dlsym( newHandle, "grafd_run" );
+  if( nullptr == objectKey || key != objectKey || nullptr == runSymbol )
+  {
+    logger( Logger::WARN ) << "NativeCode: '" << file << "' doesn't match the logic, ignoring it\n"; logger.show();
+    dlclose( newHandle );
+    return false;
+  }
+  
+  if( nullptr != handle )
+    dlclose( handle );
+  handle = newHandle;
+  // POSIX guarantees that a function pointer can be stored in a void*
+  std::memcpy( &function, &runSymbol, sizeof( function ) );
+  
+  return true;
+}
+
+size_t NativeCode::call( void *const * elements, size_t index, raw_t *const base )
+{
+  typedef LogicElement_Generic::iterator iterator;
+  LogicElement_Generic *const * const list = reinterpret_cast<LogicElement_Generic *const *>( elements );
+  
+  iterator& ip = reinterpret_cast<iterator*>( base )[0];
+  ip = const_cast<iterator>( list + index );
+  list[ index ]->calc( base );
+  
+  if( reinterpret_cast<iterator>( SIZE_MAX ) == ip )
+    return SIZE_MAX;
+  
+  return ip - list;
+}
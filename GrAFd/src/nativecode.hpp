@@ -0,0 +1,133 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NATIVECODE_HPP
+#define NATIVECODE_HPP
+
+#include <string>
+#include <iosfwd>
+
+#include "globals.h"
+#include "bytecode.hpp"
+
+class LogicElement_Generic;
+
+/**
+ * The NativeCode is the ahead of time compiled backend of the LogicEngine.
+ * 
+ * The ByteCode of a logic is exported as a C++ translation unit (see the
+ * tool graf2cpp) where each instruction is a typed statement on the
+ * variable store. Compiled as a shared object it is loaded again by the
+ * NativeCode. The shared object is identified by a key, a hash of the
+ * exported logic, so that it's only used for exactly the same graph compiled
+ * with exactly the same library.
+ * Elements that have no own opcode are executed through a call of their
+ * virtual LogicElement_Generic::calc().
+ */
+class NativeCode
+{
+public:
+  /**
+   * Type of the callback to run the element at @p index in @p elements,
+   * returning the index of the next element or SIZE_MAX to stop.
+   */
+  typedef size_t (*call_t)( void *const * elements, size_t index, raw_t *const base );
+  
+  /**
+   * Type of the exported function of the shared object.
+   */
+  typedef void (*run_t)( raw_t *const base, size_t start, const size_t end, 
+                         void *const * elements, const call_t call );
+  
+  /**
+   * Constructor.
+   */
+  NativeCode() : handle( nullptr ), function( nullptr )
+  {}
+  NativeCode( const NativeCode& ) = delete; // no copy
+  NativeCode( NativeCode&& other );         // but move
+  
+  /**
+   * Destructor - unloads the shared object.
+   */
+  ~NativeCode();
+  
+  /**
+   * Return the key of the logic that was exported as @p noGrAF.
+   */
+  static std::string key( const std::string& noGrAF );
+  
+  /**
+   * Return the base of the file name for the logic with @p key.
+   */
+  static std::string fileName( const std::string& key )
+  {
+    return "grafd_" + key;
+  }
+  
+  /**
+   * Write the C++ translation unit of @p code with the main task starting at
+   * index @p mainTask to @p out, identified by @p key.
+   */
+  static void generate( const ByteCode& code, size_t mainTask, 
+                        const std::string& key, std::ostream& out );
+  
+  /**
+   * Load the shared object for the logic with @p key from the directory
+   * @p path.
+   * @return true on success, false when it doesn't exist or doesn't match.
+   */
+  bool load( const std::string& path, const std::string& key );
+  
+  /**
+   * Is a shared object loaded?
+   */
+  bool isLoaded( void ) const
+  {
+    return nullptr != function;
+  }
+  
+  /**
+   * Run from the instruction at index @p start till @p end (which has to be
+   * the start of the main task or the end) on the variables at @p base.
+   * The instruction pointer at @p base is updated on exit like the
+   * LogicEngine does for the virtual calls.
+   */
+  void run( raw_t *const base, size_t start, size_t end, LogicElement_Generic** elements ) const
+  {
+    function( base, start, end, reinterpret_cast<void *const *>( elements ), &call );
+  }
+  
+private:
+  /**
+   * The handle of the shared object.
+   */
+  void* handle;
+  
+  /**
+   * The exported function of the shared object.
+   */
+  run_t function;
+  
+  /**
+   * The call_t passed to the shared object.
+   */
+  static size_t call( void *const * elements, size_t index, raw_t *const base );
+};
+
+#endif // NATIVECODE_HPP
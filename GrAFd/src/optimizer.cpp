@@ -0,0 +1,1313 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "optimizer.hpp"
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <algorithm>
+
+#include "globals.h"
+
+#include "logger.hpp"
+#include "logicengine.hpp"
+#include "logic_elements.hpp"
+#include "utilities.hpp"
+
+/**
+ * Create the LogicElement_RelJumpTrue for the relation @p rel of @p type
+ * followed by @p jump.
+ */
+template<typename Tout, typename Tin>
+static LogicElement_Generic* relJumpTrue( LogicElement_Generic::ownerPtr_t owner, const ByteCode::instruction_t& rel, 
+                                          const ByteCode::instruction_t& jump,
+                                          int type )
+{
+  return new( owner ) LogicElement_RelJumpTrue<Tout, Tin>( jump.a.jump, rel.a.offset, rel.b.offset, rel.c.offset,
+                                                  static_cast<typename LogicElement_Rel<Tout, Tin>::relType>( type ) );
+}
+
+/**
+ * Create the LogicElement_Rel for the REL @p instruction of @p type.
+ */
+template<typename Tout, typename Tin>
+static LogicElement_Generic* rel( LogicElement_Generic::ownerPtr_t owner, const ByteCode::instruction_t& instruction, int type )
+{
+  return new( owner ) LogicElement_Rel<Tout, Tin>( instruction.a.offset, instruction.b.offset, instruction.c.offset,
+                                          static_cast<typename LogicElement_Rel<Tout, Tin>::relType>( type ) );
+}
+
+/**
+ * Create the LogicElement_RelJumpTrue for the RELJUMP @p instruction of
+ * @p type.
+ */
+template<typename Tout, typename Tin>
+static LogicElement_Generic* relJump( LogicElement_Generic::ownerPtr_t owner, const ByteCode::instruction_t& instruction, int type )
+{
+  return new( owner ) LogicElement_RelJumpTrue<Tout, Tin>( instruction.a.jump, instruction.d.offset, instruction.b.offset, instruction.c.offset,
+                                                  static_cast<typename LogicElement_Rel<Tout, Tin>::relType>( type ) );
+}
+
+/**
+ * Create the LogicElement_MulSum for @p mul followed by @p sum, when the
+ * sum is using the result of the multiplication.
+ */
+template<typename T>
+static LogicElement_Generic* mulSum( LogicElement_Generic::ownerPtr_t owner, const ByteCode::instruction_t& mul,
+                                     const ByteCode::instruction_t& sum )
+{
+  if( sum.b.offset == mul.a.offset )
+    return new( owner ) LogicElement_MulSum<T>( sum.a.offset, mul.a.offset, mul.b.offset, mul.c.offset, sum.c.offset );
+  
+  if( sum.c.offset == mul.a.offset )
+    return new( owner ) LogicElement_MulSum<T>( sum.a.offset, mul.a.offset, mul.b.offset, mul.c.offset, sum.b.offset );
+  
+  return nullptr;
+}
+
+/**
+ * Create the LogicElement_Move2 for @p move1 followed by @p move2.
+ */
+template<typename T>
+static LogicElement_Generic* move2( LogicElement_Generic::ownerPtr_t owner, const ByteCode::instruction_t& move1,
+                                    const ByteCode::instruction_t& move2 )
+{
+  return new( owner ) LogicElement_Move2<T>( move1.a.offset, move1.b.offset, move2.a.offset, move2.b.offset );
+}
+
+/**
+ * Create the LogicElement_Move that copies the result @p in of an expression
+ * with the opcode @p op to @p out.
+ */
+static LogicElement_Generic* moveResult( LogicElement_Generic::ownerPtr_t owner, const ByteCode::opcode_t op, 
+                                         const raw_offset_t out, const raw_offset_t in )
+{
+  switch( op )
+  {
+    case ByteCode::SUM_INT:
+    case ByteCode::MUL_INT:
+    case ByteCode::SUMCONST_INT:
+    case ByteCode::MULCONST_INT:
+      return new( owner ) LogicElement_Move<int  >( out, in );
+      
+    case ByteCode::SUM_FLOAT:
+    case ByteCode::MUL_FLOAT:
+    case ByteCode::SUMCONST_FLOAT:
+    case ByteCode::MULCONST_FLOAT:
+      return new( owner ) LogicElement_Move<float>( out, in );
+      
+    default:
+      // the layout of the opcodes is described at ByteCode::opcode_t
+      if( (op - ByteCode::REL_EQUAL_BOOL_INT) & 2 )
+        return new( owner ) LogicElement_Move<int >( out, in );
+      return new( owner ) LogicElement_Move<bool>( out, in );
+  }
+}
+
+/**
+ * Is the opcode @p op an expression that can be merged?
+ */
+static bool isExpression( const ByteCode::opcode_t op )
+{
+  return ( ByteCode::SUM_INT <= op && op <= ByteCode::MUL_FLOAT ) ||
+         ( ByteCode::SUMCONST_INT <= op && op <= ByteCode::MULCONST_FLOAT ) ||
+         ( ByteCode::REL_EQUAL_BOOL_INT <= op && op <= ByteCode::REL_GREATEREQUAL_INT_FLOAT );
+}
+
+/**
+ * Return the CONST opcode for the type of the result of the pure opcode
+ * @p op.
+ */
+static ByteCode::opcode_t constResult( const ByteCode::opcode_t op )
+{
+  switch( op )
+  {
+    case ByteCode::CONST_BOOL:
+    case ByteCode::MOVE_BOOL:
+      return ByteCode::CONST_BOOL;
+      
+    case ByteCode::CONST_INT:
+    case ByteCode::MOVE_INT:
+    case ByteCode::SUM_INT:
+    case ByteCode::MUL_INT:
+    case ByteCode::SUMCONST_INT:
+    case ByteCode::MULCONST_INT:
+      return ByteCode::CONST_INT;
+      
+    case ByteCode::CONST_FLOAT:
+    case ByteCode::MOVE_FLOAT:
+    case ByteCode::SUM_FLOAT:
+    case ByteCode::MUL_FLOAT:
+    case ByteCode::SUMCONST_FLOAT:
+    case ByteCode::MULCONST_FLOAT:
+      return ByteCode::CONST_FLOAT;
+      
+    default:
+      // the layout of the opcodes is described at ByteCode::opcode_t
+      return ( (op - ByteCode::REL_EQUAL_BOOL_INT) & 2 ) ? ByteCode::CONST_INT : ByteCode::CONST_BOOL;
+  }
+}
+
+/**
+ * Return the CONST opcode for the type of the inputs of the pure opcode
+ * @p op.
+ */
+static ByteCode::opcode_t constInput( const ByteCode::opcode_t op )
+{
+  if( ByteCode::REL_EQUAL_BOOL_INT <= op && op <= ByteCode::REL_GREATEREQUAL_INT_FLOAT )
+    return ( (op - ByteCode::REL_EQUAL_BOOL_INT) & 1 ) ? ByteCode::CONST_FLOAT : ByteCode::CONST_INT;
+  return constResult( op );
+}
+
+/**
+ * Return @p in1 <@p relation> @p in2, the relation is counted like
+ * LogicElement_Rel::relType.
+ */
+template<typename T>
+static bool compare( const int relation, const T in1, const T in2 )
+{
+  switch( relation )
+  {
+    case 0:  return in1 == in2;
+    case 1:  return in1 != in2;
+    case 2:  return in1 <  in2;
+    case 3:  return in1 <= in2;
+    case 4:  return in1 >  in2;
+    default: return in1 >= in2;
+  }
+}
+
+/**
+ * Calculate the pure opcode @p op - but not a CONST - for the inputs
+ * @p in1 and @p in2, given as immediates of the type of constInput().
+ */
+static ByteCode::operand_t calculate( const ByteCode::opcode_t op, const ByteCode::operand_t in1, const ByteCode::operand_t in2 )
+{
+  ByteCode::operand_t result;
+  switch( op )
+  {
+    case ByteCode::MOVE_BOOL:
+    case ByteCode::MOVE_INT:
+    case ByteCode::MOVE_FLOAT:
+      return in1;
+      
+    case ByteCode::SUM_INT:
+    case ByteCode::SUMCONST_INT:
+      result.i = in1.i + in2.i;
+      break;
+      
+    case ByteCode::SUM_FLOAT:
+    case ByteCode::SUMCONST_FLOAT:
+      result.f = in1.f + in2.f;
+      break;
+      
+    case ByteCode::MUL_INT:
+    case ByteCode::MULCONST_INT:
+      result.i = in1.i * in2.i;
+      break;
+      
+    case ByteCode::MUL_FLOAT:
+    case ByteCode::MULCONST_FLOAT:
+      result.f = in1.f * in2.f;
+      break;
+      
+    default:
+      {
+        // the layout of the opcodes is described at ByteCode::opcode_t
+        const int relation = op - ByteCode::REL_EQUAL_BOOL_INT;
+        result.i = (relation & 1) ? compare( relation / 4, in1.f, in2.f )
+                                  : compare( relation / 4, in1.i, in2.i );
+      }
+  }
+  return result;
+}
+
+size_t Optimizer::fuse( void )
+{
+  const size_t count = le.elementCount;
+  const std::vector<ByteCode::instruction_t> code = lower();
+  std::vector<bool> entry = entryPoints();
+  
+  // the blocks might run on their own, so they can't be fused either
+  for( auto start = le.blockStart.cbegin(); start != le.blockStart.cend(); ++start )
+    entry[ *start ] = true;
+  
+  std::vector<LogicElement_Generic*> elements;
+  std::vector<size_t> newIndex( count + 1 );
+  std::vector<size_t> origin;
+  
+  for( size_t i = 0; i < count; ++i )
+  {
+    newIndex[i] = elements.size();
+    origin.push_back( i );
+    
+    LogicElement_Generic* fused = nullptr;
+    if( i + 1 < count && !entry[i + 1] )
+      fused = fuse( &le, code[i], code[i + 1] );
+    
+    if( nullptr == fused )
+    {
+      elements.push_back( le.elementList[i] );
+      continue;
+    }
+    
+    delete le.elementList[i];
+    delete le.elementList[i + 1];
+    elements.push_back( fused );
+    origin.back() = ++i; // a fused jump is relative to the second element
+    newIndex[i] = elements.size() - 1;
+  }
+  newIndex[count] = elements.size();
+  
+  replace( elements, newIndex, origin );
+  
+  return count - elements.size();
+}
+
+LogicElement_Generic* Optimizer::fuse( LogicEngine* const owner,
+                                       const ByteCode::instruction_t& first, 
+                                       const ByteCode::instruction_t& second )
+{
+  if( ByteCode::REL_EQUAL_BOOL_INT <= first.op && first.op <= ByteCode::REL_GREATEREQUAL_INT_FLOAT )
+  {
+    // the layout of the opcodes is described at ByteCode::opcode_t
+    const int relation = first.op - ByteCode::REL_EQUAL_BOOL_INT;
+    const bool outInt  = relation & 2;
+    const bool inFloat = relation & 1;
+    
+    if( second.op != (outInt ? ByteCode::JUMPTRUE_INT : ByteCode::JUMPTRUE_BOOL) ||
+        second.b.offset != first.a.offset )
+      return nullptr;
+    
+    if( outInt )
+      return inFloat ? relJumpTrue<int , float>( owner, first, second, relation / 4 )
+                     : relJumpTrue<int , int  >( owner, first, second, relation / 4 );
+    return inFloat ? relJumpTrue<bool, float>( owner, first, second, relation / 4 )
+                   : relJumpTrue<bool, int  >( owner, first, second, relation / 4 );
+  }
+  
+  switch( first.op )
+  {
+    case ByteCode::MUL_INT:
+      return ByteCode::SUM_INT   == second.op ? mulSum<int  >( owner, first, second ) : nullptr;
+      
+    case ByteCode::MUL_FLOAT:
+      return ByteCode::SUM_FLOAT == second.op ? mulSum<float>( owner, first, second ) : nullptr;
+      
+    case ByteCode::MOVE_BOOL:
+      return ByteCode::MOVE_BOOL  == second.op ? move2<bool >( owner, first, second ) : nullptr;
+      
+    case ByteCode::MOVE_INT:
+      return ByteCode::MOVE_INT   == second.op ? move2<int  >( owner, first, second ) : nullptr;
+      
+    case ByteCode::MOVE_FLOAT:
+      return ByteCode::MOVE_FLOAT == second.op ? move2<float>( owner, first, second ) : nullptr;
+      
+    default:
+      return nullptr;
+  }
+}
+
+size_t Optimizer::fold( void )
+{
+  const size_t count = le.elementCount;
+  const size_t start = le.mainTask - le.elementList;
+  const std::vector<ByteCode::instruction_t> code = lower();
+  const std::vector<access_t> access = analyze( code );
+  const std::vector<raw_offset_t> outside = external();
+  
+  std::map<raw_offset_t, size_t> writes;    // number of writes, also from outside
+  std::map<raw_offset_t, size_t> firstRead; // first read in the main task
+  std::vector<bool> conditional( count + 1, false );
+  bool initJumps = false;
+  
+  // the state is restored by a checkpoint, so it's never constant
+  for( auto name = le.stateVariables.cbegin(); name != le.stateVariables.cend(); ++name )
+  {
+    auto variable = le.variableRegistry.find( *name );
+    if( le.variableRegistry.end() != variable )
+      ++writes[ variable->second.offset ];
+  }
+  for( auto e = outside.cbegin(); e != outside.cend(); ++e )
+    ++writes[ *e ];
+  
+  for( size_t i = 0; i < count; ++i )
+  {
+    if( !access[i].known )
+      return 0;
+    for( auto w = access[i].writes.cbegin(); w != access[i].writes.cend(); ++w )
+      ++writes[ *w ];
+    
+    long int offset;
+    const bool jumps = le.elementList[i]->getJumpOffset( offset );
+    
+    if( i < start )
+    {
+      // a jump to the end of the init would skip the folded instructions
+      if( jumps && static_cast<long int>( start ) <= static_cast<long int>( i ) + offset )
+        return 0;
+      initJumps = initJumps || jumps || ByteCode::STOP == code[i].op;
+      continue;
+    }
+    
+    for( auto r = access[i].reads.cbegin(); r != access[i].reads.cend(); ++r )
+      firstRead.insert( std::make_pair( *r, i ) );
+    
+    // the instructions that might be skipped in a cycle
+    size_t skipped = i;
+    if( jumps && 0 < offset )
+      skipped = std::min<size_t>( i + offset, count );
+    if( ByteCode::STOP == code[i].op )
+      skipped = count;
+    std::fill( conditional.begin() + i + 1, conditional.begin() + skipped + 1, true );
+  }
+  
+  // the values of the variables that are constant in the main task: those
+  // that are only set once by the init, the results that are folded below
+  // and those that are never written, i.e. that keep their initial value
+  std::map<raw_offset_t, ByteCode::operand_t> constants;
+  for( size_t i = 0; i < start && !initJumps; ++i )
+    if( ByteCode::CONST_BOOL <= code[i].op && code[i].op <= ByteCode::CONST_FLOAT && 1 == writes[ code[i].a.offset ] )
+      constants[ code[i].a.offset ] = code[i].b;
+  
+  auto value = [&]( const raw_offset_t offset, const ByteCode::opcode_t type, ByteCode::operand_t& result ) -> bool
+  {
+    auto constant = constants.find( offset );
+    if( constants.end() != constant )
+      result = constant->second;
+    else if( 0 != writes[ offset ] )
+      return false;
+    else if( ByteCode::CONST_BOOL == type )
+      result.i = le.read<bool>( offset );
+    else if( ByteCode::CONST_INT == type )
+      result.i = le.read<int>( offset );
+    else
+      result.f = le.read<float>( offset );
+    return true;
+  };
+  
+  // the constant results are calculated once and set at the end of the init,
+  // the other instructions get their constant inputs as immediates
+  std::vector<ByteCode::instruction_t> folded;
+  std::vector<bool> moved( count, false );
+  size_t changed = 0;
+  for( size_t i = start; i < count; ++i )
+  {
+    if( !access[i].pure )
+      continue;
+    
+    const ByteCode::instruction_t& instruction = code[i];
+    const ByteCode::opcode_t op   = instruction.op;
+    const ByteCode::opcode_t type = constInput( op );
+    const bool immediate = ByteCode::CONST_BOOL <= op && op <= ByteCode::CONST_FLOAT;
+    const bool unary     = ( ByteCode::MOVE_BOOL <= op && op <= ByteCode::MOVE_FLOAT ) ||
+                           ( ByteCode::SUMCONST_INT <= op && op <= ByteCode::MULCONST_FLOAT );
+    ByteCode::operand_t in1 = instruction.b;
+    ByteCode::operand_t in2 = instruction.c;
+    const bool known1 = immediate || value( instruction.b.offset, type, in1 );
+    const bool known2 = immediate || unary || value( instruction.c.offset, type, in2 );
+    
+    ByteCode::instruction_t replacement = instruction;
+    if( known1 && known2 )
+    {
+      replacement.op = constResult( op );
+      replacement.b  = immediate ? instruction.b : calculate( op, in1, in2 );
+      
+      // the result must only be written here, and not be used before
+      const raw_offset_t out = instruction.a.offset;
+      auto read = firstRead.find( out );
+      if( !conditional[i] && 1 == writes[ out ] && (firstRead.end() == read || i <= read->second) )
+      {
+        constants[ out ] = replacement.b;
+        folded.push_back( replacement );
+        moved[i] = true;
+        ++changed;
+        continue;
+      }
+      if( immediate )
+        continue;
+    }
+    else if( ByteCode::SUM_INT <= op && op <= ByteCode::MUL_FLOAT && ( known1 || known2 ) )
+    {
+      // sum and mul are commutative, so the constant becomes the second input
+      replacement.op = static_cast<ByteCode::opcode_t>( ByteCode::SUMCONST_INT + (op - ByteCode::SUM_INT) );
+      if( known1 )
+        replacement.b = instruction.c;
+      replacement.c = known1 ? in1 : in2;
+    }
+    else
+      continue;
+    
+    delete le.elementList[i];
+    le.elementList[i] = raise( &le, replacement );
+    ++changed;
+  }
+  
+  if( 0 == changed )
+    return 0;
+  
+  // the new order: init, the folded constants, the rest of the main task
+  std::vector<LogicElement_Generic*> elements( le.elementList, le.elementList + start );
+  std::vector<size_t> newIndex( count + 1 );
+  std::vector<size_t> origin( start );
+  for( size_t i = 0; i < start; ++i )
+    newIndex[i] = origin[i] = i;
+  for( auto constant = folded.cbegin(); constant != folded.cend(); ++constant )
+  {
+    elements.push_back( raise( &le, *constant ) );
+    origin.push_back( start );
+  }
+  for( size_t i = start; i < count; ++i )
+  {
+    if( moved[i] )
+    {
+      delete le.elementList[i];
+      continue;
+    }
+    newIndex[i] = elements.size();
+    elements.push_back( le.elementList[i] );
+    origin.push_back( i );
+  }
+  newIndex[count] = elements.size();
+  
+  // the folded instructions continue at the next remaining one
+  for( size_t i = count; i-- > start; )
+    if( moved[i] )
+      newIndex[i] = newIndex[i + 1];
+  
+  replace( elements, newIndex, origin );
+  
+  return changed;
+}
+
+size_t Optimizer::merge( void )
+{
+  typedef std::tuple<ByteCode::opcode_t, raw_offset_t, raw_offset_t> expression_t;
+  
+  const size_t count = le.elementCount;
+  const size_t start = le.mainTask - le.elementList;
+  const std::vector<ByteCode::instruction_t> code = lower();
+  const std::vector<access_t> access = analyze( code );
+  const std::vector<bool> entry = entryPoints();
+  
+  // the expressions calculated so far in this basic block and their result
+  std::map<expression_t, raw_offset_t> available;
+  size_t merged = 0;
+  
+  for( size_t i = start; i < count; ++i )
+  {
+    const ByteCode::instruction_t& instruction = code[i];
+    if( entry[i] || !access[i].known )
+      available.clear();
+    
+    const bool expression = isExpression( instruction.op );
+    raw_offset_t b = instruction.b.offset;
+    raw_offset_t c = instruction.c.offset;
+    if( instruction.op <= ByteCode::MUL_FLOAT && c < b )
+      std::swap( b, c ); // sum and mul are commutative
+    const expression_t key( instruction.op, b, c );
+    
+    if( expression )
+    {
+      auto found = available.find( key );
+      if( available.end() != found && found->second != instruction.a.offset )
+      {
+        delete le.elementList[i];
+        le.elementList[i] = moveResult( &le, instruction.op, instruction.a.offset, found->second );
+        ++merged;
+      }
+    }
+    
+    // forget all expressions that depend on the written variables
+    for( auto w = access[i].writes.cbegin(); w != access[i].writes.cend(); ++w )
+    {
+      for( auto it = available.begin(); it != available.end(); )
+      {
+        if( std::get<1>( it->first ) == *w || std::get<2>( it->first ) == *w || it->second == *w )
+          it = available.erase( it );
+        else
+          ++it;
+      }
+    }
+    
+    long int offset;
+    if( le.elementList[i]->getJumpOffset( offset ) || ByteCode::STOP == instruction.op )
+      available.clear();
+    else if( expression && b != instruction.a.offset && c != instruction.a.offset )
+      available.insert( std::make_pair( key, instruction.a.offset ) );
+  }
+  
+  if( 0 != merged )
+  {
+    le.byteCode.clear();
+    le.blocks.clear();
+  }
+  
+  return merged;
+}
+
+size_t Optimizer::eliminate( const std::vector<std::string>& observed )
+{
+  const size_t count = le.elementCount;
+  const size_t start = le.mainTask - le.elementList;
+  const std::vector<ByteCode::instruction_t> code = lower();
+  const std::vector<access_t> access = analyze( code );
+  
+  // the observed variables and the state keep their writers and so their
+  // names
+  std::set<raw_offset_t> used;
+  std::set<std::string> names( observed.cbegin(), observed.cend() );
+  names.insert( le.stateVariables.cbegin(), le.stateVariables.cend() );
+  for( auto name = names.cbegin(); name != names.cend(); ++name )
+  {
+    auto variable = le.variableRegistry.find( *name );
+    if( le.variableRegistry.end() != variable )
+      used.insert( variable->second.offset );
+  }
+  
+  std::vector<bool> keep( count, true );
+  for( size_t i = start; i < count; ++i )
+  {
+    if( !access[i].known )
+      return 0;
+    keep[i] = access[i].effect;
+    if( keep[i] )
+      used.insert( access[i].reads.cbegin(), access[i].reads.cend() );
+  }
+  
+  // an instruction is needed when its result is used - till nothing changes
+  for( bool changed = true; changed; )
+  {
+    changed = false;
+    for( size_t i = start; i < count; ++i )
+    {
+      if( keep[i] || std::none_of( access[i].writes.cbegin(), access[i].writes.cend(), 
+                                   [&]( raw_offset_t w ){ return 0 != used.count( w ); } ) )
+        continue;
+      
+      keep[i] = true;
+      used.insert( access[i].reads.cbegin(), access[i].reads.cend() );
+      changed = true;
+    }
+  }
+  
+  // the results of the removed instructions aren't updated any more, so
+  // they aren't accessible by their name - unless another element writes them
+  std::set<raw_offset_t> stale;
+  bool allKnown = true;
+  for( size_t i = 0; i < count; ++i )
+    if( !keep[i] )
+      stale.insert( access[i].writes.cbegin(), access[i].writes.cend() );
+  for( size_t i = 0; i < count; ++i )
+  {
+    allKnown = allKnown && access[i].known;
+    if( keep[i] )
+      for( auto w = access[i].writes.cbegin(); w != access[i].writes.cend(); ++w )
+        stale.erase( *w );
+  }
+  for( auto it = le.importRegistry.cbegin(); it != le.importRegistry.cend(); ++it )
+    stale.erase( it->second.offset );
+  for( auto it = le.variableRegistry.begin(); allKnown && it != le.variableRegistry.end(); )
+  {
+    if( 0 != stale.count( it->second.offset ) )
+      it = le.variableRegistry.erase( it );
+    else
+      ++it;
+  }
+  
+  std::vector<LogicElement_Generic*> elements;
+  std::vector<size_t> newIndex( count + 1 );
+  std::vector<size_t> origin;
+  for( size_t i = 0; i < count; ++i )
+  {
+    newIndex[i] = elements.size(); // a removed element continues at the next
+    if( !keep[i] )
+    {
+      delete le.elementList[i];
+      continue;
+    }
+    elements.push_back( le.elementList[i] );
+    origin.push_back( i );
+  }
+  newIndex[count] = elements.size();
+  
+  const size_t removed = count - elements.size();
+  if( 0 != removed )
+    replace( elements, newIndex, origin );
+  
+  return removed;
+}
+
+size_t Optimizer::allocate( const std::vector<std::string>& pinned )
+{
+  /**
+   * A temporary variable and the instructions where it is live.
+   */
+  struct temporary_t
+  {
+    raw_offset_t offset;
+    size_t size;
+    size_t first;
+    size_t last;
+    size_t uses;
+    raw_offset_t slot;
+  };
+  
+  const size_t count = le.elementCount;
+  const size_t start = le.mainTask - le.elementList;
+  const std::vector<ByteCode::instruction_t> code = lower();
+  const std::vector<access_t> access = analyze( code );
+  const std::vector<raw_offset_t> outside = external();
+  
+  // the variables that keep their own slot - and so their name
+  std::set<raw_offset_t> fixed( outside.cbegin(), outside.cend() );
+  std::set<std::string> names( pinned.cbegin(), pinned.cend() );
+  names.insert( le.stateVariables.cbegin(), le.stateVariables.cend() );
+  for( auto name = names.cbegin(); name != names.cend(); ++name )
+  {
+    auto variable = le.variableRegistry.find( *name );
+    if( le.variableRegistry.end() != variable )
+      fixed.insert( variable->second.offset );
+  }
+  
+  std::vector<bool> conditional( count + 1, false );
+  std::vector<std::pair<size_t, size_t>> loops;
+  std::map<raw_offset_t, temporary_t> temporaries;
+  for( size_t i = 0; i < count; ++i )
+  {
+    if( !access[i].known )
+      return 0;
+    
+    // the init and the elements without opcode (they can't be changed) keep
+    // their variables, as well as all variables that are read before written
+    if( i < start || ByteCode::CALL == code[i].op )
+    {
+      fixed.insert( access[i].reads.cbegin(), access[i].reads.cend() );
+      fixed.insert( access[i].writes.cbegin(), access[i].writes.cend() );
+      continue;
+    }
+    for( auto r = access[i].reads.cbegin(); r != access[i].reads.cend(); ++r )
+    {
+      auto temporary = temporaries.find( *r );
+      if( temporaries.end() == temporary )
+        fixed.insert( *r );
+      else
+      {
+        temporary->second.last = i;
+        ++temporary->second.uses;
+      }
+    }
+    for( auto w = access[i].writes.cbegin(); w != access[i].writes.cend(); ++w )
+    {
+      if( 0 == fixed.count( *w ) && 0 == temporaries.count( *w ) )
+      {
+        if( conditional[i] )
+          fixed.insert( *w );
+        else
+          temporaries[ *w ] = { *w, 0, i, i, 0, 0 };
+      }
+      auto temporary = temporaries.find( *w );
+      if( temporaries.end() != temporary )
+      {
+        temporary->second.last = i;
+        ++temporary->second.uses;
+      }
+    }
+    
+    long int offset;
+    if( le.elementList[i]->getJumpOffset( offset ) )
+    {
+      if( 0 < offset )
+        std::fill( conditional.begin() + i + 1, conditional.begin() + std::min<size_t>( i + offset, count ) + 1, true );
+      else
+        loops.push_back( std::make_pair( i + offset, i ) );
+    }
+    if( ByteCode::STOP == code[i].op )
+      std::fill( conditional.begin() + i + 1, conditional.end(), true );
+  }
+  
+  // only the registered variables are known to be no part of a larger one
+  for( auto it = le.variableRegistry.cbegin(); it != le.variableRegistry.cend(); ++it )
+  {
+    auto temporary = temporaries.find( it->second.offset );
+    if( temporaries.end() != temporary )
+      temporary->second.size = variableType::sizeOf( it->second.type );
+  }
+  
+  const std::vector<size_t> bounds = boundaries();
+  std::vector<temporary_t*> sorted;
+  for( auto it = temporaries.begin(); it != temporaries.end(); ++it )
+  {
+    if( 0 != fixed.count( it->first ) || 0 == it->second.size )
+      continue;
+    
+    // a value that is read in a later iteration of a loop is live in the
+    // whole loop
+    for( bool changed = true; changed; )
+    {
+      changed = false;
+      for( auto loop = loops.cbegin(); loop != loops.cend(); ++loop )
+      {
+        if( it->second.first < loop->first && loop->first <= it->second.last && it->second.last < loop->second )
+        {
+          it->second.last = loop->second;
+          changed = true;
+        }
+      }
+    }
+    
+    // a result that is passed to a later block keeps its slot as the later
+    // block might run on its own
+    auto block = std::upper_bound( bounds.cbegin(), bounds.cend(), it->second.first );
+    if( bounds.cend() != block && *block <= it->second.last )
+      continue;
+    
+    sorted.push_back( &it->second );
+  }
+  std::sort( sorted.begin(), sorted.end(), []( const temporary_t* a, const temporary_t* b ){ return a->first < b->first; } );
+  
+  // linear scan: a slot is free again after the last use of its variable
+  struct slot_t
+  {
+    size_t size;
+    size_t last;
+    size_t uses;
+    std::vector<temporary_t*> variables;
+  };
+  std::vector<slot_t> slots;
+  for( auto temporary = sorted.begin(); temporary != sorted.end(); ++temporary )
+  {
+    auto slot = std::find_if( slots.begin(), slots.end(), [&]( const slot_t& s )
+      { return s.size == (*temporary)->size && s.last < (*temporary)->first; } );
+    if( slots.end() == slot )
+      slot = slots.insert( slots.end(), slot_t{ (*temporary)->size, 0, 0, {} } );
+    slot->last = (*temporary)->last;
+    slot->uses += (*temporary)->uses;
+    slot->variables.push_back( *temporary );
+  }
+  
+  if( slots.size() == sorted.size() )
+    return 0;
+  
+  // the hottest slots are packed together at the end of the variables, the
+  // larger ones first to keep the natural alignment
+  std::sort( slots.begin(), slots.end(), []( const slot_t& a, const slot_t& b )
+    { return a.size != b.size ? a.size > b.size : a.uses > b.uses; } );
+  for( auto slot = slots.begin(); slot != slots.end(); ++slot )
+  {
+    le.variableCount = ( le.variableCount + slot->size - 1 ) & ~( slot->size - 1 );
+    for( auto variable = slot->variables.begin(); variable != slot->variables.end(); ++variable )
+      (*variable)->slot = le.variableCount;
+    le.variableCount += slot->size;
+  }
+  le.growVariables();
+  
+  // the temporaries aren't accessible by name any more
+  for( auto it = le.variableRegistry.begin(); it != le.variableRegistry.end(); )
+  {
+    auto temporary = temporaries.find( it->second.offset );
+    if( temporaries.end() != temporary && 0 != temporary->second.slot )
+      it = le.variableRegistry.erase( it );
+    else
+      ++it;
+  }
+  
+  for( size_t i = start; i < count; ++i )
+  {
+    ByteCode::instruction_t instruction = code[i];
+    bool changed = false;
+    for( auto operand = access[i].operands.cbegin(); operand != access[i].operands.cend(); ++operand )
+    {
+      auto temporary = temporaries.find( (code[i].*(*operand)).offset );
+      if( temporaries.end() == temporary || 0 == temporary->second.slot )
+        continue;
+      (instruction.*(*operand)).offset = temporary->second.slot;
+      changed = true;
+    }
+    
+    if( changed )
+    {
+      delete le.elementList[i];
+      le.elementList[i] = raise( &le, instruction );
+    }
+  }
+  le.byteCode.clear();
+  le.blocks.clear();
+  
+  return sorted.size() - slots.size();
+}
+
+size_t Optimizer::dependencies( void )
+{
+  const size_t count = le.elementCount;
+  const size_t start = le.mainTask - le.elementList;
+  const std::vector<ByteCode::instruction_t> code = lower();
+  const std::vector<access_t> access = analyze( code );
+  
+  le.blocks.clear();
+  le.importReaders.clear();
+  le.statusReaders.clear();
+  le.clockReaders.clear();
+  le.pending.clear();
+  le.followers.clear();
+  le.taskCode.clear();
+  if( start == count )
+    return 0;
+  
+  // the elements of the main task before the first mark are a block as well
+  const std::vector<size_t> bounds = boundaries();
+  std::vector<LogicEngine::block_t> blocks( 1, { start, count, 0, {}, {}, false, false } );
+  for( auto s = bounds.cbegin(); s != bounds.cend(); ++s )
+  {
+    if( *s <= blocks.back().start || count <= *s )
+      continue;
+    blocks.back().end = *s;
+    blocks.push_back( { *s, count, 0, {}, {}, false, false } );
+  }
+  for( auto b = blocks.begin(); b != blocks.end(); ++b )
+    while( b->group + 1 < le.groups.size() && le.groups[ b->group + 1 ].start <= b->start )
+      ++b->group;
+  
+  // the blocks that read a variable before they have written it and the
+  // blocks that write it
+  std::map<raw_offset_t, std::set<size_t>> readers;
+  std::map<raw_offset_t, std::set<size_t>> writers;
+  std::vector<std::set<raw_offset_t>> blockReads( blocks.size() );
+  std::vector<std::set<raw_offset_t>> blockWrites( blocks.size() );
+  for( size_t b = 0; b < blocks.size(); ++b )
+  {
+    const size_t end = blocks[b].end;
+    std::set<raw_offset_t> written;
+    std::vector<bool> conditional( count + 1, false );
+    for( size_t i = blocks[b].start; i < end; ++i )
+    {
+      if( !access[i].known || ByteCode::STOP == code[i].op )
+        return 0;
+      if( ByteCode::CALL == code[i].op )
+        blocks[b].calls = true;
+      if( le.elementList[i]->canAwait() )
+        blocks[b].awaits = true;
+      blockReads [b].insert( access[i].reads .cbegin(), access[i].reads .cend() );
+      blockWrites[b].insert( access[i].writes.cbegin(), access[i].writes.cend() );
+      
+      long int offset;
+      const bool jumps = le.elementList[i]->getJumpOffset( offset );
+      if( jumps && ( static_cast<long int>( i ) + offset < static_cast<long int>( blocks[b].start ) || 
+                     static_cast<long int>( end ) < static_cast<long int>( i ) + offset ) )
+        return 0;
+      
+      for( auto r = access[i].reads.cbegin(); r != access[i].reads.cend(); ++r )
+        if( 0 == written.count( *r ) )
+          readers[ *r ].insert( b );
+      for( auto w = access[i].writes.cbegin(); w != access[i].writes.cend(); ++w )
+      {
+        writers[ *w ].insert( b );
+        if( !conditional[i] )
+          written.insert( *w );
+      }
+      
+      if( jumps && 0 < offset )
+        std::fill( conditional.begin() + i + 1, conditional.begin() + i + offset + 1, true );
+    }
+  }
+  
+  for( auto r = readers.cbegin(); r != readers.cend(); ++r )
+  {
+    auto w = writers.find( r->first );
+    if( writers.end() == w )
+      continue;
+    
+    // which of the results is read depends on the blocks that have run
+    if( 1 != w->second.size() )
+      return 0;
+    
+    // a block of another rate group reads the last result when it runs,
+    // like a state
+    LogicEngine::block_t& writer = blocks[ *w->second.cbegin() ];
+    for( auto b = r->second.cbegin(); b != r->second.cend(); ++b )
+    {
+      if( *w->second.cbegin() < *b && writer.group == blocks[ *b ].group )
+        writer.successors.push_back( *b );
+      else
+        writer.carried.push_back( *b );
+    }
+  }
+  for( auto b = blocks.begin(); b != blocks.end(); ++b )
+  {
+    std::sort( b->successors.begin(), b->successors.end() );
+    b->successors.erase( std::unique( b->successors.begin(), b->successors.end() ), b->successors.end() );
+    std::sort( b->carried.begin(), b->carried.end() );
+    b->carried.erase( std::unique( b->carried.begin(), b->carried.end() ), b->carried.end() );
+  }
+  
+  // the order of the blocks when they run in parallel: each access has to
+  // wait for the last write before and a write also for the reads since then
+  std::vector<std::set<size_t>> order( blocks.size() );
+  std::map<raw_offset_t, size_t> lastWriter;
+  std::map<raw_offset_t, std::vector<size_t>> lastReaders;
+  for( size_t b = 0; b < blocks.size(); ++b )
+  {
+    for( auto r = blockReads[b].cbegin(); r != blockReads[b].cend(); ++r )
+    {
+      auto w = lastWriter.find( *r );
+      if( lastWriter.end() != w && w->second != b )
+        order[ w->second ].insert( b );
+      lastReaders[ *r ].push_back( b );
+    }
+    for( auto w = blockWrites[b].cbegin(); w != blockWrites[b].cend(); ++w )
+    {
+      auto last = lastWriter.find( *w );
+      if( lastWriter.end() != last && last->second != b )
+        order[ last->second ].insert( b );
+      std::vector<size_t>& reading = lastReaders[ *w ];
+      for( auto r = reading.cbegin(); r != reading.cend(); ++r )
+        if( *r != b )
+          order[ *r ].insert( b );
+      reading.clear();
+      lastWriter[ *w ] = b;
+    }
+  }
+  le.followers.clear();
+  for( auto o = order.cbegin(); o != order.cend(); ++o )
+    le.followers.push_back( std::vector<size_t>( o->cbegin(), o->cend() ) );
+  le.taskCode.clear();
+  
+  auto readersOf = [&readers]( raw_offset_t offset ) -> std::vector<size_t>
+  {
+    auto r = readers.find( offset );
+    if( readers.end() == r )
+      return {};
+    return std::vector<size_t>( r->second.cbegin(), r->second.cend() );
+  };
+  for( auto it = le.importRegistry.cbegin(); it != le.importRegistry.cend(); ++it )
+  {
+    le.importReaders.push_back( readersOf( it->second.offset ) );
+    le.statusReaders.push_back( readersOf( it->second.offset + variableType::sizeOf( it->second.type ) ) );
+  }
+  for( auto g = le.groups.cbegin(); g != le.groups.cend(); ++g )
+    le.clockReaders.push_back( readersOf( g->dt ) );
+  
+  // everything has to run once
+  le.pending.assign( blocks.size(), true );
+  le.blocks.swap( blocks );
+  
+  return le.blocks.size();
+}
+
+std::vector<ByteCode::instruction_t> Optimizer::lower( void ) const
+{
+  std::vector<ByteCode::instruction_t> code( le.elementCount );
+  
+  for( size_t i = 0; i < le.elementCount; ++i )
+  {
+    code[i].op = ByteCode::CALL;
+    le.elementList[i]->lower( code[i] );
+  }
+  
+  return code;
+}
+
+std::vector<bool> Optimizer::entryPoints( void ) const
+{
+  const long int count = le.elementCount;
+  std::vector<bool> entry( count + 1, false );
+  
+  entry[ le.mainTask - le.elementList ] = true;
+  for( size_t g = 1; g < le.groups.size(); ++g )
+    entry[ le.groups[g].start ] = true;
+  
+  for( long int i = 0; i < count; ++i )
+  {
+    long int offset;
+    if( le.elementList[i]->getJumpOffset( offset ) && 0 <= i + offset && i + offset <= count )
+      entry[ i + offset ] = true;
+  }
+  
+  return entry;
+}
+
+std::vector<size_t> Optimizer::boundaries( void ) const
+{
+  std::vector<size_t> bounds( le.blockStart );
+  for( size_t g = 1; g < le.groups.size(); ++g )
+    bounds.push_back( le.groups[g].start );
+  
+  std::sort( bounds.begin(), bounds.end() );
+  bounds.erase( std::unique( bounds.begin(), bounds.end() ), bounds.end() );
+  return bounds;
+}
+
+std::vector<Optimizer::access_t> Optimizer::analyze( const std::vector<ByteCode::instruction_t>& code ) const
+{
+  std::vector<access_t> access( code.size() );
+  
+  for( size_t i = 0; i < code.size(); ++i )
+  {
+    const ByteCode::instruction_t& instruction = code[i];
+    std::vector<raw_offset_t>& reads  = access[i].reads;
+    std::vector<raw_offset_t>& writes = access[i].writes;
+    auto read = [&]( operand_t operand )
+    {
+      reads.push_back( (instruction.*operand).offset );
+      access[i].operands.push_back( operand );
+    };
+    auto write = [&]( operand_t operand )
+    {
+      writes.push_back( (instruction.*operand).offset );
+      access[i].operands.push_back( operand );
+    };
+    access[i].known  = true;
+    access[i].pure   = false;
+    access[i].effect = false;
+    
+    switch( instruction.op )
+    {
+      case ByteCode::CALL:
+      case ByteCode::AWAIT:
+        access[i].known  = le.elementList[i]->getAccess( reads, writes );
+        access[i].effect = true;
+        break;
+        
+      case ByteCode::END:
+      case ByteCode::RETURN:
+      case ByteCode::STOP:
+      case ByteCode::JUMP:
+        access[i].effect = true;
+        break;
+        
+      case ByteCode::JUMPTRUE_BOOL:
+      case ByteCode::JUMPTRUE_INT:
+      case ByteCode::JUMPZERO_BOOL:
+      case ByteCode::JUMPZERO_INT:
+        read( &ByteCode::instruction_t::b );
+        access[i].effect = true;
+        break;
+        
+      case ByteCode::JUMPEQUAL_INT:
+      case ByteCode::JUMPEQUAL_FLOAT:
+      case ByteCode::JUMPNOTEQUAL_INT:
+      case ByteCode::JUMPNOTEQUAL_FLOAT:
+        read( &ByteCode::instruction_t::b );
+        read( &ByteCode::instruction_t::c );
+        access[i].effect = true;
+        break;
+        
+      case ByteCode::CONST_BOOL:
+      case ByteCode::CONST_INT:
+      case ByteCode::CONST_FLOAT:
+        write( &ByteCode::instruction_t::a );
+        access[i].pure = true;
+        break;
+        
+      case ByteCode::MOVE_BOOL:
+      case ByteCode::MOVE_INT:
+      case ByteCode::MOVE_FLOAT:
+        read( &ByteCode::instruction_t::b );
+        write( &ByteCode::instruction_t::a );
+        access[i].pure = true;
+        break;
+        
+      case ByteCode::SUMCONST_INT:
+      case ByteCode::SUMCONST_FLOAT:
+      case ByteCode::MULCONST_INT:
+      case ByteCode::MULCONST_FLOAT:
+        read( &ByteCode::instruction_t::b );
+        write( &ByteCode::instruction_t::a );
+        access[i].pure = true;
+        break;
+        
+      case ByteCode::MULADD_INT:
+      case ByteCode::MULADD_FLOAT:
+      case ByteCode::MULSUB_INT:
+      case ByteCode::MULSUB_FLOAT:
+        read( &ByteCode::instruction_t::a );
+        read( &ByteCode::instruction_t::b );
+        read( &ByteCode::instruction_t::c );
+        write( &ByteCode::instruction_t::a );
+        break;
+        
+      case ByteCode::MOVE2_BOOL:
+      case ByteCode::MOVE2_INT:
+      case ByteCode::MOVE2_FLOAT:
+        read( &ByteCode::instruction_t::b );
+        read( &ByteCode::instruction_t::d );
+        write( &ByteCode::instruction_t::a );
+        write( &ByteCode::instruction_t::c );
+        break;
+        
+      case ByteCode::MULSUM_INT:
+      case ByteCode::MULSUM_FLOAT:
+        read( &ByteCode::instruction_t::b );
+        read( &ByteCode::instruction_t::c );
+        read( &ByteCode::instruction_t::d );
+        write( &ByteCode::instruction_t::e );
+        write( &ByteCode::instruction_t::a );
+        break;
+        
+      default:
+        read( &ByteCode::instruction_t::b );
+        read( &ByteCode::instruction_t::c );
+        if( ByteCode::RELJUMP_EQUAL_BOOL_INT <= instruction.op )
+        {
+          write( &ByteCode::instruction_t::d );
+          access[i].effect = true;
+        }
+        else
+        {
+          // SUM, MUL and REL
+          write( &ByteCode::instruction_t::a );
+          access[i].pure = true;
+        }
+    }
+  }
+  
+  return access;
+}
+
+LogicElement_Generic* Optimizer::raise( LogicEngine* const owner, const ByteCode::instruction_t& instruction )
+{
+  const raw_offset_t a = instruction.a.offset;
+  const raw_offset_t b = instruction.b.offset;
+  const raw_offset_t c = instruction.c.offset;
+  const raw_offset_t d = instruction.d.offset;
+  const raw_offset_t e = instruction.e.offset;
+  const long int jump  = instruction.a.jump;
+  
+  switch( instruction.op )
+  {
+    case ByteCode::STOP:               return new( owner ) LogicElement_Stop;
+    case ByteCode::JUMP:               return new( owner ) LogicElement_Jump( jump );
+    case ByteCode::JUMPTRUE_BOOL:      return new( owner ) LogicElement_JumpTrue<bool>( jump, b );
+    case ByteCode::JUMPTRUE_INT:       return new( owner ) LogicElement_JumpTrue<int >( jump, b );
+    case ByteCode::JUMPZERO_BOOL:      return new( owner ) LogicElement_JumpZero<bool>( jump, b );
+    case ByteCode::JUMPZERO_INT:       return new( owner ) LogicElement_JumpZero<int >( jump, b );
+    case ByteCode::JUMPEQUAL_INT:      return new( owner ) LogicElement_JumpEqual<int  >( jump, b, c );
+    case ByteCode::JUMPEQUAL_FLOAT:    return new( owner ) LogicElement_JumpEqual<float>( jump, b, c );
+    case ByteCode::JUMPNOTEQUAL_INT:   return new( owner ) LogicElement_JumpNotEqual<int  >( jump, b, c );
+    case ByteCode::JUMPNOTEQUAL_FLOAT: return new( owner ) LogicElement_JumpNotEqual<float>( jump, b, c );
+    case ByteCode::CONST_BOOL:         return new( owner ) LogicElement_Const<bool >( a, instruction.b.i );
+    case ByteCode::CONST_INT:          return new( owner ) LogicElement_Const<int  >( a, instruction.b.i );
+    case ByteCode::CONST_FLOAT:        return new( owner ) LogicElement_Const<float>( a, instruction.b.f );
+    case ByteCode::MOVE_BOOL:          return new( owner ) LogicElement_Move<bool >( a, b );
+    case ByteCode::MOVE_INT:           return new( owner ) LogicElement_Move<int  >( a, b );
+    case ByteCode::MOVE_FLOAT:         return new( owner ) LogicElement_Move<float>( a, b );
+    case ByteCode::SUM_INT:            return new( owner ) LogicElement_Sum<int  >( a, b, c );
+    case ByteCode::SUM_FLOAT:          return new( owner ) LogicElement_Sum<float>( a, b, c );
+    case ByteCode::MUL_INT:            return new( owner ) LogicElement_Mul<int  >( a, b, c );
+    case ByteCode::MUL_FLOAT:          return new( owner ) LogicElement_Mul<float>( a, b, c );
+    case ByteCode::MULADD_INT:         return new( owner ) LogicElement_MulAdd<int  >( a, b, c );
+    case ByteCode::MULADD_FLOAT:       return new( owner ) LogicElement_MulAdd<float>( a, b, c );
+    case ByteCode::MULSUB_INT:         return new( owner ) LogicElement_MulSub<int  >( a, b, c );
+    case ByteCode::MULSUB_FLOAT:       return new( owner ) LogicElement_MulSub<float>( a, b, c );
+    case ByteCode::SUMCONST_INT:       return new( owner ) LogicElement_SumConst<int  >( a, b, instruction.c.i );
+    case ByteCode::SUMCONST_FLOAT:     return new( owner ) LogicElement_SumConst<float>( a, b, instruction.c.f );
+    case ByteCode::MULCONST_INT:       return new( owner ) LogicElement_MulConst<int  >( a, b, instruction.c.i );
+    case ByteCode::MULCONST_FLOAT:     return new( owner ) LogicElement_MulConst<float>( a, b, instruction.c.f );
+    case ByteCode::MOVE2_BOOL:         return new( owner ) LogicElement_Move2<bool >( a, b, c, d );
+    case ByteCode::MOVE2_INT:          return new( owner ) LogicElement_Move2<int  >( a, b, c, d );
+    case ByteCode::MOVE2_FLOAT:        return new( owner ) LogicElement_Move2<float>( a, b, c, d );
+    case ByteCode::MULSUM_INT:         return new( owner ) LogicElement_MulSum<int  >( a, e, b, c, d );
+    case ByteCode::MULSUM_FLOAT:       return new( owner ) LogicElement_MulSum<float>( a, e, b, c, d );
+    default:
+      break;
+  }
+  
+  // the layout of the opcodes is described at ByteCode::opcode_t
+  if( ByteCode::REL_EQUAL_BOOL_INT <= instruction.op && instruction.op <= ByteCode::REL_GREATEREQUAL_INT_FLOAT )
+  {
+    const int relation = instruction.op - ByteCode::REL_EQUAL_BOOL_INT;
+    switch( relation % 4 )
+    {
+      case 0:  return rel<bool, int  >( owner, instruction, relation / 4 );
+      case 1:  return rel<bool, float>( owner, instruction, relation / 4 );
+      case 2:  return rel<int , int  >( owner, instruction, relation / 4 );
+      default: return rel<int , float>( owner, instruction, relation / 4 );
+    }
+  }
+  
+  if( ByteCode::RELJUMP_EQUAL_BOOL_INT <= instruction.op && instruction.op <= ByteCode::RELJUMP_GREATEREQUAL_INT_FLOAT )
+  {
+    const int relation = instruction.op - ByteCode::RELJUMP_EQUAL_BOOL_INT;
+    switch( relation % 4 )
+    {
+      case 0:  return relJump<bool, int  >( owner, instruction, relation / 4 );
+      case 1:  return relJump<bool, float>( owner, instruction, relation / 4 );
+      case 2:  return relJump<int , int  >( owner, instruction, relation / 4 );
+      default: return relJump<int , float>( owner, instruction, relation / 4 );
+    }
+  }
+  
+  return nullptr; // CALL and END
+}
+
+std::vector<raw_offset_t> Optimizer::external( void ) const
+{
+  std::vector<raw_offset_t> outside;
+  for( auto g = le.groups.cbegin(); g != le.groups.cend(); ++g )
+    outside.push_back( g->dt );
+  
+  for( auto it = le.importRegistry.cbegin(); it != le.importRegistry.cend(); ++it )
+  {
+    outside.push_back( it->second.offset );
+    outside.push_back( it->second.offset + variableType::sizeOf( it->second.type ) ); // the status
+  }
+  
+  return outside;
+}
+
+void Optimizer::replace( const std::vector<LogicElement_Generic*>& elements,
+                         const std::vector<size_t>& newIndex,
+                         const std::vector<size_t>& origin )
+{
+  for( size_t i = 0; i < elements.size(); ++i )
+  {
+    long int offset;
+    if( elements[i]->getJumpOffset( offset ) )
+    {
+      const long int target = origin[i] + offset;
+      ASSERT_MSG( 0 <= target && target < static_cast<long int>( newIndex.size() ),
+                  "Jump target " << target << " out of range!" );
+      elements[i]->relocate( static_cast<long int>( newIndex[ target ] ) - static_cast<long int>( i ) );
+    }
+    
+    le.elementList[i] = elements[i];
+  }
+  
+  le.mainTask = le.elementList + newIndex[ le.mainTask - le.elementList ];
+  le.elementCount = elements.size();
+  le.byteCode.clear();
+  
+  // a block that lost all its elements starts where the next one does, it's
+  // dropped together with its name
+  size_t kept = 0;
+  for( size_t b = 0; b < le.blockStart.size(); ++b )
+  {
+    const size_t start = newIndex[ le.blockStart[b] ];
+    if( 0 < kept && start == le.blockStart[ kept - 1 ] )
+      --kept;
+    le.blockStart[ kept ] = start;
+    le.blockNames[ kept ] = le.blockNames[b];
+    ++kept;
+  }
+  le.blockStart.resize( kept );
+  le.blockNames.resize( kept );
+  for( size_t g = 1; g < le.groups.size(); ++g )
+    le.groups[g].start = newIndex[ le.groups[g].start ];
+  le.blocks.clear();
+}
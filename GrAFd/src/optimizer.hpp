@@ -0,0 +1,192 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include <vector>
+#include <string>
+
+#include "globals.h"
+#include "bytecode.hpp"
+
+class LogicEngine;
+class LogicElement_Generic;
+
+/**
+ * The Optimizer transforms the LogicElements of a LogicEngine into
+ * equivalent but faster ones.
+ * It has to run after the logic was imported and before it is running.
+ */
+class Optimizer
+{
+public:
+  /**
+   * Constructor - optimize the LogicEngine @p logicEngine.
+   */
+  Optimizer( LogicEngine& logicEngine ) : le( logicEngine )
+  {}
+  
+  /**
+   * Peephole pass: fuse common sequences of two instructions into one
+   * superinstruction. The second instruction mustn't be a jump target.
+   * 
+   * @return the number of removed instructions
+   */
+  size_t fuse( void );
+  
+  /**
+   * Constant folding: the instructions of the main task that only depend on
+   * constants - variables that are set once by the init or never written,
+   * like the parameters - are calculated now. Their result is set by a
+   * CONST at the end of the initialisation when it's written only there,
+   * otherwise the instruction becomes a CONST in place. A sum or a product
+   * with one constant input gets it as an immediate.
+   * The state variables are never constant, a checkpoint restores them.
+   * 
+   * @return the number of folded instructions
+   */
+  size_t fold( void );
+  
+  /**
+   * Common subexpression elimination: an expression of the main task that
+   * was already calculated before in the same basic block is replaced by
+   * a move of the earlier result.
+   * 
+   * @return the number of replaced instructions
+   */
+  size_t merge( void );
+  
+  /**
+   * Dead code elimination: remove the instructions of the main task whose
+   * results are neither used by an element with side effects (e.g. a send
+   * or a jump) nor needed for one of the @p observed variables or the state.
+   * The names of their results are removed, as they aren't updated any more.
+   * 
+   * @return the number of removed instructions
+   */
+  size_t eliminate( const std::vector<std::string>& observed );
+  
+  /**
+   * Register allocation: the temporary variables of the main task - that
+   * are always written before they are read in a cycle - share their slots
+   * with the temporaries that aren't live at the same time.
+   * The slots are packed at the end of the variables, the hottest first. The
+   * temporaries can't be accessed by their name afterwards, so the
+   * @p pinned variables keep their own slot, as well as the imported ones
+   * and all that carry a state - marked or read before written - or are
+   * used by the init.
+   * 
+   * @return the number of saved slots
+   */
+  size_t allocate( const std::vector<std::string>& pinned );
+  
+  /**
+   * Find the dependencies between the blocks of the main task, marked by
+   * LogicEngine::markStartOfBlock(), for the incremental run: a block has
+   * to run when a changed import or the time since the last run of its
+   * group is read by it or when a block that it reads from has run.
+   * A block that reads the result of another rate group only runs with its
+   * own group and sees the last result then.
+   * This has to be the last pass as the others are changing the blocks.
+   * 
+   * @return the number of blocks, 0 when the main task always has to run as
+   *         a whole, e.g. because of an element with unknown access
+   */
+  size_t dependencies( void );
+  
+private:
+  LogicEngine& le;
+  
+  /**
+   * Create the element for the @p instruction in the @p owner, the reverse
+   * of lower() - or nullptr for a CALL.
+   */
+  static LogicElement_Generic* raise( LogicEngine* const owner, const ByteCode::instruction_t& instruction );
+  
+  /**
+   * An operand of an instruction.
+   */
+  typedef ByteCode::operand_t ByteCode::instruction_t::* operand_t;
+  
+  /**
+   * The variables an instruction reads and writes.
+   */
+  struct access_t
+  {
+    std::vector<raw_offset_t> reads;
+    std::vector<raw_offset_t> writes;
+    std::vector<operand_t> operands; ///< the operands that are variables, not for CALL
+    bool known;  ///< false when the instruction might read and write anything
+    bool pure;   ///< the only effect is the single write calculated of the reads
+    bool effect; ///< the instruction has side effects, e.g. jumps or sends
+  };
+  
+  /**
+   * Return the access of all instructions in @p code, lowered from the
+   * elements of the LogicEngine.
+   */
+  std::vector<access_t> analyze( const std::vector<ByteCode::instruction_t>& code ) const;
+  
+  /**
+   * Return the variables that are written from outside of the logic, i.e.
+   * the imported variables and the times since the last run of the groups.
+   */
+  std::vector<raw_offset_t> external( void ) const;
+  
+  /**
+   * Return the superinstruction for @p first followed by @p second, created
+   * in the @p owner, or nullptr when there is none.
+   */
+  static LogicElement_Generic* fuse( LogicEngine* const owner,
+                                     const ByteCode::instruction_t& first, 
+                                     const ByteCode::instruction_t& second );
+  
+  /**
+   * Lower all elements of the LogicEngine.
+   */
+  std::vector<ByteCode::instruction_t> lower( void ) const;
+  
+  /**
+   * Return for each element (and the end) whether it is the target of a jump
+   * or the start of the main task or of a rate group, i.e. whether the
+   * instruction pointer can get there from anywhere else than the element
+   * before.
+   */
+  std::vector<bool> entryPoints( void ) const;
+  
+  /**
+   * Return the sorted starts of all blocks and rate groups of the main task.
+   */
+  std::vector<size_t> boundaries( void ) const;
+  
+  /**
+   * Replace the elements of the LogicEngine by @p elements.
+   * @p newIndex maps the index of each old element (and the end) to the
+   * index of the element that replaces it, @p origin maps each new element
+   * to the old index that its jump offset was relative to.
+   * The jump offsets, the start of the main task and of the blocks are
+   * updated accordingly.
+   * NOTE: the replaced elements have to be deleted by the caller.
+   */
+  void replace( const std::vector<LogicElement_Generic*>& elements,
+                const std::vector<size_t>& newIndex,
+                const std::vector<size_t>& origin );
+};
+
+#endif // OPTIMIZER_HPP
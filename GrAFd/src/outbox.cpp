@@ -0,0 +1,131 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "outbox.hpp"
+
+#include "logger.hpp"
+
+constexpr std::chrono::milliseconds Outbox::replyInterval; // give it a home
+
+Outbox::Outbox( zmq::context_t& context, const std::string& endpoint )
+: head( new node_t ), dealer( context, ZMQ_DEALER ), requests( 0 ), 
+  running( true ), idle( false )
+{
+  tail = head;
+  dealer.connect( endpoint.c_str() );
+  thread = std::thread( &Outbox::loop, this );
+}
+
+Outbox::~Outbox()
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    running = false;
+  }
+  wake.notify_one();
+  thread.join();
+  
+  while( nullptr != tail )
+  {
+    node_t* next = tail->next;
+    delete tail;
+    tail = next;
+  }
+}
+
+void Outbox::push( batch_t&& batch )
+{
+  node_t* node = new node_t;
+  node->batch = std::move( batch );
+  node_t* previous = head.exchange( node );
+  previous->next.store( node, std::memory_order_release );
+  
+  if( idle )
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    wake.notify_one();
+  }
+}
+
+bool Outbox::pop( batch_t& batch )
+{
+  node_t* next = tail->next.load( std::memory_order_acquire );
+  if( nullptr == next )
+    return false;
+  
+  // the node becomes the new dummy
+  batch = std::move( next->batch );
+  delete tail;
+  tail = next;
+  return true;
+}
+
+void Outbox::loop( void )
+{
+  batch_t batch;
+  for(;;)
+  {
+    drainReplies();
+    
+    if( pop( batch ) )
+    {
+      send( batch );
+      batch.clear();
+      continue;
+    }
+    
+    if( !running )
+      break;
+    
+    idle = true;
+    {
+      std::unique_lock<std::mutex> lock( mutex );
+      wake.wait_for( lock, replyInterval, [this]{
+        return !running || nullptr != tail->next.load( std::memory_order_acquire ); 
+      });
+    }
+    idle = false;
+  }
+  
+  // the replies of the last requests aren't needed anymore
+  int linger = 0;
+  dealer.setsockopt( ZMQ_LINGER, &linger, sizeof( linger ) );
+}
+
+void Outbox::send( const batch_t& batch )
+{
+  if( batch.empty() )
+    return;
+  
+  // the empty delimiter, like a REQ socket would send it
+  zmq::message_t delimiter;
+  dealer.send( delimiter, ZMQ_SNDMORE );
+  for( size_t i = 0; i < batch.size(); ++i )
+  {
+    logger( Logger::ALL ) << "sending to '" << batch[i]->getDestination() << "';\n"; logger.show();
+    batch[i]->send( dealer, batch[i]->getIndex(), i + 1 == batch.size() );
+  }
+  ++requests;
+}
+
+void Outbox::drainReplies( void )
+{
+  zmq::message_t reply;
+  while( dealer.recv( &reply, ZMQ_DONTWAIT ) )
+    ; // nothing to do, each frame is just consumed
+}
@@ -0,0 +1,125 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OUTBOX_HPP
+#define OUTBOX_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+#include "globals.h"
+#include "message.hpp"
+
+/**
+ * The Outbox sends the messages of the LogicEngines to the logicd.
+ * 
+ * The messages of one run are pushed as one batch to a lock free queue,
+ * so a run never waits for the logicd. A thread of its own takes the
+ * batches from the queue and sends each one as a single multipart request
+ * over a DEALER socket - without waiting for the reply of the request
+ * before, the replies are only consumed.
+ */
+class Outbox
+{
+public:
+  /**
+   * The messages of one run.
+   */
+  typedef std::vector<LogicMessage::shared_ptr> batch_t;
+  
+  /**
+   * Constructor - connect to the logicd at @p endpoint and start the thread.
+   */
+  Outbox( zmq::context_t& context, const std::string& endpoint );
+  Outbox( const Outbox& ) = delete; // no copy
+  
+  /**
+   * Destructor - send the remaining batches and stop the thread.
+   */
+  ~Outbox();
+  
+  /**
+   * Queue the @p batch to be sent - from any thread, without waiting.
+   */
+  void push( batch_t&& batch );
+  
+  /**
+   * Return the number of requests that were sent.
+   */
+  size_t sent( void ) const
+  {
+    return requests;
+  }
+  
+private:
+  /**
+   * A node of the queue. The first node is a dummy, its successor holds
+   * the oldest batch.
+   */
+  struct node_t
+  {
+    std::atomic<node_t*> next;
+    batch_t batch;
+    node_t() : next( nullptr ) {}
+  };
+  
+  std::atomic<node_t*> head; ///< the newest node, where the producers append
+  node_t* tail;              ///< the dummy node, only used by the thread
+  
+  zmq::socket_t dealer;
+  std::atomic<size_t> requests;
+  
+  std::atomic<bool> running;
+  std::atomic<bool> idle;    ///< the thread is waiting for a batch
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::thread thread;
+  
+  /**
+   * How long the idle thread waits before it looks at the replies again.
+   */
+  static constexpr std::chrono::milliseconds replyInterval{ 100 };
+  
+  /**
+   * The loop of the thread.
+   */
+  void loop( void );
+  
+  /**
+   * Take the oldest batch from the queue into @p batch.
+   * @return false when the queue is empty
+   */
+  bool pop( batch_t& batch );
+  
+  /**
+   * Send the @p batch as one request.
+   */
+  void send( const batch_t& batch );
+  
+  /**
+   * Consume all replies that are already there.
+   */
+  void drainReplies( void );
+};
+
+#endif // OUTBOX_HPP
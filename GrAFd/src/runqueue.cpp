@@ -0,0 +1,58 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runqueue.hpp"
+
+#include <algorithm>
+
+RunQueue::RunQueue( boost::asio::io_service& io_service, const resume_t& resume )
+: io_service( io_service ), resume( resume ), sequence( 0 )
+{}
+
+void RunQueue::yield( LogicEngine* le )
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    waiting.push_back( { le->getPriority(), sequence++, le } );
+    std::push_heap( waiting.begin(), waiting.end() );
+  }
+  
+  // the logic that is continued is chosen when the handler runs, so all
+  // logics that yielded till then compete by their priority
+  io_service.post( [this](){ next(); } );
+}
+
+size_t RunQueue::size( void )
+{
+  std::lock_guard<std::mutex> lock( mutex );
+  return waiting.size();
+}
+
+void RunQueue::next( void )
+{
+  LogicEngine* le;
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    if( waiting.empty() )
+      return;
+    std::pop_heap( waiting.begin(), waiting.end() );
+    le = waiting.back().le;
+    waiting.pop_back();
+  }
+  resume( le );
+}
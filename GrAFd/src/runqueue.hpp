@@ -0,0 +1,99 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RUNQUEUE_HPP
+#define RUNQUEUE_HPP
+
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <boost/asio.hpp>
+
+#include "logicengine.hpp"
+
+/**
+ * The RunQueue continues the runs of the LogicEngines that used up their
+ * budget, see LogicEngine::setYieldHandler(). The suspended logics are
+ * ordered by their priority, the one with the highest priority is
+ * continued first and logics of the same priority take turns. So a long
+ * running logic can't hold up the logics that are more important.
+ */
+class RunQueue
+{
+public:
+  /**
+   * The function that continues the run of a LogicEngine, e.g. by queuing
+   * it to the worker.
+   */
+  typedef std::function<void( LogicEngine* )> resume_t;
+  
+  /**
+   * Constructor - the logics are taken from the queue by the @p io_service
+   * and passed to @p resume.
+   */
+  RunQueue( boost::asio::io_service& io_service, const resume_t& resume );
+  RunQueue( const RunQueue& ) = delete; // no copy
+  
+  /**
+   * Queue the suspended LogicEngine @p le to be continued after the logics
+   * of a higher priority and the ones of the same priority that are
+   * already waiting.
+   * This is the yieldHandler of the LogicEngines, it may be called by any
+   * thread.
+   */
+  void yield( LogicEngine* le );
+  
+  /**
+   * Return the number of waiting logics.
+   */
+  size_t size( void );
+  
+private:
+  /**
+   * A waiting logic.
+   */
+  struct entry_t
+  {
+    int priority;
+    unsigned long long sequence; ///< the order of arrival
+    LogicEngine* le;
+    
+    /**
+     * The order of the heap, the highest priority and then the oldest
+     * entry is at the top.
+     */
+    bool operator<( const entry_t& other ) const
+    {
+      return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+    }
+  };
+  
+  boost::asio::io_service& io_service;
+  resume_t resume;
+  std::mutex mutex;               ///< protects waiting and sequence
+  std::vector<entry_t> waiting;   ///< a heap of the waiting logics
+  unsigned long long sequence;
+  
+  /**
+   * Continue the logic at the top of the queue - done in the thread of the
+   * io_service, once for each yield().
+   */
+  void next( void );
+};
+
+#endif // RUNQUEUE_HPP
@@ -0,0 +1,139 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "snapshot.hpp"
+
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "logger.hpp"
+
+Snapshot::Snapshot( uint64_t layout, size_t size, const table_t& table, const std::string& _shmName )
+: header( nullptr ), data( nullptr ), mapSize( 0 ), shmName( _shmName )
+{
+  // the names follow the entries, the variables start aligned after them
+  size_t names = 0;
+  for( auto variable = table.cbegin(); variable != table.cend(); ++variable )
+    names += variable->name.length() + 1;
+  const size_t start = ( sizeof( header_t ) + table.size() * sizeof( entry_t ) + names + alignof( uint64_t ) - 1 )
+                     & ~( alignof( uint64_t ) - 1 );
+  const size_t total = start + size;
+  void* memory = nullptr;
+  
+  if( !shmName.empty() )
+  {
+    const int segment = shm_open( shmName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if( -1 != segment && 0 == ftruncate( segment, total ) )
+    {
+      memory = mmap( nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, segment, 0 );
+      if( MAP_FAILED == memory )
+        memory = nullptr;
+      else
+        mapSize = total;
+    }
+    if( -1 != segment )
+      close( segment );
+    
+    if( nullptr == memory )
+    {
+      logger( Logger::WARN ) << "Snapshot: can't export '" << shmName << "', keeping it private\n"; logger.show();
+      shm_unlink( shmName.c_str() );
+    }
+  }
+  
+  if( nullptr == memory )
+    memory = ::operator new( total );
+  
+  raw_t* const base = static_cast<raw_t*>( memory );
+  std::memset( base, 0, start );
+  entry_t* const entries = reinterpret_cast<entry_t*>( base + sizeof( header_t ) );
+  size_t name = sizeof( header_t ) + table.size() * sizeof( entry_t );
+  for( size_t i = 0; i < table.size(); ++i )
+  {
+    entries[i].offset = table[i].offset;
+    entries[i].name   = name;
+    entries[i].type   = table[i].type;
+    std::memcpy( base + name, table[i].name.c_str(), table[i].name.length() + 1 );
+    name += table[i].name.length() + 1;
+  }
+  
+  header = new( memory ) header_t;
+  header->sequence = 0;
+  header->entries  = table.size();
+  header->layout   = layout;
+  header->size     = size;
+  header->data     = start;
+  data = base + start;
+  std::memset( data, 0, size );
+}
+
+Snapshot::~Snapshot()
+{
+  header->~header_t();
+  if( 0 != mapSize )
+  {
+    munmap( header, mapSize );
+    shm_unlink( shmName.c_str() );
+  }
+  else
+    ::operator delete( header );
+}
+
+Snapshot::table_t Snapshot::table( void ) const
+{
+  const raw_t* const base = reinterpret_cast<const raw_t*>( header );
+  const entry_t* const entries = reinterpret_cast<const entry_t*>( base + sizeof( header_t ) );
+  table_t table;
+  for( size_t i = 0; i < header->entries; ++i )
+  {
+    const variable_t variable = { reinterpret_cast<const char*>( base + entries[i].name ), entries[i].offset, 
+                                  static_cast<variableType::type>( entries[i].type ) };
+    table.push_back( variable );
+  }
+  return table;
+}
+
+void Snapshot::publish( const raw_t* const variables )
+{
+  const uint32_t sequence = header->sequence.load( std::memory_order_relaxed );
+  header->sequence.store( sequence + 1, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_release );
+  
+  std::memcpy( data, variables, header->size );
+  
+  header->sequence.store( sequence + 2, std::memory_order_release );
+}
+
+void Snapshot::read( raw_t* const variables ) const
+{
+  for(;;)
+  {
+    const uint32_t before = header->sequence.load( std::memory_order_acquire );
+    if( before & 1 )
+      continue; // publish() is just copying
+    
+    std::memcpy( variables, data, header->size );
+    
+    std::atomic_thread_fence( std::memory_order_acquire );
+    if( header->sequence.load( std::memory_order_relaxed ) == before )
+      return;
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+#include "globals.h"
+#include "variabletype.hpp"
+
+/**
+ * A Snapshot is a copy of the variables of a LogicEngine that is published
+ * after each run, so that any thread can read consistent values while the
+ * logic keeps running.
+ * 
+ * It's a sequence lock: the sequence is odd while publish() copies the
+ * variables, a reader retries when it has changed meanwhile. So the logic
+ * never waits for a reader.
+ * The Snapshot can live in a shared memory segment of its own, then other
+ * processes can map it read only and follow the same protocol. The segment
+ * describes itself: the header_t is followed by an entry_t for each
+ * variable, then by their names - each terminated by '\0' - and then, at
+ * header_t::data, by the variables.
+ */
+class Snapshot
+{
+public:
+  /**
+   * The start of the memory, followed by the variables.
+   */
+  struct header_t
+  {
+    std::atomic<uint32_t> sequence; ///< odd while the variables are written
+    uint32_t entries;               ///< the number of entry_t after the header
+    uint64_t layout;                ///< LogicEngine::layoutKey()
+    uint64_t size;                  ///< the bytes of the variables
+    uint64_t data;                  ///< the start of the variables, counted from the header
+  };
+  
+  /**
+   * The description of a variable in the memory.
+   */
+  struct entry_t
+  {
+    uint64_t offset;    ///< the place in the variables
+    uint32_t name;      ///< the start of the name, counted from the header
+    uint8_t  type;      ///< the variableType::type
+    uint8_t  reserved[3];
+  };
+  
+  /**
+   * A variable of the table that is written to the memory.
+   */
+  struct variable_t
+  {
+    std::string        name;
+    size_t             offset; ///< the place in the variables
+    variableType::type type;
+  };
+  typedef std::vector<variable_t> table_t;
+  
+  /**
+   * Constructor - for @p size bytes of variables with the layout @p layout
+   * that are described by the @p table.
+   * When @p shmName isn't empty it's exported as the shared memory segment
+   * of that name, e.g. "/GrAFd.G1".
+   */
+  Snapshot( uint64_t layout, size_t size, const table_t& table, const std::string& shmName = "" );
+  Snapshot( const Snapshot& ) = delete; // no copy
+  
+  /**
+   * Destructor - the shared memory segment is removed.
+   */
+  ~Snapshot();
+  
+  /**
+   * Copy the @p variables into the snapshot.
+   * NOTE: only one thread at a time may publish, i.e. the logic itself.
+   */
+  void publish( const raw_t* const variables );
+  
+  /**
+   * Copy the variables of the last publish() to @p variables - from any
+   * thread.
+   */
+  void read( raw_t* const variables ) const;
+  
+  /**
+   * Return the bytes of the variables.
+   */
+  size_t size( void ) const
+  {
+    return header->size;
+  }
+  
+  /**
+   * Return the table of the variables, as it's written in the memory.
+   */
+  table_t table( void ) const;
+  
+private:
+  header_t* header;
+  raw_t*    data;
+  size_t    mapSize;      ///< the size of the shared memory, 0 without
+  const std::string shmName;
+};
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,149 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "taskpool.hpp"
+
+TaskPool::TaskPool( size_t threads )
+: queued( 0 ), stopping( false )
+{
+  for( size_t i = 0; i <= threads; ++i )
+    queues.emplace_back( new queue_t );
+  for( size_t i = 1; i <= threads; ++i )
+    this->threads.emplace_back( &TaskPool::loop, this, i );
+}
+
+TaskPool::~TaskPool()
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    stopping = true;
+  }
+  wake.notify_all();
+  for( auto t = threads.begin(); t != threads.end(); ++t )
+    t->join();
+}
+
+void TaskPool::run( const graph_t& followers, const std::vector<bool>& selected, const task_t& task )
+{
+  const size_t count = followers.size();
+  if( 0 == count )
+    return;
+  
+  run_t current{ followers, selected, task, std::unique_ptr<std::atomic<size_t>[]>( new std::atomic<size_t>[ count ] ), {} };
+  for( size_t i = 0; i < count; ++i )
+    current.waiting[i] = 0;
+  for( size_t i = 0; i < count; ++i )
+    for( auto f = followers[i].cbegin(); f != followers[i].cend(); ++f )
+      ++current.waiting[ *f ];
+  current.remaining = count;
+  
+  // the tasks without predecessor are spread over all queues - found before
+  // the first is queued, as the running tasks count the others down
+  std::vector<size_t> ready;
+  for( size_t i = 0; i < count; ++i )
+    if( 0 == current.waiting[i] )
+      ready.push_back( i );
+  for( size_t i = 0; i < ready.size(); ++i )
+    push( i % queues.size(), entry_t( &current, ready[i] ) );
+  
+  entry_t entry;
+  while( next( 0, &current, entry ) )
+    execute( 0, entry );
+}
+
+void TaskPool::loop( size_t self )
+{
+  entry_t entry;
+  while( next( self, nullptr, entry ) )
+    execute( self, entry );
+}
+
+bool TaskPool::next( size_t self, const run_t* current, entry_t& entry )
+{
+  for(;;)
+  {
+    if( current && 0 == current->remaining )
+      return false;
+    if( take( self, entry ) )
+      return true;
+    
+    // queued only grows and a run only finishes while the mutex is held, so
+    // the wake up can't be missed
+    std::unique_lock<std::mutex> lock( mutex );
+    wake.wait( lock, [this, current]{
+      return stopping || 0 < queued || ( current && 0 == current->remaining );
+    });
+    if( stopping && !current )
+      return false;
+  }
+}
+
+void TaskPool::execute( size_t self, const entry_t& entry )
+{
+  run_t& current = *entry.first;
+  const size_t index = entry.second;
+  
+  if( current.selected[ index ] )
+    current.task( index );
+  
+  // the followers are queued before the task counts as finished, so the
+  // run can't end while there is still something to do
+  const std::vector<size_t>& next = current.followers[ index ];
+  for( auto f = next.cbegin(); f != next.cend(); ++f )
+    if( 1 == current.waiting[ *f ]-- )
+      push( self, entry_t( &current, *f ) );
+  
+  // the caller of run() might return at once, current mustn't be used then
+  if( 1 == current.remaining-- )
+  {
+    {
+      std::lock_guard<std::mutex> lock( mutex );
+    }
+    wake.notify_all();
+  }
+}
+
+bool TaskPool::take( size_t self, entry_t& entry )
+{
+  {
+    queue_t& own = *queues[ self ];
+    std::lock_guard<std::mutex> lock( own.mutex );
+    if( !own.tasks.empty() )
+    {
+      entry = own.tasks.back();
+      own.tasks.pop_back();
+      --queued;
+      return true;
+    }
+  }
+  
+  for( size_t i = 1; i < queues.size(); ++i )
+  {
+    queue_t& other = *queues[ ( self + i ) % queues.size() ];
+    std::lock_guard<std::mutex> lock( other.mutex );
+    if( !other.tasks.empty() )
+    {
+      entry = other.tasks.front();
+      other.tasks.pop_front();
+      --queued;
+      return true;
+    }
+  }
+  
+  return false;
+}
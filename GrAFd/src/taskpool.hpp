@@ -0,0 +1,159 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TASKPOOL_HPP
+#define TASKPOOL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+/**
+ * The TaskPool runs the tasks of a directed acyclic graph in parallel.
+ * 
+ * Each thread has its own queue of tasks that are ready to run. It takes
+ * the task that it made ready last and steals the oldest one of another
+ * queue when its own is empty - and sleeps when all are empty. A task gets
+ * ready when all tasks before it have finished, counted down in a counter
+ * per task.
+ * The thread that calls run() takes part and returns when all tasks are
+ * finished, so everything written by the tasks is visible afterwards.
+ * Several runs can be done at the same time, e.g. by different graphs,
+ * their tasks share the threads.
+ */
+class TaskPool
+{
+public:
+  /**
+   * For each task the tasks that have to wait for it.
+   */
+  typedef std::vector<std::vector<size_t>> graph_t;
+  
+  /**
+   * The function that runs a task, called with the index of the task.
+   */
+  typedef std::function<void( size_t )> task_t;
+  
+  /**
+   * Constructor - start @p threads additional threads.
+   */
+  explicit TaskPool( size_t threads );
+  TaskPool( const TaskPool& ) = delete; // no copy
+  
+  /**
+   * Destructor - stop the threads.
+   */
+  ~TaskPool();
+  
+  /**
+   * Return the number of threads that run the tasks, including the caller.
+   */
+  size_t size( void ) const
+  {
+    return queues.size();
+  }
+  
+  /**
+   * Run @p task for each task whose @p selected entry is true, but not
+   * before all tasks that have it in their @p followers are finished. The
+   * tasks that aren't selected only pass their finish on to their followers.
+   * NOTE: the caller might run tasks of a concurrent run as well.
+   */
+  void run( const graph_t& followers, const std::vector<bool>& selected, const task_t& task );
+  
+private:
+  /**
+   * A run, it lives on the stack of the caller of run().
+   */
+  struct run_t
+  {
+    const graph_t& followers;
+    const std::vector<bool>& selected;
+    const task_t& task;
+    std::unique_ptr<std::atomic<size_t>[]> waiting; ///< the number of unfinished tasks before each task
+    std::atomic<size_t> remaining;                  ///< the number of unfinished tasks
+  };
+  
+  /**
+   * A task that is ready: its run and its index.
+   */
+  typedef std::pair<run_t*, size_t> entry_t;
+  
+  /**
+   * The tasks that are ready to run by one thread.
+   */
+  struct queue_t
+  {
+    std::mutex mutex;
+    std::deque<entry_t> tasks;
+  };
+  
+  std::vector<std::unique_ptr<queue_t>> queues; ///< the queue of each thread, the first is the callers'
+  std::vector<std::thread> threads;
+  std::mutex mutex;                             ///< held when queued grows, a run finishes or on stopping
+  std::condition_variable wake;                 ///< notified when one of these happened
+  std::atomic<size_t> queued;                   ///< the number of tasks in all queues
+  bool stopping;
+  
+  /**
+   * The loop of the additional thread @p self.
+   */
+  void loop( size_t self );
+  
+  /**
+   * Take the next task for thread @p self, waiting till there is one.
+   * @return false when the @p current run of the caller is finished - or
+   *         the pool is stopping
+   */
+  bool next( size_t self, const run_t* current, entry_t& entry );
+  
+  /**
+   * Run the task @p entry as thread @p self and queue its followers that
+   * got ready.
+   */
+  void execute( size_t self, const entry_t& entry );
+  
+  /**
+   * Put the ready task @p entry in the queue of thread @p self.
+   */
+  void push( size_t self, const entry_t& entry )
+  {
+    {
+      // counted first, so queued is never less than the tasks in the queues
+      std::lock_guard<std::mutex> lock( mutex );
+      ++queued;
+      std::lock_guard<std::mutex> queueLock( queues[ self ]->mutex );
+      queues[ self ]->tasks.push_back( entry );
+    }
+    wake.notify_all();
+  }
+  
+  /**
+   * Take a task for thread @p self from its own queue - or steal one.
+   * @return false when all queues are empty
+   */
+  bool take( size_t self, entry_t& entry );
+};
+
+#endif // TASKPOOL_HPP
@@ -0,0 +1,109 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "variablearena.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+
+namespace
+{
+  std::mutex mutex;
+  std::map<size_t, std::vector<raw_t*>> freed; // released stores by size
+  raw_t* next = nullptr;                      // the free part of the last block
+  size_t remaining = 0;
+  size_t usedBytes = 0;
+  size_t reservedBytes = 0;
+  
+  /**
+   * Take @p size bytes from the system.
+   */
+  raw_t* takeBlock( size_t size )
+  {
+    void* block;
+    if( 0 != posix_memalign( &block, VariableArena::blockSize, size ) )
+      throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    madvise( block, size, MADV_HUGEPAGE );
+#endif
+    reservedBytes += size;
+    return static_cast<raw_t*>( block );
+  }
+}
+
+raw_t* VariableArena::allocate( size_t size )
+{
+  size = roundUp( size );
+  std::lock_guard<std::mutex> lock( mutex );
+  
+  raw_t* store;
+  auto reuse = freed.find( size );
+  if( freed.end() != reuse && !reuse->second.empty() )
+  {
+    store = reuse->second.back();
+    reuse->second.pop_back();
+  }
+  else if( size > blockSize / 4 )
+  {
+    // large stores get a block of their own
+    store = takeBlock( size );
+  }
+  else
+  {
+    if( remaining < size )
+    {
+      next = takeBlock( blockSize );
+      remaining = blockSize;
+    }
+    store = next;
+    next += size;
+    remaining -= size;
+  }
+  
+  usedBytes += size;
+  std::memset( store, 0, size );
+  return store;
+}
+
+void VariableArena::release( raw_t* store, size_t size )
+{
+  if( nullptr == store )
+    return;
+  
+  size = roundUp( size );
+  std::lock_guard<std::mutex> lock( mutex );
+  freed[ size ].push_back( store );
+  usedBytes -= size;
+}
+
+size_t VariableArena::used( void )
+{
+  std::lock_guard<std::mutex> lock( mutex );
+  return usedBytes;
+}
+
+size_t VariableArena::reserved( void )
+{
+  std::lock_guard<std::mutex> lock( mutex );
+  return reservedBytes;
+}
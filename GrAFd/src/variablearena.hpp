@@ -0,0 +1,78 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VARIABLEARENA_HPP
+#define VARIABLEARENA_HPP
+
+#include <cstddef>
+
+#include "globals.h"
+
+/**
+ * The VariableArena holds the variable stores of all LogicEngines.
+ * 
+ * The memory is taken in large blocks, aligned to (and advised as) a huge
+ * page, and the stores are cut from them aligned to a cache line. So many
+ * small stores lie contiguously and use only the cache lines they really
+ * need. A released store is kept for the next store of the same size, the
+ * blocks are never given back to the system.
+ */
+class VariableArena
+{
+public:
+  /**
+   * The alignment of each store.
+   */
+  static const size_t cacheLine = 64;
+  
+  /**
+   * The size of a block - a huge page.
+   */
+  static const size_t blockSize = 2 * 1024 * 1024;
+  
+  /**
+   * Return a zeroed store of @p size bytes.
+   */
+  static raw_t* allocate( size_t size );
+  
+  /**
+   * Give back the @p store of @p size bytes that was returned by allocate().
+   */
+  static void release( raw_t* store, size_t size );
+  
+  /**
+   * Return the number of bytes of all stores in use.
+   */
+  static size_t used( void );
+  
+  /**
+   * Return the number of bytes taken from the system.
+   */
+  static size_t reserved( void );
+  
+  /**
+   * Return the @p size rounded up to a full cache line, i.e. the memory
+   * really used by a store of @p size bytes.
+   */
+  static size_t roundUp( size_t size )
+  {
+    return ( size + cacheLine - 1 ) & ~( cacheLine - 1 );
+  }
+};
+
+#endif // VARIABLEARENA_HPP
@@ -2,8 +2,30 @@
 #define BOOST_TEST_MODULE LogicEngine
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "json.hpp"
 #include "logicengine.hpp"
 #include "logic_elements.hpp"
+#include "optimizer.hpp"
+#include "batchengine.hpp"
+#include "variablearena.hpp"
+#include "taskpool.hpp"
+#include "outbox.hpp"
+#include "runqueue.hpp"
+#include "awaiter.hpp"
+#include "checkpoint.hpp"
+#include "snapshot.hpp"
+#include "graphcache.hpp"
+#include "graphlibindex.hpp"
 
 Logger logger;
 zmq::socket_t *sender;
@@ -19,12 +41,14 @@ BOOST_AUTO_TEST_CASE( test1 )
 }
 
 /**
- * test of a full program
+ * Fill the LogicEngine @p le with a full program: count the points of the
+ * Mandelbrot set. When @p start is given the constants are the
+ * initialisation and it's set to the variable of the first x, so each run
+ * can start elsewhere.
+ * @return the offset of the variable holding the result
  */
-BOOST_AUTO_TEST_CASE( total )
+static raw_offset_t setupMandelbrot( LogicEngine& le, raw_offset_t* start = nullptr )
 {
-  LogicEngine le(200,999);
-  
   typedef float flt;
   raw_offset_t min_x  = le.registerVariable<flt>( "min_x"  );
   raw_offset_t max_x  = le.registerVariable<flt>( "max_x"  );
@@ -58,6 +82,11 @@ BOOST_AUTO_TEST_CASE( total )
   le.addElement( new LogicElement_Const<int>( one   ,  1   ) );
   le.addElement( new LogicElement_Const<flt>( two   ,  2.0 ) );
   le.addElement( new LogicElement_Const<flt>( four  ,  4.0 ) );
+  if( nullptr != start )
+  {
+    *start = min_x;
+    le.markStartOfLogic();
+  }
   
   //LogicElement_Generic** startPoint = le.nextElementPosition();
   
@@ -113,8 +142,1190 @@ BOOST_AUTO_TEST_CASE( total )
   offsetTostartForLoops = le.nextElementPosition() - x_LoopStart;
   le.addElement( new LogicElement_JumpTrue<int>( -offsetTostartForLoops, tmpRel ) ); // if x <= max_x continung for(x)
   
+  return totCnt;
+}
+
+/**
+ * Run the Mandelbrot program @p runs times on the @p backend, optionally 
+ * @p fused to superinstructions.
+ * @return the best time of a single run in milliseconds
+ */
+static double runMandelbrot( LogicEngine::backend_t backend, int runs, int& result, bool fused = false )
+{
+  LogicEngine le(200,999);
+  raw_offset_t totCnt = setupMandelbrot( le );
+  le.setBackend( backend );
+  if( fused )
+  {
+    Optimizer optimizer( le );
+    BOOST_CHECK( optimizer.fuse() == 6 );
+  }
+  
+  double best = std::numeric_limits<double>::max();
+  for( int i = 0; i < runs; i++ )
+  {
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    auto start = std::chrono::steady_clock::now();
+    le.run();
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    BOOST_REQUIRE( le.stopLogic() );
+    best = std::min( best, duration.count() );
+  }
+  
+  result = le.read<int>(totCnt);
+  return best;
+}
+
+/**
+ * test of a full program
+ */
+BOOST_AUTO_TEST_CASE( total )
+{
+  int virtualResult, byteCodeResult;
+  runMandelbrot( LogicEngine::VIRTUAL , 1, virtualResult  );
+  runMandelbrot( LogicEngine::BYTECODE, 1, byteCodeResult );
+  
+  std::cout << virtualResult << std::endl;
+  BOOST_CHECK( virtualResult  == 15459 );
+  BOOST_CHECK( byteCodeResult == 15459 );
+}
+
+/**
+ * test of the superinstructions with the full program
+ */
+BOOST_AUTO_TEST_CASE( fusion )
+{
+  int virtualResult, byteCodeResult;
+  runMandelbrot( LogicEngine::VIRTUAL , 1, virtualResult , true );
+  runMandelbrot( LogicEngine::BYTECODE, 1, byteCodeResult, true );
+  
+  BOOST_CHECK( virtualResult  == 15459 );
+  BOOST_CHECK( byteCodeResult == 15459 );
+}
+
+/**
+ * benchmark of the backends with the full program
+ */
+BOOST_AUTO_TEST_CASE( benchmark )
+{
+  int result;
+  double virtualTime  = runMandelbrot( LogicEngine::VIRTUAL , 3, result );
+  double byteCodeTime = runMandelbrot( LogicEngine::BYTECODE, 3, result );
+  BOOST_CHECK( result == 15459 );
+  double fusedTime    = runMandelbrot( LogicEngine::BYTECODE, 3, result, true );
+  BOOST_CHECK( result == 15459 );
+  
+  std::cout << "Mandelbrot - virtual: " << virtualTime << " ms, bytecode: " 
+            << byteCodeTime << " ms, speedup: " << virtualTime / byteCodeTime 
+            << ", fused bytecode: " << fusedTime << " ms" << std::endl;
+}
+
+/**
+ * test of running many instances at once, with and without the instances
+ * taking different branches
+ */
+BOOST_AUTO_TEST_CASE( batch )
+{
+  LogicEngine mandelbrot(200,999);
+  raw_offset_t totCnt = setupMandelbrot( mandelbrot );
+  BOOST_REQUIRE( mandelbrot.enableVariables() );
+  BatchEngine mandelbrots( mandelbrot, 16 );
+  mandelbrots.run_init();
+  auto start = std::chrono::steady_clock::now();
+  mandelbrots.run();
+  std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+  std::cout << "Mandelbrot - " << mandelbrots.size() << " instances batched: " 
+            << duration.count() << " ms" << std::endl;
+  for( size_t i = 0; i < mandelbrots.size(); i++ )
+    BOOST_CHECK( mandelbrots.read<int>( i, totCnt ) == 15459 );
+  
+  // each instance starts at another x, so they take different branches
+  // all the time and have to run together again after each
+  raw_offset_t min_x;
+  LogicEngine shifted(200,999);
+  totCnt = setupMandelbrot( shifted, &min_x );
+  BOOST_REQUIRE( shifted.enableVariables() );
+  BatchEngine shifteds( shifted, 16 );
+  shifteds.run_init();
+  for( size_t i = 0; i < shifteds.size(); i++ )
+    shifteds.write<float>( i, min_x, -2.0f + 0.05f * i );
+  start = std::chrono::steady_clock::now();
+  shifteds.run();
+  duration = std::chrono::steady_clock::now() - start;
+  
+  BOOST_REQUIRE( shifted.startLogic() );
+  shifted.run_init();
+  BOOST_REQUIRE( shifted.stopLogic() );
+  start = std::chrono::steady_clock::now();
+  for( size_t i = 0; i < shifteds.size(); i++ )
+  {
+    BOOST_REQUIRE( shifted.enableVariables() && shifted.startLogic() );
+    shifted.write<int>( totCnt, 0 );
+    shifted.write<float>( min_x, -2.0f + 0.05f * i );
+    shifted.run();
+    BOOST_REQUIRE( shifted.stopLogic() );
+    BOOST_CHECK( shifteds.read<int>( i, totCnt ) == shifted.read<int>( totCnt ) );
+  }
+  std::chrono::duration<double, std::milli> single = std::chrono::steady_clock::now() - start;
+  std::cout << "Mandelbrot - " << shifteds.size() << " different instances batched: " 
+            << duration.count() << " ms, one by one: " << single.count() << " ms" << std::endl;
+  
+  // out = in > limit ? in * in : in + one
+  LogicEngine le(20,99);
+  raw_offset_t in     = le.registerVariable<float>( "in"     );
+  raw_offset_t out    = le.registerVariable<float>( "out"    );
+  raw_offset_t limit  = le.registerVariable<float>( "limit"  );
+  raw_offset_t one    = le.registerVariable<float>( "one"    );
+  raw_offset_t tmpRel = le.registerVariable<int  >( "tmpRel" );
+  le.addElement( new LogicElement_Const<float>( limit, 5.0 ) );
+  le.addElement( new LogicElement_Const<float>( one  , 1.0 ) );
+  le.markStartOfLogic();
+  le.addElement( new LogicElement_Rel<int, float>( tmpRel, in, limit, LogicElement_Rel<int, float>::GREATER ) );
+  le.addElement( new LogicElement_JumpTrue<int>( 3, tmpRel ) );
+  le.addElement( new LogicElement_Sum<float>( out, in, one ) );
+  le.addElement( new LogicElement_Jump( 2 ) );
+  le.addElement( new LogicElement_Mul<float>( out, in, in ) );
+  BOOST_REQUIRE( le.enableVariables() );
+  
+  BatchEngine batch( le, 11 );
+  batch.run_init();
+  for( size_t i = 0; i < batch.size(); i++ )
+    batch.write<float>( i, in, i );
+  batch.run();
+  for( size_t i = 0; i < batch.size(); i++ )
+    BOOST_CHECK( batch.read<float>( i, out ) == ( i > 5 ? i * i : i + 1.0f ) );
+  
+  // all instances take the same branch
+  for( size_t i = 0; i < batch.size(); i++ )
+    batch.write<float>( i, in, 10.0f + i );
+  batch.run();
+  for( size_t i = 0; i < batch.size(); i++ )
+    BOOST_CHECK( batch.read<float>( i, out ) == ( 10.0f + i ) * ( 10.0f + i ) );
+  
+  // a graph with instances: each reads the import of its own number
+  LogicEngine room(20,99);
+  raw_offset_t temperature = room.importVariable<float>( "room%i/temperature" );
+  raw_offset_t offset      = room.registerVariable<float>( "offset", 0.5f );
+  raw_offset_t heating     = room.registerVariable<float>( "heating" );
+  room.markStartOfLogic();
+  room.addElement( new LogicElement_Sum<float>( heating, temperature, offset ) );
+  BOOST_REQUIRE( room.enableVariables() );
+  BatchEngine rooms( room, 3 );
+  room.setBatch( &rooms );
+  Snapshot prototype( room.layoutKey(), room.variablesSize(), room.snapshotTable() );
+  room.setSnapshot( &prototype );
+  BOOST_CHECK( LogicEngine::instanceName( "room%i/temperature", 2 ) == "room2/temperature" );
+  for( size_t i = 0; i < rooms.size(); i++ )
+    registry.update( LogicEngine::instanceName( "room%i/temperature", i ), variable_t( 20.0f + i ) );
+  BOOST_REQUIRE( room.startLogic() );
+  BOOST_CHECK( room.scheduleRun() );
+  for( size_t i = 0; i < rooms.size(); i++ )
+  {
+    BOOST_CHECK( rooms.read<float>( i, heating ) == 20.5f + i );
+    BOOST_CHECK( rooms.read<int>( i, temperature + sizeof( float ) ) == MessageRegister::NEW_MSG );
+  }
+  
+  // the prototype isn't published, it has none of the values
+  std::map<std::string, variable_t> values;
+  BOOST_REQUIRE( room.takeSnapshot( values ) );
+  BOOST_CHECK( values.at( "heating" ).getFloat() == 0.0f );
+}
+
+/**
+ * test of constant folding, common subexpression and dead code elimination
+ */
+BOOST_AUTO_TEST_CASE( optimize )
+{
+  LogicEngine le(20,99);
+  raw_offset_t in   = le.importVariable<float>( "in" );
+  raw_offset_t a    = le.registerVariable<float>( "a"    );
+  raw_offset_t b    = le.registerVariable<float>( "b"    );
+  raw_offset_t t    = le.registerVariable<float>( "t"    );
+  raw_offset_t x    = le.registerVariable<float>( "x"    );
+  raw_offset_t y    = le.registerVariable<float>( "y"    );
+  raw_offset_t dead = le.registerVariable<float>( "dead" );
+  raw_offset_t k    = le.registerVariable<float>( "k", 0.5f );    // a parameter
+  raw_offset_t s    = le.registerVariable<float>( "s", 0.0f );
+  raw_offset_t z    = le.registerVariable<float>( "z", 0.0f );
+  le.markState( "s" );
+  le.addElement( new LogicElement_Const<float>( a, 2.0 ) );
+  le.addElement( new LogicElement_Const<float>( b, 3.0 ) );
+  le.markStartOfLogic();
+  le.addElement( new LogicElement_Mul<float>( t, a, b ) );     // constant
+  le.addElement( new LogicElement_Sum<float>( x, in, t ) );
+  le.addElement( new LogicElement_Mul<float>( dead, in, in ) ); // not observed
+  le.addElement( new LogicElement_Sum<float>( y, t, in ) );    // same as x
+  le.addElement( new LogicElement_Mul<float>( s, in, k ) );    // not observed, but state
+  le.addElement( new LogicElement_Mul<float>( z, s, k ) );     // s isn't constant
+  
+  Optimizer optimizer( le );
+  BOOST_CHECK( optimizer.fold() == 5 );
+  BOOST_CHECK( optimizer.merge() == 1 );
+  BOOST_CHECK( optimizer.eliminate( { "x", "y" } ) == 2 );
+  
+  // t is calculated once, the uses of the constants are immediates
+  std::stringstream folded;
+  folded << "const<float>( " << t << ", 6 )\n// mainTask:\n"
+         << "sumconst<float>( " << x << ", " << in << ", 6 )\n"
+         << "move<float>( " << y << ", " << x << " )\n"
+         << "mulconst<float>( " << s << ", " << in << ", 0.5 )\n";
+  BOOST_CHECK( le.export_noGrAF().find( folded.str() ) != std::string::npos );
+  
+  Snapshot snapshot( le.layoutKey(), le.variablesSize(), le.snapshotTable() );
+  le.setSnapshot( &snapshot );
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  le.run_init();
+  BOOST_REQUIRE( le.stopLogic() );
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  le.write<float>( in, 5.0 );
+  le.run();
+  BOOST_REQUIRE( le.stopLogic() );
+  
+  // the removed result isn't shown any more
+  std::map<std::string, variable_t> values;
+  BOOST_REQUIRE( le.takeSnapshot( values ) );
+  BOOST_CHECK( 0 == values.count( "dead" ) );
+  BOOST_CHECK( 0 == values.count( "z" ) );
+  BOOST_CHECK( 1 == values.count( "x" ) );
+  BOOST_CHECK( 1 == values.count( "s" ) );
+  
+  BOOST_CHECK( le.read<float>( t ) == 6.0 );
+  BOOST_CHECK( le.read<float>( x ) == 11.0 );
+  BOOST_CHECK( le.read<float>( y ) == 11.0 );
+  BOOST_CHECK( le.read<float>( dead ) == 0.0 );
+  BOOST_CHECK( le.read<float>( s ) == 2.5 );
+}
+
+/**
+ * test of the register allocation
+ */
+BOOST_AUTO_TEST_CASE( allocate )
+{
+  LogicEngine le(20,99);
+  raw_offset_t flag = le.registerVariable<bool >( "flag" );
+  raw_offset_t a    = le.registerVariable<float>( "a", 2.0f );
+  raw_offset_t b    = le.registerVariable<float>( "b", 3.0f );
+  raw_offset_t c    = le.registerVariable<float>( "c", 1.0f );
+  raw_offset_t t1   = le.registerVariable<float>( "t1"   );
+  raw_offset_t x    = le.registerVariable<float>( "x"    );
+  raw_offset_t t2   = le.registerVariable<float>( "t2"   );
+  raw_offset_t y    = le.registerVariable<float>( "y"    );
+  BOOST_CHECK( flag % alignof( bool ) == 0 && a % alignof( float ) == 0 );
+  
+  le.markStartOfLogic();
+  le.addElement( new LogicElement_Mul<float>( t1, a , b ) );
+  le.addElement( new LogicElement_Sum<float>( x , t1, c ) );
+  le.addElement( new LogicElement_Mul<float>( t2, x , x ) );
+  le.addElement( new LogicElement_Sum<float>( y , t2, c ) );
+  
+  // t1 and t2 share a slot
+  Optimizer optimizer( le );
+  BOOST_CHECK( optimizer.allocate( { "y" } ) == 1 );
+  
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  le.run();
+  BOOST_REQUIRE( le.stopLogic() );
+  BOOST_CHECK( le.read<float>( y ) == 50.0 );
+}
+
+/**
+ * test of the variable store
+ */
+BOOST_AUTO_TEST_CASE( variables )
+{
+  LogicEngine le(20,99);
+  const size_t before = VariableArena::used();
+  raw_offset_t last = 0;
+  for( int i = 0; i < 1000; i++ )
+    last = le.registerVariable<int>( "v" + std::to_string( i ), i );
+  BOOST_CHECK( le.variableMemory() >= last + sizeof( int ) );
+  
+  BOOST_REQUIRE( le.enableVariables() );
+  BOOST_CHECK( le.variableMemory() == VariableArena::roundUp( last + sizeof( int ) ) );
+  BOOST_CHECK( VariableArena::used() == before + le.variableMemory() );
+  BOOST_CHECK( le.read<int>( last ) == 999 );
+  BOOST_CHECK_THROW( le.registerVariable<int>( "late" ), JSON::parseError );
+}
+
+/**
+ * test of the elements in the arena of the LogicEngine
+ */
+BOOST_AUTO_TEST_CASE( elements )
+{
+  LogicEngine le(20,99);
+  raw_offset_t a = le.registerVariable<int>( "a" );
+  raw_offset_t b = le.registerVariable<int>( "b" );
+  LogicElement_Generic* first  = new( &le ) LogicElement_Const<int>( a, 3 );
+  LogicElement_Generic* second = new( &le ) LogicElement_Sum<int>( b, a, a );
+  le.addElement( first  );
+  le.addElement( second );
+  le.addElement( new LogicElement_Sum<int>( b, b, a ) ); // on the heap
+  
+  // the elements are next to each other
+  BOOST_CHECK( le.elementMemory() == ElementArena::chunkSize );
+  BOOST_CHECK( reinterpret_cast<raw_t*>( first ) < reinterpret_cast<raw_t*>( second ) );
+  BOOST_CHECK( reinterpret_cast<raw_t*>( second ) - reinterpret_cast<raw_t*>( first ) < 64 );
+  
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  le.run();
+  BOOST_REQUIRE( le.stopLogic() );
+  BOOST_CHECK( le.read<int>( b ) == 9 );
+}
+
+/**
+ * test of the incremental run, only the changed blocks are run
+ */
+BOOST_AUTO_TEST_CASE( incremental )
+{
+  LogicEngine le(20,99);
+  raw_offset_t in1 = le.importVariable<float>( "incremental/in1" );
+  raw_offset_t in2 = le.importVariable<float>( "incremental/in2" );
+  raw_offset_t x   = le.registerVariable<float>( "x" );
+  raw_offset_t y   = le.registerVariable<float>( "y" );
+  raw_offset_t z   = le.registerVariable<float>( "z" );
+  le.markStartOfLogic();
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Mul<float>( x, in1, in1 ) );
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Sum<float>( y, in2, in2 ) );
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Sum<float>( z, x, x ) );
+  
+  Optimizer optimizer( le );
+  BOOST_CHECK( optimizer.dependencies() == 3 );
+  
+  auto trigger = [&le]()
+  {
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    le.scheduleRun();
+  };
+  
+  // everything runs the first time
+  registry.update( "incremental/in1", variable_t( 2.0f ) );
+  registry.update( "incremental/in2", variable_t( 3.0f ) );
+  trigger();
+  BOOST_CHECK( le.read<float>( z ) == 8.0f );
+  BOOST_CHECK( le.read<float>( y ) == 6.0f );
+  
+  // only the block that reads in2
+  le.write<float>( x, 0.0f );
+  le.write<float>( z, 0.0f );
+  registry.update( "incremental/in2", variable_t( 4.0f ) );
+  trigger();
+  BOOST_CHECK( le.read<float>( y ) == 8.0f );
+  BOOST_CHECK( le.read<float>( x ) == 0.0f );
+  BOOST_CHECK( le.read<float>( z ) == 0.0f );
+  
+  // the block that reads in1 and the one depending on it
+  le.write<float>( y, 0.0f );
+  registry.update( "incremental/in1", variable_t( 1.0f ) );
+  trigger();
+  BOOST_CHECK( le.read<float>( x ) == 1.0f );
+  BOOST_CHECK( le.read<float>( z ) == 2.0f );
+  BOOST_CHECK( le.read<float>( y ) == 0.0f );
+  
+  // nothing changed, nothing runs
+  le.write<float>( z, 0.0f );
+  trigger();
+  BOOST_CHECK( le.read<float>( z ) == 0.0f );
+  BOOST_CHECK( le.getState() == LogicEngine::STOPPED );
+}
+
+/**
+ * test of the rate groups, each is run by its own timer
+ */
+BOOST_AUTO_TEST_CASE( rates )
+{
+  LogicEngine le(20,99);
+  raw_offset_t one = le.registerVariable<float>( "one", 1.0f );
+  raw_offset_t x   = le.registerVariable<float>( "x" );
+  raw_offset_t y   = le.registerVariable<float>( "y" );
+  le.markStartOfLogic();
+  le.markStartOfGroup( 0.05f );
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Sum<float>( x, x, one ) );
+  le.markStartOfGroup( 60.0f );
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Sum<float>( y, y, x ) );
+  BOOST_CHECK( le.groupCount() == 2 );
+  
+  Optimizer optimizer( le );
+  BOOST_CHECK( optimizer.dependencies() == 2 );
+  
+  auto trigger = [&le]( int group )
+  {
+    if( 0 <= group )
+      le.scheduleGroup( group );
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    le.scheduleRun();
+  };
+  
+  // the fast group only
+  trigger( 0 );
+  trigger( 0 );
+  BOOST_CHECK( le.read<float>( x ) == 2.0f );
+  BOOST_CHECK( le.read<float>( y ) == 0.0f );
+  
+  // the slow group sees the last result of the fast one
+  trigger( 1 );
+  BOOST_CHECK( le.read<float>( x ) == 2.0f );
+  BOOST_CHECK( le.read<float>( y ) == 2.0f );
+  
+  // any other trigger, like a message, waits for the timers
+  trigger( -1 );
+  BOOST_CHECK( le.read<float>( x ) == 2.0f );
+  BOOST_CHECK( le.read<float>( y ) == 2.0f );
+  trigger( 0 );
+  trigger( 1 );
+  BOOST_CHECK( le.read<float>( x ) == 3.0f );
+  BOOST_CHECK( le.read<float>( y ) == 5.0f );
+  
+  // a message is new for a group till it has run, even when another group
+  // ran for it before
+  LogicEngine status(20,98);
+  raw_offset_t in   = status.importVariable<float>( "rates/in" );
+  raw_offset_t copy = status.registerVariable<float>( "copy" );
+  raw_offset_t seen = status.registerVariable<int>( "seen" );
+  status.markStartOfLogic();
+  status.markStartOfBlock();
+  status.addElement( new LogicElement_Move<float>( copy, in ) );
+  status.markStartOfGroup( 60.0f );
+  status.markStartOfBlock();
+  status.addElement( new LogicElement_Move<int>( seen, in + sizeof( float ) ) );
+  Optimizer statusOptimizer( status );
+  BOOST_CHECK( statusOptimizer.dependencies() == 2 );
+  
+  auto run = [&status]( int group )
+  {
+    if( 0 <= group )
+      status.scheduleGroup( group );
+    BOOST_REQUIRE( status.enableVariables() && status.startLogic() );
+    status.scheduleRun();
+  };
+  registry.update( "rates/in", variable_t( 1.0f ) );
+  run( -1 );
+  BOOST_CHECK( status.read<float>( copy ) == 1.0f );
+  BOOST_CHECK( status.read<int>( seen ) == 0 );
+  run( 1 );
+  BOOST_CHECK( status.read<int>( seen ) == MessageRegister::NEW_MSG );
+  run( 1 );
+  BOOST_CHECK( status.read<int>( seen ) == MessageRegister::OLD_MSG );
+}
+
+BOOST_AUTO_TEST_CASE( parallel )
+{
+  TaskPool pool( 3 );
+  LogicEngine le(40,99);
+  raw_offset_t in = le.importVariable<float>( "parallel/in" );
+  raw_offset_t w  = le.registerVariable<float>( "w", 1.0f );
+  raw_offset_t y  = le.registerVariable<float>( "y" );
+  raw_offset_t z  = le.registerVariable<float>( "z" );
+  std::vector<raw_offset_t> x;
+  for( int i = 0; i < 8; ++i )
+    x.push_back( le.registerVariable<float>( "x" + std::to_string( i ) ) );
+  le.markStartOfLogic();
+  // reads w before the block below writes it
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Sum<float>( y, w, w ) );
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Mul<float>( w, in, in ) );
+  // independent blocks ...
+  for( int i = 0; i < 8; ++i )
+  {
+    le.markStartOfBlock();
+    le.addElement( new LogicElement_Sum<float>( x[i], in, in ) );
+    le.addElement( new LogicElement_Mul<float>( x[i], x[i], x[i] ) );
+  }
+  // ... joined at the end
+  le.markStartOfBlock();
+  le.addElement( new LogicElement_Move<float>( z, x[0] ) );
+  for( int i = 1; i < 8; ++i )
+    le.addElement( new LogicElement_Sum<float>( z, z, x[i] ) );
+  
+  Optimizer optimizer( le );
+  BOOST_REQUIRE( optimizer.dependencies() == 11 );
+  le.setBackend( LogicEngine::BYTECODE );
+  le.setTaskPool( &pool );
+  
+  for( int run = 1; run <= 50; ++run )
+  {
+    registry.update( "parallel/in", variable_t( float( run ) ) );
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    le.scheduleRun();
+    BOOST_CHECK( le.read<float>( z ) == 8.0f * 4.0f * run * run );
+    BOOST_CHECK( le.read<float>( y ) == 2.0f * ( 1 == run ? 1.0f : float( run - 1 ) * ( run - 1 ) ) );
+    BOOST_CHECK( le.read<float>( w ) == float( run ) * run );
+  }
+  
+  // concurrent runs share the threads, each keeps the order of its tasks
+  const TaskPool::graph_t chain = { { 1 }, { 2 }, { 3 }, {} };
+  const std::vector<bool> all( chain.size(), true );
+  std::vector<std::vector<size_t>> order( 4 );
+  std::vector<std::thread> callers;
+  for( size_t c = 0; c < order.size(); ++c )
+    callers.emplace_back( [&pool, &chain, &all, &order, c]{
+      for( int run = 0; run < 100; ++run )
+        pool.run( chain, all, [&order, c]( size_t t ){ order[c].push_back( t ); } );
+    });
+  for( auto c = callers.begin(); c != callers.end(); ++c )
+    c->join();
+  for( size_t c = 0; c < order.size(); ++c )
+  {
+    BOOST_REQUIRE( order[c].size() == 100 * chain.size() );
+    for( size_t i = 0; i < order[c].size(); ++i )
+      BOOST_CHECK( order[c][i] == i % chain.size() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( slices )
+{
+  const LogicEngine::backend_t backends[] = { LogicEngine::VIRTUAL, LogicEngine::BYTECODE };
+  for( auto backend = std::begin( backends ); backend != std::end( backends ); ++backend )
+  {
+    LogicEngine le(200,999);
+    raw_offset_t totCnt = setupMandelbrot( le );
+    le.setBackend( *backend );
+    le.setBudget( 10000 );
+    
+    // the run is continued where the budget was used up
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    int slices = 1;
+    while( !le.scheduleRun() )
+    {
+      BOOST_CHECK( le.isSuspended() );
+      BOOST_CHECK( le.getState() == LogicEngine::RUNNING );
+      ++slices;
+    }
+    BOOST_CHECK( 10 < slices );
+    BOOST_CHECK( !le.isSuspended() );
+    BOOST_CHECK( le.getState() == LogicEngine::STOPPED );
+    BOOST_CHECK( le.read<int>( totCnt ) == 15459 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( yield )
+{
+  boost::asio::io_service io_service;
+  std::vector<LogicEngine*> order;
+  RunQueue queue( io_service, [&order]( LogicEngine* le ){ order.push_back( le ); } );
+  
+  // a logic that used up its budget is handed to the queue
+  LogicEngine le(200,999);
+  setupMandelbrot( le );
+  le.setBudget( 10000 );
+  le.setPriority( 1 );
+  le.setYieldHandler( [&queue]( LogicEngine* le ){ queue.yield( le ); } );
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  BOOST_CHECK( !le.scheduleRun() );
+  BOOST_CHECK( le.isSuspended() );
+  BOOST_CHECK( queue.size() == 1 );
+  
+  // and continued by priority, the same priority in turn
+  LogicEngine low(20,99), high(20,99), other(20,99);
+  low.setPriority( 0 );
+  high.setPriority( 5 );
+  other.setPriority( 1 );
+  queue.yield( &low );
+  queue.yield( &high );
+  queue.yield( &other );
+  io_service.run();
+  BOOST_REQUIRE( order.size() == 4 );
+  BOOST_CHECK( order[0] == &high );
+  BOOST_CHECK( order[1] == &le );
+  BOOST_CHECK( order[2] == &other );
+  BOOST_CHECK( order[3] == &low );
+  BOOST_CHECK( queue.size() == 0 );
+  
+  while( !le.scheduleRun() )
+    ;
+  BOOST_CHECK( !le.isSuspended() );
+}
+
+BOOST_AUTO_TEST_CASE( await )
+{
+  const LogicEngine::backend_t backends[] = { LogicEngine::VIRTUAL, LogicEngine::BYTECODE };
+  for( auto backend = std::begin( backends ); backend != std::end( backends ); ++backend )
+  {
+    LogicEngine le(20,99);
+    raw_offset_t delay = le.registerVariable<int>( "delay", 250 );
+    raw_offset_t x     = le.registerVariable<int>( "x" );
+    le.markStartOfLogic();
+    le.addElement( new LogicElement_Const<int>( x, 1 ) );
+    le.addElement( new LogicElement_Sleep( delay ) );
+    le.addElement( new LogicElement_Const<int>( x, 2 ) );
+    le.setBackend( *backend );
+    
+    std::vector<LogicElement_Generic::await_t> waits;
+    le.setAwaitHandler( [&waits]( LogicEngine*, const LogicElement_Generic::await_t& wait ){
+      waits.push_back( wait );
+    });
+    
+    // the run is suspended at the sleep ...
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    BOOST_CHECK( !le.scheduleRun() );
+    BOOST_CHECK( le.read<int>( x ) == 1 );
+    BOOST_REQUIRE( waits.size() == 1 );
+    BOOST_CHECK( waits[0].kind == LogicElement_Generic::await_t::TIMER );
+    BOOST_CHECK( waits[0].delay == std::chrono::milliseconds( 250 ) );
+    
+    // ... and continued behind it
+    BOOST_CHECK( le.scheduleRun() );
+    BOOST_CHECK( le.read<int>( x ) == 2 );
+    BOOST_CHECK( waits.size() == 1 );
+    BOOST_CHECK( le.getState() == LogicEngine::STOPPED );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( awaitreply )
+{
+  boost::asio::io_service io_service;
+  zmq::context_t context( 1 );
+  zmq::socket_t logicd( context, ZMQ_REP );
+  logicd.bind( "ipc:///tmp/GrAFd_test_await.ipc" );
+  std::vector<LogicEngine*> resumed;
+  Awaiter awaiter( io_service, context, "ipc:///tmp/GrAFd_test_await.ipc", [&]( LogicEngine* le ){
+    resumed.push_back( le );
+    io_service.stop();
+  });
+  
+  // without an outbox the send awaits the reply
+  LogicEngine le(20,99);
+  raw_offset_t x = le.registerVariable<float>( "x", 1.5f );
+  raw_offset_t y = le.registerVariable<int>( "y", 0 );
+  le.markStartOfLogic();
+  le.addElement( new LogicElement_Send<float>( x, "test:out", &le ) );
+  le.addElement( new LogicElement_Const<int>( y, 2 ) );
+  le.setAwaitHandler( [&awaiter]( LogicEngine* le, const LogicElement_Generic::await_t& wait ){
+    awaiter.await( le, wait );
+  });
+  
+  // the run is suspended at the send ...
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  BOOST_CHECK( !le.scheduleRun() );
+  BOOST_CHECK( le.read<int>( y ) == 0 );
+  
+  // ... the message is sent by the awaiter ...
+  io_service.poll();
+  LogicMessage msg = recieveMessage( logicd );
+  BOOST_CHECK( msg.getDestination() == "test:out" );
+  BOOST_CHECK( msg.getVariable().getFloat() == 1.5f );
+  BOOST_CHECK( resumed.empty() );
+  
+  // ... and the logic is continued after the reply
+  LogicMessage( "DONE" ).send( logicd );
+  io_service.reset();
+  io_service.run();
+  BOOST_REQUIRE( resumed.size() == 1 );
+  BOOST_CHECK( resumed[0] == &le );
+  BOOST_CHECK( le.scheduleRun() );
+  BOOST_CHECK( le.read<int>( y ) == 2 );
+}
+
+BOOST_AUTO_TEST_CASE( sendchanged )
+{
+  zmq::context_t context( 1 );
+  Outbox outbox( context, "ipc:///tmp/GrAFd_test.ipc" );
+  
+  LogicEngine le(20,99);
+  raw_offset_t in       = le.registerVariable<float>( "in" );
+  raw_offset_t last     = le.registerVariable<float>( "last" );
+  raw_offset_t age      = le.registerVariable<float>( "age" );
+  raw_offset_t valid    = le.registerVariable<bool> ( "valid" );
+  raw_offset_t step     = le.registerVariable<float>( "step", 1.0f );
+  raw_offset_t deadband = le.registerVariable<float>( "deadband", 0.5f );
+  raw_offset_t maxAge   = le.registerVariable<float>( "maxAge", 3.0f );
+  le.markStartOfLogic();
+  le.addElement( new LogicElement_SendChanged<float>( in, last, age, valid, step, deadband, LogicElement_Generic::ground, 
+                                                       LogicElement_Generic::ground, maxAge, "test:out", &le ) );
+  le.setOutbox( &outbox );
+  
+  // the first value, two small changes, the heartbeat and a big change
+  const float values[] = { 1.0f, 1.2f, 1.4f, 1.4f, 2.0f };
+  for( auto value = std::begin( values ); value != std::end( values ); ++value )
+  {
+    le.write( in, *value );
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    BOOST_CHECK( le.scheduleRun() );
+  }
+  BOOST_CHECK( le.read<float>( last ) == 2.0f );
+  BOOST_CHECK( le.read<float>( age ) == 0.0f );
+  
+  // each run with a message is one request
+  for( int i = 0; i < 100 && outbox.sent() < 3; ++i )
+    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+  BOOST_CHECK( outbox.sent() == 3 );
+}
+
+BOOST_AUTO_TEST_CASE( checkpoint )
+{
+  const std::string file = "/tmp/GrAFd_test.checkpoint";
+  std::remove( file.c_str() );
+  
+  raw_offset_t integral = 0, count = 0, gain = 0;
+  auto setup = [&integral, &count, &gain]( LogicEngine& le, bool extra, float gainValue )
+  {
+    if( extra )
+    {
+      le.registerVariable<bool>( "extra", false );
+      le.markState( "extra" );
+    }
+    gain     = le.registerVariable<float>( "gain", gainValue ); // a parameter
+    integral = le.registerVariable<float>( "integral" );
+    count    = le.registerVariable<int>  ( "count" );
+    le.markState( "integral" );
+    le.markState( "count" );
+    le.markStartOfLogic();
+  };
+  
+  // save the state after a run ...
+  {
+    LogicEngine le(20,99);
+    setup( le, false, 1.0f );
+    Checkpoint checkpoint( file, le.stateKey(), le.stateSize() );
+    le.setCheckpoint( &checkpoint, 0.0f );
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    le.write( integral, 12.5f );
+    le.write( count, 42 );
+    BOOST_CHECK( le.scheduleRun() );
+  } // ... the destructor waits till it's written
+  
+  // restore it to the same state, an edited parameter keeps its new value
+  {
+    LogicEngine le(20,99);
+    setup( le, false, 2.0f );
+    Checkpoint checkpoint( file, le.stateKey(), le.stateSize() );
+    le.setCheckpoint( &checkpoint, 0.0f );
+    BOOST_REQUIRE( le.enableVariables() );
+    BOOST_CHECK( le.restoreCheckpoint() );
+    BOOST_CHECK( le.read<float>( integral ) == 12.5f );
+    BOOST_CHECK( le.read<int>( count ) == 42 );
+    BOOST_CHECK( le.read<float>( gain ) == 2.0f );
+  }
+  
+  // but not to a changed one
+  {
+    LogicEngine le(20,99);
+    setup( le, true, 1.0f );
+    Checkpoint checkpoint( file, le.stateKey(), le.stateSize() );
+    le.setCheckpoint( &checkpoint, 0.0f );
+    BOOST_REQUIRE( le.enableVariables() );
+    BOOST_CHECK( !le.restoreCheckpoint() );
+    BOOST_CHECK( le.read<float>( integral ) == 0.0f );
+  }
+  std::remove( file.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( snapshot )
+{
+  LogicEngine le(20,99);
+  raw_offset_t one = le.registerVariable<float>( "one", 1.0f );
+  raw_offset_t x   = le.registerVariable<float>( "x" );
+  le.registerVariable<bool>( "flag", true );
+  le.markStartOfLogic();
+  le.addElement( new LogicElement_Sum<float>( x, x, one ) );
+  
+  Snapshot snapshot( le.layoutKey(), le.variablesSize(), le.snapshotTable() );
+  std::map<std::string, variable_t> values;
+  BOOST_CHECK( !le.takeSnapshot( values ) );
+  le.setSnapshot( &snapshot );
+  
+  // the values of the last finished run
+  for( int run = 0; run < 3; ++run )
+  {
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    BOOST_CHECK( le.scheduleRun() );
+  }
+  BOOST_REQUIRE( le.takeSnapshot( values ) );
+  BOOST_CHECK( values.at( "x" ).getFloat() == 3.0f );
+  BOOST_CHECK( values.at( "flag" ).getBool() );
+  BOOST_CHECK( 0 == values.count( "ground" ) );
+  
+  // a reader only sees complete runs
+  le.write( x, 10.0f );
+  BOOST_REQUIRE( le.takeSnapshot( values ) );
+  BOOST_CHECK( values.at( "x" ).getFloat() == 3.0f );
+  
+  // another process finds the variables by the table in the segment
+  const std::string name = "/GrAFd.test" + std::to_string( getpid() );
+  Snapshot exported( le.layoutKey(), le.variablesSize(), le.snapshotTable(), name );
+  le.setSnapshot( &exported );
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+  BOOST_CHECK( le.scheduleRun() );
+  
+  const int segment = shm_open( name.c_str(), O_RDONLY, 0 );
+  BOOST_REQUIRE( -1 != segment );
+  struct stat status;
+  BOOST_REQUIRE( 0 == fstat( segment, &status ) );
+  void* memory = mmap( nullptr, status.st_size, PROT_READ, MAP_SHARED, segment, 0 );
+  close( segment );
+  BOOST_REQUIRE( MAP_FAILED != memory );
+  const raw_t* const base = static_cast<const raw_t*>( memory );
+  const Snapshot::header_t* const header = static_cast<const Snapshot::header_t*>( memory );
+  const Snapshot::entry_t* const entries = reinterpret_cast<const Snapshot::entry_t*>( base + sizeof( Snapshot::header_t ) );
+  BOOST_CHECK( header->entries == le.snapshotTable().size() );
+  BOOST_CHECK( header->layout == le.layoutKey() );
+  size_t found = 0;
+  for( size_t i = 0; i < header->entries; ++i )
+  {
+    if( std::string( reinterpret_cast<const char*>( base + entries[i].name ) ) != "x" )
+      continue;
+    BOOST_CHECK( entries[i].type == variableType::FLOAT );
+    BOOST_CHECK( *reinterpret_cast<const float*>( base + header->data + entries[i].offset ) == 11.0f );
+    ++found;
+  }
+  BOOST_CHECK( 1 == found );
+  munmap( memory, status.st_size );
+  le.setSnapshot( nullptr );
+}
+
+BOOST_AUTO_TEST_CASE( adopt )
+{
+  LogicEngine old(20,99);
+  raw_offset_t integral = old.registerVariable<float>( "block/integral", 4.5f );
+  old.registerVariable<int>  ( "block/count", 7 );
+  old.registerVariable<float>( "block/gain", 1.0f );
+  old.registerVariable<float>( "removed", 1.0f );
+  old.markState( "block/integral" );
+  old.markState( "block/count" );
+  old.markStartOfLogic();
+  BOOST_REQUIRE( old.enableVariables() );
+  
+  // the new version has another layout, changed a type and a parameter
+  LogicEngine fresh(20,99);
+  raw_offset_t added     = fresh.registerVariable<float>( "added", 2.0f );
+  raw_offset_t count     = fresh.registerVariable<float>( "block/count" );
+  raw_offset_t gain      = fresh.registerVariable<float>( "block/gain", 3.0f );
+  raw_offset_t adopted   = fresh.registerVariable<float>( "block/integral" );
+  fresh.markState( "block/integral" );
+  fresh.markState( "block/count" );
+  fresh.markStartOfLogic();
+  BOOST_REQUIRE( fresh.enableVariables() );
+  
+  BOOST_CHECK( integral != adopted );
+  BOOST_CHECK( fresh.adoptVariables( old ) == 1 );
+  BOOST_CHECK( fresh.read<float>( adopted ) == 4.5f );
+  BOOST_CHECK( fresh.read<float>( count ) == 0.0f );
+  BOOST_CHECK( fresh.read<float>( gain ) == 3.0f );
+  BOOST_CHECK( fresh.read<float>( added ) == 2.0f );
+}
+
+BOOST_AUTO_TEST_CASE( resubscribe )
+{
+  LogicEngine old(20,99);
+  old.importVariable<float>( "reload:in" );
+  old.markStartOfLogic();
+  old.subscribeImports();
+  
+  // the new version has got another import, it replaces the old one
+  LogicEngine fresh(20,99);
+  raw_offset_t in = fresh.importVariable<float>( "reload:in" );
+  fresh.importVariable<int>( "reload:added" );
+  raw_offset_t x  = fresh.registerVariable<float>( "x", 0.0f );
+  fresh.markStartOfLogic();
+  fresh.addElement( new LogicElement_Move<float>( x, in ) );
+  registry.unsubscribe( &old );
+  fresh.subscribeImports();
+  fresh.subscribeImports(); // only once
+  
+  // a message reaches the new logic only, like main() it runs the subscribers
+  auto message = registry.update( "reload:in", variable_t( 3.5f ) );
+  BOOST_REQUIRE( registry.is_valid( message ) );
+  BOOST_REQUIRE( message->second.subscribers.size() == 1 );
+  BOOST_CHECK( message->second.subscribers[0].first == &fresh );
+  for( auto script = message->second.subscribers.cbegin(); script != message->second.subscribers.cend(); ++script )
+  {
+    BOOST_REQUIRE( script->first->enableVariables() && script->first->startLogic() );
+    BOOST_CHECK( script->first->scheduleRun( message->second.timestamp ) );
+  }
+  BOOST_CHECK( fresh.read<float>( x ) == 3.5f );
+  
+  message = registry.update( "reload:added", variable_t( 1 ) );
+  BOOST_REQUIRE( message->second.subscribers.size() == 1 );
+  BOOST_CHECK( message->second.subscribers[0].first == &fresh );
+  registry.unsubscribe( &fresh );
+}
+
+BOOST_AUTO_TEST_CASE( profile )
+{
+  LogicEngine le(20,99);
+  raw_offset_t one = le.registerVariable<float>( "one", 1.0f );
+  raw_offset_t x   = le.registerVariable<float>( "x" );
+  raw_offset_t y   = le.registerVariable<float>( "y" );
+  le.markStartOfLogic();
+  le.markStartOfBlock( "a" );
+  le.addElement( new LogicElement_Sum<float>( x, x, one ) );
+  le.markStartOfBlock( "b" );
+  le.addElement( new LogicElement_Sum<float>( y, y, x ) );
+  le.addElement( new LogicElement_Sum<float>( y, y, one ) );
+  le.setBackend( LogicEngine::BYTECODE );
+  le.setProfiling( true );
+  
+  for( int run = 0; run < 3; ++run )
+  {
+    BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
+    BOOST_CHECK( le.scheduleRun() );
+  }
+  BOOST_CHECK( le.read<float>( y ) == 9.0f );
+  
+  std::vector<LogicEngine::profile_t> elements;
+  std::map<std::string, LogicEngine::profile_t> perBlock;
+  le.getProfile( elements, perBlock );
+  BOOST_REQUIRE( elements.size() == 3 );
+  BOOST_CHECK( elements[1].count == 3 );
+  BOOST_CHECK( perBlock.at( "a" ).count == 3 );
+  BOOST_CHECK( perBlock.at( "b" ).count == 6 );
+  BOOST_CHECK( perBlock.at( "b" ).cycles >= elements[1].cycles );
+}
+
+BOOST_AUTO_TEST_CASE( cache )
+{
+  const std::string path = "/tmp";
+  const uint64_t key = GraphCache::key( "{}", 0 );
+  std::remove( GraphCache::fileName( path, key ).c_str() );
+  BOOST_CHECK( !GraphCache( path, key ).valid() );
+  
+  LogicEngine le(20,99);
+  raw_offset_t in    = le.importVariable<float>( "in" );
+  raw_offset_t tenth = le.registerVariable<float>( "tenth" );
+  raw_offset_t x     = le.registerVariable<float>( "x", 2.0f );
+  raw_offset_t y     = le.registerVariable<float>( "y" );
+  le.markState( "x" );
+  le.addElement( new LogicElement_Const<float>( tenth, 0.1f ) );
+  le.markStartOfLogic();
+  le.markStartOfGroup( 0.05f );
+  le.markStartOfBlock( "sum" );
+  le.addElement( new LogicElement_Sum<float>( x, x, tenth ) );
+  le.markStartOfGroup( 1.0f );
+  le.markStartOfBlock( "mul" );
+  le.addElement( new LogicElement_Mul<float>( y, x, in ) );
+  
+  GraphCache::Writer out;
+  BOOST_REQUIRE( le.exportCompiled( out ) );
+  BOOST_REQUIRE( GraphCache::store( path, key, out ) );
+  
+  // the same logic comes back, with the exact constants
+  GraphCache cache( path, key );
+  BOOST_REQUIRE( cache.valid() );
+  GraphCache::Reader reader = cache.reader();
+  LogicEngine loaded( reader, 98 );
+  BOOST_CHECK( loaded.export_noGrAF() == le.export_noGrAF() );
+  BOOST_CHECK( loaded.layoutKey() == le.layoutKey() );
+  BOOST_CHECK( loaded.stateKey() == le.stateKey() );
+  BOOST_CHECK( loaded.stateSize() == sizeof( float ) );
+  BOOST_CHECK( loaded.groupCount() == 2 );
+  
+  for( LogicEngine* engine : { &le, &loaded } )
+  {
+    BOOST_REQUIRE( engine->enableVariables() && engine->startLogic() );
+    engine->run_init();
+    BOOST_REQUIRE( engine->stopLogic() );
+    engine->scheduleGroup( 0 );
+    engine->scheduleGroup( 1 );
+    BOOST_REQUIRE( engine->enableVariables() && engine->startLogic() );
+    BOOST_CHECK( engine->scheduleRun() );
+  }
+  BOOST_CHECK( loaded.read<float>( tenth ) == 0.1f );
+  BOOST_CHECK( loaded.read<float>( x ) == le.read<float>( x ) );
+  BOOST_CHECK( loaded.read<float>( x ) == 2.1f );
+  BOOST_CHECK( loaded.read<float>( y ) == le.read<float>( y ) );
+  
+  // a broken file isn't used
+  GraphCache::Reader truncated( nullptr, nullptr );
+  BOOST_CHECK_THROW( LogicEngine( truncated, 97 ), JSON::parseError );
+  std::remove( GraphCache::fileName( path, key ).c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( libindex )
+{
+  const std::string path = "/tmp/GrAFd_test_lib";
+  const std::string file = path + "/test.graflib";
+  const std::string cache = "/tmp";
+  const std::string indexFile = GraphLibIndex::indexFile( path, cache );
+  mkdir( path.c_str(), 0755 );
+  std::remove( indexFile.c_str() );
+  std::ofstream( file ) << "{ \"lib\": { \"one\": { \"width\": 1 }, \"two\": { \"width\": 2 } } }";
+  
+  // only the places are indexed, the Blocks are read when they are used
+  GraphLibIndex index;
+  BOOST_REQUIRE( index.addPath( path, cache ) );
+  BOOST_CHECK( index.has( "lib/one" ) && index.has( "lib/two" ) );
+  std::string content;
+  std::vector<std::string> changed;
+  index.read( "lib/two", content, changed );
+  BOOST_CHECK( content == "{ \"width\": 2 }" );
+  BOOST_CHECK( changed.empty() );
+  // the index is kept in the cache directory, not in the library
+  BOOST_CHECK( 0 == access( indexFile.c_str(), R_OK ) );
+  BOOST_CHECK( 0 == indexFile.find( cache + "/grafd_index_" ) );
+  
+  // the index of the unchanged file is taken from the cache
+  {
+    GraphLibIndex cached;
+    BOOST_REQUIRE( cached.addPath( path, cache ) );
+    BOOST_CHECK( cached.key() == index.key() );
+    cached.read( "lib/one", content, changed );
+    BOOST_CHECK( content == "{ \"width\": 1 }" );
+  }
+  
+  // a changed file is indexed again before a Block is read
+  const uint64_t oldKey = index.key();
+  std::ofstream( file ) << "{ \"lib\": { \"two\": { \"width\": 22 }, \"three\": { \"width\": 3 } } }";
+  index.read( "lib/two", content, changed );
+  BOOST_CHECK( content == "{ \"width\": 22 }" );
+  BOOST_CHECK( 1 == std::count( changed.begin(), changed.end(), "lib/one" ) );
+  BOOST_CHECK( index.key() != oldKey );
+  BOOST_CHECK( !index.has( "lib/one" ) && index.has( "lib/three" ) );
+  BOOST_CHECK_THROW( index.read( "lib/one", content, changed ), JSON::parseError );
+  
+  // and the cached index of it isn't used anymore
+  {
+    GraphLibIndex cached;
+    BOOST_REQUIRE( cached.addPath( path, cache ) );
+    BOOST_CHECK( cached.key() == index.key() );
+    BOOST_CHECK( !cached.has( "lib/one" ) );
+    cached.read( "lib/three", content, changed );
+    BOOST_CHECK( content == "{ \"width\": 3 }" );
+  }
+  
+  std::remove( indexFile.c_str() );
+  std::remove( file.c_str() );
+  rmdir( path.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( program )
+{
+  const std::string src = "var float out\n"
+                          "// scaled input\n"
+                          "const<float>( out, 0.5 )\n"
+                          "mul<float>( out, out, in )\n";
+  const LogicEngine::program_t program = LogicEngine::parse_noGrAF( src );
+  BOOST_CHECK( program.instructions == 2 );
+  BOOST_CHECK( program.instructions == LogicEngine::instructionsCount( src ) );
+  BOOST_CHECK( program.statements.size() == 3 );
+  // each variable is bound only once, a number is already an offset
+  BOOST_CHECK( program.symbols.size() == 2 );
+  const LogicEngine::program_t jump = LogicEngine::parse_noGrAF( "jumptrue<bool>( -3, out )" );
+  BOOST_CHECK( jump.statements.front().operands.front().kind == LogicEngine::program_t::ADDRESS );
+  BOOST_CHECK( jump.statements.front().operands.front().offset == -3 );
+  
+  // importing the parsed program twice is the same as importing the text
+  LogicEngine parsed(20,99), text(20,98);
+  const LogicEngine::translation_t a { { "a/in", "source" } }, b { { "b/in", "a/out" } };
+  for( LogicEngine* le : { &parsed, &text } )
+    le->registerVariable<float>( "source", 3.0f );
+  parsed.import_noGrAF( program, true, "a/", a );
+  parsed.import_noGrAF( program, true, "b/", b );
+  std::stringstream inA( src ), inB( src );
+  text.import_noGrAF( inA, true, "a/", a );
+  text.import_noGrAF( inB, true, "b/", b );
+  BOOST_CHECK( parsed.export_noGrAF() == text.export_noGrAF() );
+  BOOST_CHECK( parsed.layoutKey() == text.layoutKey() );
+  
+  // a variable that isn't connected is only found when it's bound
+  LogicEngine unbound(20,97);
+  BOOST_CHECK_THROW( unbound.import_noGrAF( program, true, "c/", a ), JSON::parseError );
+  
+  BOOST_CHECK_THROW( LogicEngine::parse_noGrAF( "mul<float>( out, in )" ), JSON::parseError );
+  BOOST_CHECK_THROW( LogicEngine::parse_noGrAF( "mul<float>( out, in, in, in )" ), JSON::parseError );
+  BOOST_CHECK_THROW( LogicEngine::parse_noGrAF( "unknown<float>( out )" ), JSON::parseError );
+}
+
+BOOST_AUTO_TEST_CASE( json )
+{
+  const std::string src = "{ // a comment\n"
+                          "  \"a\": [ 1, -2.5e1, true ],\n"
+                          "  /* another one */ \"b\": \"x\\\"y\",\n"
+                          "  \"c\": { }\n"
+                          "}";
+  JSON::buffer in( src );
+  std::vector<std::string> keys;
+  std::vector<double> numbers;
+  std::string text;
+  JSON::readJsonObject( in, [&]( JSON::buffer& in1, const JSON::stringRef& key ){
+    keys.push_back( key.str() );
+    if( "a" == key )
+      JSON::readJsonArray( in1, [&]( JSON::buffer& in2 ){
+        if( JSON::BOOL == JSON::identifyNext( in2 ) )
+          BOOST_CHECK( JSON::readJsonBool( in2 ) );
+        else
+          numbers.push_back( JSON::readJsonNumber( in2 ) );
+      });
+    else if( "b" == key )
+      text = JSON::readJsonString( in1 );
+    else
+      JSON::readJsonObject( in1, []( JSON::buffer&, const JSON::stringRef& ){ BOOST_ERROR( "empty object" ); } );
+  });
+  BOOST_CHECK( keys == std::vector<std::string>( { "a", "b", "c" } ) );
+  BOOST_CHECK( numbers == std::vector<double>( { 1.0, -25.0 } ) );
+  BOOST_CHECK( text == "x\"y" );
+  BOOST_CHECK( in.pos == in.end );
+  
+  // the position of an error is only found when it's shown
+  const std::string brokenSrc = "{ \"a\": [ 1,\n  true ] }";
+  JSON::buffer broken( brokenSrc );
+  try
+  {
+    JSON::readJsonObject( broken, []( JSON::buffer& in1, const JSON::stringRef& ){
+      JSON::readJsonArray( in1, []( JSON::buffer& in2 ){ JSON::readJsonNumber( in2 ); } );
+    });
+    BOOST_ERROR( "parseError expected" );
+  }
+  catch( JSON::parseError e )
+  {
+    int lineNo, errorPos;
+    BOOST_CHECK( e.getErrorLine( lineNo, errorPos ) == "  true ] }" );
+    BOOST_CHECK( lineNo == 2 );
+    BOOST_CHECK( errorPos == 2 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( nativekey )
+{
+  // constants that only differ behind the sixth digit are different logics
+  const LogicEngine::translation_t none;
+  LogicEngine a(20,96), b(20,95);
+  std::stringstream srcA( "var float x\nconst<float>( x, 1.0000001 )\n" ), srcB( "var float x\nconst<float>( x, 1.0000002 )\n" );
+  a.import_noGrAF( srcA, true, "", none );
+  b.import_noGrAF( srcB, true, "", none );
+  BOOST_CHECK( a.export_noGrAF() == b.export_noGrAF() );
+  BOOST_CHECK( a.nativeKey() != b.nativeKey() );
+}
+
+BOOST_AUTO_TEST_CASE( native )
+{
+  // compiled like graf2cpp does, so this needs a compiler at runtime
+  const char* env = getenv( "CXX" );
+  const std::string cxx = nullptr == env ? "c++" : env;
+  if( 0 != system( ( cxx + " --version > /dev/null 2>&1" ).c_str() ) )
+  {
+    BOOST_TEST_MESSAGE( "no compiler '" << cxx << "' available, skipping the native round trip" );
+    return;
+  }
+  
+  int bytecode;
+  runMandelbrot( LogicEngine::BYTECODE, 1, bytecode, true );
+  
+  LogicEngine le(200,999);
+  raw_offset_t totCnt = setupMandelbrot( le );
+  Optimizer optimizer( le );
+  optimizer.fuse();
+  
+  const std::string base = "/tmp/" + NativeCode::fileName( le.nativeKey() );
+  std::remove( ( base + ".so" ).c_str() );
+  BOOST_CHECK( !le.loadNative( "/tmp" ) );
+  {
+    std::ofstream out( base + ".cpp" );
+    le.exportNative( out );
+  }
+  BOOST_REQUIRE( 0 == system( ( cxx + " -O2 -shared -fPIC -o '" + base + ".so' '" + base + ".cpp'" ).c_str() ) );
+  BOOST_REQUIRE( le.loadNative( "/tmp" ) );
+  BOOST_CHECK( le.getBackend() == LogicEngine::NATIVE );
+  
+  BOOST_REQUIRE( le.enableVariables() && le.startLogic() );
   le.run();
+  BOOST_CHECK( le.read<int>( totCnt ) == bytecode );
+  BOOST_CHECK( le.read<int>( totCnt ) == 15459 );
   
-  std::cout << le.readString<int  >(totCnt) << std::endl;
-  BOOST_CHECK( le.read<int>(totCnt) == 15459 );
+  std::remove( ( base + ".cpp" ).c_str() );
+  std::remove( ( base + ".so"  ).c_str() );
 }
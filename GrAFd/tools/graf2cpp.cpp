@@ -0,0 +1,136 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "globals.h"
+
+#include "graph.hpp"
+#include "graphlib.hpp"
+#include "logicengine.hpp"
+#include "messageregister.hpp"
+#include "json.hpp"
+
+using namespace std;
+
+Logger logger;
+MessageRegister registry;
+zmq::socket_t *sender;
+graphs_t graphs;
+Worker* worker;
+
+void showHelp( void )
+{
+  cout << "Usage: graf2cpp [options] file.graf...\n"
+  "\n"
+  "Compile graphs ahead of time for the native backend of GrAFd.\n"
+  "For each graph the file grafd_<key>.cpp is written, where the key is\n"
+  "the hash of the graph compiled with the current library.\n"
+  "\n"
+  "Parameters:\n"
+  "    -h, --help           This help message\n"
+  "    -L DIR               Add DIR to the library path (default: ../lib/)\n"
+  "    -o DIR               Write the files to DIR (default: .)\n"
+  "    -c, --compile        Compile the shared object with $CXX (default: c++)" << endl;
+}
+
+int main( int argc, const char *argv[] )
+{
+  vector<string> libPaths;
+  vector<string> grafFiles;
+  string outPath = ".";
+  bool compile = false;
+  
+  for( int i = 1; i < argc; ++i )
+  {
+    string parameter( argv[ i ] );
+    
+    if     ( parameter == "-h" || parameter == "--help"    )
+    {
+      showHelp();
+      return 0;
+    }
+    else if( parameter == "-c" || parameter == "--compile" )
+      compile = true;
+    else if( parameter == "-L" && i + 1 < argc )
+      libPaths.push_back( argv[ ++i ] );
+    else if( parameter == "-o" && i + 1 < argc )
+      outPath = argv[ ++i ];
+    else
+      grafFiles.push_back( parameter );
+  }
+  
+  if( grafFiles.empty() )
+  {
+    showHelp();
+    return 1;
+  }
+  
+  if( libPaths.empty() )
+    libPaths.push_back( "../lib/" );
+  for( auto path = libPaths.cbegin(); path != libPaths.cend(); ++path )
+    Graph::lib.addPath( *path );
+  
+  const char* cxx = getenv( "CXX" );
+  int result = 0;
+  for( auto file = grafFiles.cbegin(); file != grafFiles.cend(); ++file )
+  {
+    try {
+      ifstream in( *file );
+      if( !in )
+      {
+        cerr << "Can't open '" << *file << "'" << endl;
+        result = 1;
+        continue;
+      }
+      
+      Graph graph( in );
+      const string base = outPath + "/" + NativeCode::fileName( graph.le->nativeKey() );
+      {
+        ofstream out( base + ".cpp" );
+        graph.le->exportNative( out );
+      }
+      cout << *file << " -> " << base << ".cpp" << endl;
+      
+      if( compile )
+      {
+        const string command = string( nullptr == cxx ? "c++" : cxx ) 
+          + " -O2 -shared -fPIC -o '" + base + ".so' '" + base + ".cpp'";
+        if( 0 != system( command.c_str() ) )
+        {
+          cerr << "Compilation failed: " << command << endl;
+          result = 1;
+        }
+      }
+    }
+    catch( JSON::parseError e )
+    {
+      int lineNo, errorPos;
+      e.getErrorLine( lineNo, errorPos );
+      cerr << *file << ": error \"" << e.text << "\" in line " << lineNo << " at postion " << errorPos 
+           << " (" << e.sourceFile << ":" << e.sourceLineNo << ")" << endl;
+      result = 1;
+    }
+  }
+  
+  return result;
+}
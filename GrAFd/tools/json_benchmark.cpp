@@ -0,0 +1,204 @@
+/*
+ * The Graphic Automation Framework deamon
+ * Copyright (C) 2012, 2013  Christian Mayer - mail (at) ChristianMayer (dot) de
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <chrono>
+#include <cstdlib>
+
+#include "logger.hpp"
+#include "json.hpp"
+
+using namespace std;
+
+Logger logger;
+
+void showHelp( void )
+{
+  cout << "Usage: json_benchmark [options] file...\n"
+  "\n"
+  "Compare the time to parse JSON files, e.g. large graphs or libraries,\n"
+  "with the std::istream and the JSON::buffer functions.\n"
+  "\n"
+  "Parameters:\n"
+  "    -h, --help           This help message\n"
+  "    -n COUNT             Parse each file COUNT times (default: 100)" << endl;
+}
+
+/**
+ * Walk the next value in @p in and return the number of values in it.
+ */
+size_t walk( istream& in )
+{
+  size_t count = 1;
+  in >> JSON::consumeEmpty;
+  switch( JSON::identifyNext( in ) )
+  {
+    case JSON::BOOL:
+      JSON::readJsonBool( in );
+      break;
+      
+    case JSON::NUMBER:
+      {
+        double number;
+        in >> number;
+      }
+      break;
+      
+    case JSON::STRING:
+      JSON::readJsonString( in );
+      break;
+      
+    case JSON::ARRAY:
+      JSON::readJsonArray( in, [&count]( istream& in1 ){
+        count += walk( in1 );
+      });
+      break;
+      
+    case JSON::OBJECT:
+      JSON::readJsonObject( in, [&count]( istream& in1, const string& ){
+        count += walk( in1 );
+      });
+      break;
+      
+    default:
+      throw( JSON::parseError( "Unknown value", in, __LINE__ ,__FILE__ ) );
+  }
+  return count;
+}
+
+/**
+ * Walk the next value in @p in and return the number of values in it.
+ */
+size_t walk( JSON::buffer& in )
+{
+  size_t count = 1;
+  in >> JSON::consumeEmpty;
+  switch( JSON::identifyNext( in ) )
+  {
+    case JSON::BOOL:
+      JSON::readJsonBool( in );
+      break;
+      
+    case JSON::NUMBER:
+      JSON::readJsonNumber( in );
+      break;
+      
+    case JSON::STRING:
+      JSON::readJsonStringRef( in );
+      break;
+      
+    case JSON::ARRAY:
+      JSON::readJsonArray( in, [&count]( JSON::buffer& in1 ){
+        count += walk( in1 );
+      });
+      break;
+      
+    case JSON::OBJECT:
+      JSON::readJsonObject( in, [&count]( JSON::buffer& in1, const JSON::stringRef& ){
+        count += walk( in1 );
+      });
+      break;
+      
+    default:
+      throw( JSON::parseError( "Unknown value", in, __LINE__ ,__FILE__ ) );
+  }
+  return count;
+}
+
+/**
+ * Return the time in ms to call @p parse @p repeat times.
+ */
+template<typename F>
+double measure( int repeat, F parse )
+{
+  const auto start = chrono::steady_clock::now();
+  for( int i = 0; i < repeat; ++i )
+    parse();
+  return chrono::duration<double, milli>( chrono::steady_clock::now() - start ).count();
+}
+
+int main( int argc, const char *argv[] )
+{
+  vector<string> files;
+  int repeat = 100;
+  
+  for( int i = 1; i < argc; ++i )
+  {
+    string parameter( argv[ i ] );
+    
+    if     ( parameter == "-h" || parameter == "--help"    )
+    {
+      showHelp();
+      return 0;
+    }
+    else if( parameter == "-n" && i + 1 < argc )
+      repeat = atoi( argv[ ++i ] );
+    else
+      files.push_back( parameter );
+  }
+  
+  if( files.empty() || 0 >= repeat )
+  {
+    showHelp();
+    return 1;
+  }
+  
+  int result = 0;
+  for( auto file = files.cbegin(); file != files.cend(); ++file )
+  {
+    ifstream in( *file );
+    if( !in )
+    {
+      cerr << "Can't open '" << *file << "'" << endl;
+      result = 1;
+      continue;
+    }
+    const string content( (istreambuf_iterator<char>( in )), istreambuf_iterator<char>() );
+    
+    try {
+      size_t values = 0;
+      const double streamTime = measure( repeat, [&content, &values](){
+        stringstream source( content );
+        values = walk( source );
+      });
+      const double bufferTime = measure( repeat, [&content, &values](){
+        JSON::buffer source( content );
+        values = walk( source );
+      });
+      
+      cout << *file << ": " << content.size() << " bytes, " << values << " values\n"
+           << "  istream: " << streamTime / repeat << " ms\n"
+           << "  buffer:  " << bufferTime / repeat << " ms (x" << streamTime / bufferTime << ")" << endl;
+    }
+    catch( JSON::parseError e )
+    {
+      int lineNo, errorPos;
+      e.getErrorLine( lineNo, errorPos );
+      cerr << *file << ": error \"" << e.text << "\" in line " << lineNo << " at postion " << errorPos 
+           << " (" << e.sourceFile << ":" << e.sourceLineNo << ")" << endl;
+      result = 1;
+    }
+  }
+  
+  return result;
+}
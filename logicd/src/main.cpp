@@ -115,6 +115,28 @@ static void signal_handler( int /*signal_value*/ )
   running = false;
 }
 
+// print the content of a recieved message
+static void printMessage( const LogicMessage_ptr& msg )
+{
+  std::cout << "Received [" << msg->getSource() << " -> " << msg->getDestination() << ";" << msg->getIndex() << "] '" << msg->getType() << "' " << msg->getSize() << std::endl;
+  std::cout << hexdump( msg->getRaw(), msg->getSize() );
+  switch( msg->getType() )
+  {
+    case variableType::INT:
+      std::cout << "INT: " << msg->getInt() << " 0x" << std::hex << msg->getInt() << std::dec << std::endl;
+      break;
+    case variableType::FLOAT:
+      std::cout << "FLOAT: " << msg->getFloat() << std::endl;
+      break;
+    case variableType::STRING:
+      std::cout << "STRING: " << msg->getString() << std::endl;
+      break;
+    default:
+      std::cout << "unknown / default" << std::endl;
+  }
+  std::cout << std::endl;
+}
+
 int main( int /*argc*/, const char */*argv*/[] )
 {
   // catch signals
@@ -137,24 +159,19 @@ int main( int /*argc*/, const char */*argv*/[] )
   
   while( running )
   {
-    LogicMessage_ptr msg( new_recieveMessage( socket ) );
-    std::cout << "Received [" << msg->getSource() << " -> " << msg->getDestination() << ";" << msg->getIndex() << "] '" << msg->getType() << "' " << msg->getSize() << std::endl;
-    std::cout << hexdump( msg->getRaw(), msg->getSize() );
-    switch( msg->getType() )
+    // a request might contain a whole batch of messages, e.g. all messages
+    // that a logic sent during one run
+    std::vector<LogicMessage_ptr> batch( recieveMultiMessage( socket ) );
+    for( size_t i = 0; i < batch.size(); ++i )
+      printMessage( batch[i] );
+    if( batch.empty() )
     {
-      case variableType::INT:
-        std::cout << "INT: " << msg->getInt() << " 0x" << std::hex << msg->getInt() << std::dec << std::endl;
-        break;
-      case variableType::FLOAT:
-        std::cout << "FLOAT: " << msg->getFloat() << std::endl;
-        break;
-      case variableType::STRING:
-        std::cout << "STRING: " << msg->getString() << std::endl;
-        break;
-      default:
-        std::cout << "unknown / default" << std::endl;
+      // a REP socket has to answer each request, even an empty one
+      LogicMessage reply( "DONE" );
+      reply.send( socket );
+      continue;
     }
-    std::cout << std::endl;
+    LogicMessage_ptr msg( batch.front() );
 
     // Send reply back to client
     if( "meta:cacheread" == msg->getDestination() )
@@ -190,11 +207,12 @@ int main( int /*argc*/, const char */*argv*/[] )
       
       continue; // nothing to broadcast...
     } else {
-      LogicMessage reply( "DONE" );
+      LogicMessage reply( "DONE" ); // once for the whole batch
       reply.send( socket );
     }
     
-    msg->send( publisher, mc.insert( msg ) ); // broadcast
+    for( size_t i = 0; i < batch.size(); ++i )
+      batch[i]->send( publisher, mc.insert( batch[i] ) ); // broadcast
     //LogicMessage test( "test", "test" );
     //test.send( publisher );
   }